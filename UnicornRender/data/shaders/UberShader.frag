@@ -3,6 +3,12 @@
 #extension GL_ARB_separate_shader_objects : enable
 #extension GL_ARB_shading_language_420pack : enable
 
+// Shading of the material, matches MaterialShading
+layout(constant_id = 0) const uint shading = 0;
+
+const uint SHADING_DYNAMIC = 0;
+const uint SHADING_COLORED = 1;
+
 layout(set = 1, binding = 0) uniform sampler2D inTextureSampler;
 
 layout(location = 0) in vec2 inTextureCoordinate;
@@ -12,14 +18,27 @@ layout(location = 2) in vec4 inSpriteCoord;
 layout(location = 0) out vec4 outColor;
 
 void main() {
-    if (inColor.w > 0)
+    // Branches on shading are resolved when pipeline is compiled
+    if (shading == SHADING_DYNAMIC)
+    {
+        if (inColor.w > 0)
+        {
+            outColor = vec4(inColor.xyz, 1.0);
+        }
+        else
+        {
+            vec2 spriteUV = inSpriteCoord.xy + (inTextureCoordinate * inSpriteCoord.zw);
+            vec4 texColor = texture(inTextureSampler, spriteUV);
+            outColor = texColor;
+        }
+    }
+    else if (shading == SHADING_COLORED)
     {
         outColor = vec4(inColor.xyz, 1.0);
     }
     else
     {
-        vec2 spriteUV = inSpriteCoord.xy + (inTextureCoordinate * inSpriteCoord.zw);
-        vec4 texColor = texture(inTextureSampler, spriteUV);
-        outColor = texColor;
+        // Sprite area is applied to texture coordinates in vertex shader
+        outColor = texture(inTextureSampler, inTextureCoordinate);
     }
 }
@@ -3,19 +3,37 @@
 #extension GL_ARB_separate_shader_objects : enable
 #extension GL_ARB_shading_language_420pack : enable
 
+// Shading of the material, matches MaterialShading
+layout(constant_id = 0) const uint shading = 0;
+
+const uint SHADING_DYNAMIC = 0;
+const uint SHADING_COLORED = 1;
+const uint SHADING_TEXTURED = 2;
+
 layout(set = 0, binding = 0) uniform UniformViewProjection {
     mat4 view;
     mat4 proj;
 } uvp_buffer;
 
-layout(set = 0, binding = 1) uniform UniformModel {
+struct ObjectData {
     mat4 model;
-} um_buffer;
-
-layout(push_constant) uniform PushConstants {
     vec4 color;
     vec4 spriteCoord;
-} pushConstants;
+    uint textureIndex;
+    uint padding0;
+    uint padding1;
+    uint padding2;
+};
+
+// Per instance data of visible meshes, written by frustum culling
+layout(std430, set = 0, binding = 1) readonly buffer Objects {
+    ObjectData objects[];
+};
+
+// Offset of the draw in objects if indirect draws can't set first instance
+layout(push_constant) uniform DrawParameters {
+    uint instanceOffset;
+} draw_parameters;
 
 layout(location = 0) in vec3 inPos;
 layout(location = 1) in vec2 inTextureCoordinates;
@@ -23,14 +41,38 @@ layout(location = 1) in vec2 inTextureCoordinates;
 layout(location = 0) out vec2 outTextureCoordinates;
 layout(location = 1) out vec4 outColor;
 layout(location = 2) out vec4 outSpriteCoord;
+layout(location = 3) flat out uint outTextureIndex;
 
 out gl_PerVertex {
     vec4 gl_Position;
 };
 
 void main() {
-    gl_Position = uvp_buffer.proj * uvp_buffer.view * um_buffer.model * vec4(inPos, 1.0);
-    outTextureCoordinates = inTextureCoordinates;
-    outColor = pushConstants.color;
-    outSpriteCoord = pushConstants.spriteCoord;
+    ObjectData object = objects[draw_parameters.instanceOffset + gl_InstanceIndex];
+
+    gl_Position = uvp_buffer.proj * uvp_buffer.view * object.model * vec4(inPos, 1.0);
+
+    // Specialized shadings write only varyings their fragment shader reads,
+    // unused ones are removed when pipeline is compiled
+    if (shading == SHADING_DYNAMIC)
+    {
+        outTextureCoordinates = inTextureCoordinates;
+        outColor = object.color;
+        outSpriteCoord = object.spriteCoord;
+    }
+    else if (shading == SHADING_COLORED)
+    {
+        outColor = object.color;
+    }
+    else if (shading == SHADING_TEXTURED)
+    {
+        outTextureCoordinates = inTextureCoordinates;
+    }
+    else
+    {
+        // Sprite area is an affine transform, interpolated result is the same as per fragment one
+        outTextureCoordinates = object.spriteCoord.xy + (inTextureCoordinates * object.spriteCoord.zw);
+    }
+
+    outTextureIndex = object.textureIndex;
 }
@@ -0,0 +1,47 @@
+#version 450
+
+#extension GL_ARB_separate_shader_objects : enable
+#extension GL_ARB_shading_language_420pack : enable
+#extension GL_EXT_nonuniform_qualifier : require
+
+// Shading of the material, matches MaterialShading
+layout(constant_id = 0) const uint shading = 0;
+
+const uint SHADING_DYNAMIC = 0;
+const uint SHADING_COLORED = 1;
+
+// Textures of all materials, indexed by texture index of the instance
+layout(set = 1, binding = 0) uniform sampler2D textures[];
+
+layout(location = 0) in vec2 inTextureCoordinate;
+layout(location = 1) in vec4 inColor;
+layout(location = 2) in vec4 inSpriteCoord;
+layout(location = 3) flat in uint inTextureIndex;
+
+layout(location = 0) out vec4 outColor;
+
+void main() {
+    // Branches on shading are resolved when pipeline is compiled
+    if (shading == SHADING_DYNAMIC)
+    {
+        if (inColor.w > 0)
+        {
+            outColor = vec4(inColor.xyz, 1.0);
+        }
+        else
+        {
+            vec2 spriteUV = inSpriteCoord.xy + (inTextureCoordinate * inSpriteCoord.zw);
+            vec4 texColor = texture(textures[nonuniformEXT(inTextureIndex)], spriteUV);
+            outColor = texColor;
+        }
+    }
+    else if (shading == SHADING_COLORED)
+    {
+        outColor = vec4(inColor.xyz, 1.0);
+    }
+    else
+    {
+        // Sprite area is applied to texture coordinates in vertex shader
+        outColor = texture(textures[nonuniformEXT(inTextureIndex)], inTextureCoordinate);
+    }
+}
@@ -0,0 +1,38 @@
+/*
+* Copyright (C) 2017 by Godlike
+* This code is licensed under the MIT license (MIT)
+* (http://opensource.org/licenses/MIT)
+*/
+
+#ifndef UNICORN_UTILITY_HASH_HPP
+#define UNICORN_UTILITY_HASH_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+namespace unicorn
+{
+namespace utility
+{
+
+//! Hash of empty data, start value of HashBytes()
+static const uint64_t s_emptyHash = 14695981039346656037ull;
+
+/**
+ * @brief Computes 64 bit FNV-1a hash of bytes
+ *
+ * Hash of several ranges is computed by passing hash of the previous
+ * range as @p hash of the next one
+ *
+ * @param[in] pData data to hash
+ * @param[in] size size of data in bytes
+ * @param[in] hash hash of preceding data
+ *
+ * @return hash of preceding data and @p pData
+ */
+uint64_t HashBytes(void const* pData, size_t size, uint64_t hash = s_emptyHash);
+
+}
+}
+
+#endif // UNICORN_UTILITY_HASH_HPP
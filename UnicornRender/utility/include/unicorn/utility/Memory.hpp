@@ -8,6 +8,7 @@
 #define UNICORN_UTILITY_MEMORY_HPP
 
 #include <stdlib.h>
+#include <cstdint>
 
 namespace unicorn
 {
@@ -24,6 +25,13 @@ void* AlignedAlloc(size_t size, size_t alignment);
 *  @param[in] data a pointer to the memory block
 */
 void AlignedFree(void* data);
+
+/** @brief Rounds value up to a multiple of alignment
+ * @param[in] value value to round
+ * @param[in] alignment the alignment value, doesn't have to be a power of 2
+ * @return the least multiple of alignment which is not less than value
+ */
+uint64_t AlignUp(uint64_t value, uint64_t alignment);
 }
 }
 
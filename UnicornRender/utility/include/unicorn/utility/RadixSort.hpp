@@ -0,0 +1,40 @@
+/*
+* Copyright (C) 2017 by Godlike
+* This code is licensed under the MIT license (MIT)
+* (http://opensource.org/licenses/MIT)
+*/
+
+#ifndef UNICORN_UTILITY_RADIX_SORT_HPP
+#define UNICORN_UTILITY_RADIX_SORT_HPP
+
+#include <cstdint>
+#include <vector>
+
+namespace unicorn
+{
+namespace utility
+{
+
+/** @brief Sort key paired with index of the sorted element */
+struct SortItem
+{
+    uint64_t key;
+    uint32_t index;
+};
+
+/**
+ * @brief Sorts items by key in ascending order
+ *
+ * Least significant digit radix sort with 8 bit digits. The sort is stable,
+ * so items with equal keys keep their relative order. Digits which are equal
+ * in all keys are skipped
+ *
+ * @param[in,out] items items to sort
+ * @param[in,out] buffer scratch memory, resized to the size of @p items
+ */
+void RadixSort(std::vector<SortItem>& items, std::vector<SortItem>& buffer);
+
+}
+}
+
+#endif // UNICORN_UTILITY_RADIX_SORT_HPP
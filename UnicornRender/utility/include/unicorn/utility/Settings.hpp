@@ -10,6 +10,7 @@
 #include <mule/templates/Singleton.hpp>
 
 #include <string>
+#include <chrono>
 #include <cstdint>
 
 namespace unicorn
@@ -80,6 +81,155 @@ public:
      */
     void SetProfilingMask(ProfilingMask::MaskType profilingMask) { m_profilingMask = profilingMask; }
 
+    //! Returns amount of frames that may be processed by GPU while CPU prepares the next one
+    uint32_t GetFramesInFlight() const { return m_framesInFlight; }
+
+    /** @brief  Sets amount of frames in flight
+     *
+     *  Takes effect for renderers initialized after the call
+     *
+     *  @param  framesInFlight  new amount of frames in flight, must be greater than zero
+     */
+    void SetFramesInFlight(uint32_t framesInFlight) { m_framesInFlight = framesInFlight; }
+
+    //! Returns amount of threads recording draw commands
+    uint32_t GetRecordingWorkers() const { return m_recordingWorkers; }
+
+    /** @brief  Sets amount of threads recording draw commands
+     *
+     *  Calling thread is counted as one of workers, so @c 1 records
+     *  everything on the render thread. Takes effect from the next frame
+     *
+     *  @param  recordingWorkers    new amount of workers, must be greater than zero
+     */
+    void SetRecordingWorkers(uint32_t recordingWorkers) { m_recordingWorkers = recordingWorkers; }
+
+    //! Returns @c true if recorded draw commands are reused while draw list doesn't change
+    bool IsRecordedDrawsReuse() const { return m_isRecordedDrawsReuse; }
+
+    /** @brief  Sets reuse of recorded draw commands
+     *
+     *  Without reuse draw commands are recorded anew every frame,
+     *  which is meant for measuring recording. Takes effect from the next frame
+     *
+     *  @param  isRecordedDrawsReuse    @c true to reuse recorded draw commands
+     */
+    void SetRecordedDrawsReuse(bool isRecordedDrawsReuse) { m_isRecordedDrawsReuse = isRecordedDrawsReuse; }
+
+    //! Returns @c true if graphics are initialized without window system
+    bool IsHeadless() const { return m_isHeadless; }
+
+    /** @brief  Sets headless mode
+     *
+     *  In headless mode graphics don't require window system support
+     *  and only headless renderers can be spawned. Takes effect
+     *  for graphics initialized after the call
+     *
+     *  @param  isHeadless  @c true to initialize graphics without window system
+     */
+    void SetHeadless(bool isHeadless) { m_isHeadless = isHeadless; }
+
+    //! Returns size of staging ring buffer used for uploads in bytes
+    uint32_t GetStagingBufferSize() const { return m_stagingBufferSize; }
+
+    /** @brief  Sets size of staging ring buffer
+     *
+     *  Uploads which don't fit into the ring get dedicated staging
+     *  buffers. Takes effect for renderers initialized after the call
+     *
+     *  @param  stagingBufferSize   new size in bytes
+     */
+    void SetStagingBufferSize(uint32_t stagingBufferSize) { m_stagingBufferSize = stagingBufferSize; }
+
+    //! Returns @c true if meshes are tested against view frustum on CPU
+    bool IsCpuCulling() const { return m_isCpuCulling; }
+
+    /** @brief  Sets where meshes are tested against view frustum
+     *
+     *  CPU culling tests world bounding spheres of meshes before upload,
+     *  otherwise the test is done in compute pass. Takes effect from the next frame
+     *
+     *  @param  isCpuCulling    @c true to cull on CPU, @c false to cull on GPU
+     */
+    void SetCpuCulling(bool isCpuCulling) { m_isCpuCulling = isCpuCulling; }
+
+    //! Returns @c true if textures of all materials are bound as a single array
+    bool IsBindlessTextures() const { return m_isBindlessTextures; }
+
+    /** @brief  Sets bindless textures mode
+     *
+     *  In bindless mode materials reference textures by index in one
+     *  descriptor array, so draws with different textures share bound state.
+     *  Requires descriptor indexing support, otherwise every material binds
+     *  its own descriptor set. Takes effect for renderers initialized after the call
+     *
+     *  @param  isBindlessTextures  @c true to bind textures as a single array
+     */
+    void SetBindlessTextures(bool isBindlessTextures) { m_isBindlessTextures = isBindlessTextures; }
+
+    //! Returns @c true if materials are drawn with shaders specialized for their shading
+    bool IsShaderSpecialization() const { return m_isShaderSpecialization; }
+
+    /** @brief  Sets shader specialization mode
+     *
+     *  Specialized shaders draw colored, textured and sprite materials
+     *  without per fragment branching at the cost of more pipelines,
+     *  otherwise one shader chooses shading for every fragment.
+     *  Takes effect from the next frame
+     *
+     *  @param  isShaderSpecialization  @c true to specialize shaders per material
+     */
+    void SetShaderSpecialization(bool isShaderSpecialization) { m_isShaderSpecialization = isShaderSpecialization; }
+
+    //! Returns path of pipeline cache file
+    const std::string& GetPipelineCachePath() const { return m_pipelineCachePath; }
+
+    /** @brief  Sets path of pipeline cache file
+     *
+     *  Compiled pipelines are loaded from the file on renderer initialization
+     *  and written back on shutdown. Empty path disables the file.
+     *  Takes effect for renderers initialized after the call
+     *
+     *  @param  path    new path
+     */
+    void SetPipelineCachePath(const std::string& path) { m_pipelineCachePath = path; }
+
+    //! Returns @c true if resolution of rendered scene adapts to GPU frame time
+    bool IsDynamicResolution() const { return m_isDynamicResolution; }
+
+    /** @brief  Sets dynamic resolution mode
+     *
+     *  Scene is rendered into an internal target whose resolution is scaled
+     *  to keep GPU frame time close to the target one, then it is upscaled
+     *  to the output image. Requires GPU timestamps, otherwise scene is
+     *  rendered at output resolution. Takes effect for renderers initialized after the call
+     *
+     *  @param  isDynamicResolution     @c true to scale resolution dynamically
+     */
+    void SetDynamicResolution(bool isDynamicResolution) { m_isDynamicResolution = isDynamicResolution; }
+
+    //! Returns GPU frame time dynamic resolution aims for
+    std::chrono::nanoseconds GetTargetFrameTime() const { return m_targetFrameTime; }
+
+    /** @brief  Sets GPU frame time dynamic resolution aims for
+     *
+     *  Takes effect from the next frame
+     *
+     *  @param  targetFrameTime     new target time
+     */
+    void SetTargetFrameTime(std::chrono::nanoseconds targetFrameTime) { m_targetFrameTime = targetFrameTime; }
+
+    //! Returns the lowest scale of output resolution dynamic resolution may use
+    float GetMinResolutionScale() const { return m_minResolutionScale; }
+
+    /** @brief  Sets the lowest scale of output resolution
+     *
+     *  Takes effect from the next frame
+     *
+     *  @param  minResolutionScale  new scale in (0, 1] range
+     */
+    void SetMinResolutionScale(float minResolutionScale) { m_minResolutionScale = minResolutionScale; }
+
 private:
     friend class mule::templates::Singleton<Settings>;
 
@@ -107,6 +257,42 @@ private:
 
     //! Profiling mask
     ProfilingMask::MaskType m_profilingMask;
+
+    //! Amount of frames in flight
+    uint32_t m_framesInFlight;
+
+    //! Amount of threads recording draw commands
+    uint32_t m_recordingWorkers;
+
+    //! Shows if recorded draw commands are reused
+    bool m_isRecordedDrawsReuse;
+
+    //! Size of staging ring buffer in bytes
+    uint32_t m_stagingBufferSize;
+
+    //! Headless mode flag
+    bool m_isHeadless;
+
+    //! CPU frustum culling flag
+    bool m_isCpuCulling;
+
+    //! Bindless textures flag
+    bool m_isBindlessTextures;
+
+    //! Shader specialization flag
+    bool m_isShaderSpecialization;
+
+    //! Path of pipeline cache file
+    std::string m_pipelineCachePath;
+
+    //! Dynamic resolution flag
+    bool m_isDynamicResolution;
+
+    //! GPU frame time dynamic resolution aims for
+    std::chrono::nanoseconds m_targetFrameTime;
+
+    //! The lowest resolution scale
+    float m_minResolutionScale;
 };
 }
 }
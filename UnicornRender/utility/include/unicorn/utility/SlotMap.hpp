@@ -0,0 +1,181 @@
+/*
+* Copyright (C) 2017 by Godlike
+* This code is licensed under the MIT license (MIT)
+* (http://opensource.org/licenses/MIT)
+*/
+
+#ifndef UNICORN_UTILITY_SLOT_MAP_HPP
+#define UNICORN_UTILITY_SLOT_MAP_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <utility>
+#include <vector>
+
+namespace unicorn
+{
+namespace utility
+{
+/** @brief Handle of a value stored in SlotMap */
+struct SlotHandle
+{
+    //! Index of the slot
+    uint32_t index = std::numeric_limits<uint32_t>::max();
+    //! Generation of the slot when the value was inserted
+    uint32_t generation = 0;
+
+    bool operator==(SlotHandle const& other) const { return index == other.index && generation == other.generation; }
+    bool operator!=(SlotHandle const& other) const { return !(*this == other); }
+};
+
+/**
+ * @brief Container with stable handles and densely stored values
+ *
+ * Handles point to slots which point to values. Erasing moves the last
+ * value into the gap, so values stay contiguous and their order changes.
+ * Slot generation is increased on erase, so handles of erased values
+ * never resolve to values inserted later. Insert, erase and lookup are O(1)
+ */
+template<typename T>
+class SlotMap
+{
+public:
+    typedef typename std::vector<T>::iterator iterator;
+    typedef typename std::vector<T>::const_iterator const_iterator;
+
+    /**
+     * @brief Stores the value
+     * @param[in] value value to store
+     * @return handle of the value
+     */
+    SlotHandle Insert(T value)
+    {
+        SlotHandle handle;
+
+        if(m_freeSlots.empty())
+        {
+            handle.index = static_cast<uint32_t>(m_slots.size());
+            m_slots.push_back(Slot());
+        }
+        else
+        {
+            handle.index = m_freeSlots.back();
+            m_freeSlots.pop_back();
+        }
+
+        Slot& slot = m_slots[handle.index];
+        slot.valueIndex = static_cast<uint32_t>(m_values.size());
+        handle.generation = slot.generation;
+
+        m_values.push_back(std::move(value));
+        m_valueSlots.push_back(handle.index);
+
+        return handle;
+    }
+
+    /**
+     * @brief Removes the value
+     * @param[in] handle handle of the value
+     * @return true if value was removed, false if handle is stale
+     */
+    bool Erase(SlotHandle handle)
+    {
+        if(!Contains(handle))
+        {
+            return false;
+        }
+
+        Slot& slot = m_slots[handle.index];
+        uint32_t const lastValueIndex = static_cast<uint32_t>(m_values.size() - 1);
+
+        if(slot.valueIndex != lastValueIndex)
+        {
+            m_values[slot.valueIndex] = std::move(m_values.back());
+            m_valueSlots[slot.valueIndex] = m_valueSlots.back();
+            m_slots[m_valueSlots.back()].valueIndex = slot.valueIndex;
+        }
+
+        m_values.pop_back();
+        m_valueSlots.pop_back();
+
+        ++slot.generation;
+        m_freeSlots.push_back(handle.index);
+
+        return true;
+    }
+
+    //! Returns true if handle points to a stored value
+    bool Contains(SlotHandle handle) const
+    {
+        return handle.index < m_slots.size() && m_slots[handle.index].generation == handle.generation;
+    }
+
+    /**
+     * @brief Returns the value
+     * @param[in] handle handle of the value
+     * @return pointer to the value or @c nullptr if handle is stale
+     */
+    T* Get(SlotHandle handle)
+    {
+        return Contains(handle) ? &m_values[m_slots[handle.index].valueIndex] : nullptr;
+    }
+
+    //! Returns the value or @c nullptr if handle is stale
+    T const* Get(SlotHandle handle) const
+    {
+        return Contains(handle) ? &m_values[m_slots[handle.index].valueIndex] : nullptr;
+    }
+
+    //! Removes all values, handles of them become stale
+    void Clear()
+    {
+        for(uint32_t slotIndex : m_valueSlots)
+        {
+            ++m_slots[slotIndex].generation;
+            m_freeSlots.push_back(slotIndex);
+        }
+
+        m_values.clear();
+        m_valueSlots.clear();
+    }
+
+    //! Reserves memory for @p count values
+    void Reserve(size_t count)
+    {
+        m_slots.reserve(count);
+        m_values.reserve(count);
+        m_valueSlots.reserve(count);
+    }
+
+    size_t Size() const { return m_values.size(); }
+    bool IsEmpty() const { return m_values.empty(); }
+
+    iterator begin() { return m_values.begin(); }
+    iterator end() { return m_values.end(); }
+    const_iterator begin() const { return m_values.begin(); }
+    const_iterator end() const { return m_values.end(); }
+
+private:
+    struct Slot
+    {
+        //! Index of the value in m_values while the slot is used
+        uint32_t valueIndex = 0;
+        //! Increased every time the value of the slot is erased
+        uint32_t generation = 0;
+    };
+
+    //! Slots handles point to
+    std::vector<Slot> m_slots;
+    //! Slots which hold no value
+    std::vector<uint32_t> m_freeSlots;
+    //! Stored values
+    std::vector<T> m_values;
+    //! Slot of each value
+    std::vector<uint32_t> m_valueSlots;
+};
+
+}
+}
+
+#endif // UNICORN_UTILITY_SLOT_MAP_HPP
@@ -0,0 +1,107 @@
+/*
+* Copyright (C) 2017 by Godlike
+* This code is licensed under the MIT license (MIT)
+* (http://opensource.org/licenses/MIT)
+*/
+
+#ifndef UNICORN_UTILITY_WORKER_POOL_HPP
+#define UNICORN_UTILITY_WORKER_POOL_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace unicorn
+{
+namespace utility
+{
+/**
+ * @brief Set of persistent threads processing batches of indexed tasks
+ *
+ * Calling thread always takes part in processing, so pool with one worker
+ * doesn't spawn any threads at all
+ */
+class WorkerPool
+{
+public:
+    //! Task signature, receives index of the task and index of the worker processing it
+    typedef std::function<void(uint32_t taskIndex, uint32_t workerIndex)> Task;
+
+    /**
+     * @brief Constructs the pool and spawns worker threads
+     * @param[in] workersCount total amount of workers including calling thread
+     */
+    explicit WorkerPool(uint32_t workersCount);
+
+    /** @brief Stops and joins worker threads */
+    ~WorkerPool();
+
+    WorkerPool(WorkerPool const& other) = delete;
+    WorkerPool(WorkerPool&& other) = delete;
+    WorkerPool& operator=(WorkerPool const& other) = delete;
+    WorkerPool& operator=(WorkerPool&& other) = delete;
+
+    //! Returns total amount of workers including calling thread
+    uint32_t GetWorkersCount() const { return static_cast<uint32_t>(m_threads.size()) + 1; }
+
+    /**
+     * @brief Runs @p task for every index in [0, @p tasksCount) and waits for completion
+     *
+     * Worker indices are in range [0, GetWorkersCount()), calling thread is worker 0
+     *
+     * @param[in] tasksCount amount of tasks
+     * @param[in] task function called for each task
+     */
+    void Execute(uint32_t tasksCount, Task const& task);
+
+private:
+    /**
+     * @brief Main loop of a worker thread
+     * @param[in] workerIndex index of the worker
+     */
+    void Run(uint32_t workerIndex);
+
+    /**
+     * @brief Takes tasks of current batch until there are none left
+     * @param[in] workerIndex index of the worker
+     */
+    void Process(uint32_t workerIndex);
+
+    //! Worker threads, calling thread is not stored here
+    std::vector<std::thread> m_threads;
+
+    //! Guards batch state
+    std::mutex m_mutex;
+
+    //! Notifies workers about new batch or shutdown
+    std::condition_variable m_wakeUp;
+
+    //! Notifies calling thread that workers are done
+    std::condition_variable m_done;
+
+    //! Task of current batch
+    Task const* m_pTask;
+
+    //! Amount of tasks in current batch
+    uint32_t m_tasksCount;
+
+    //! Index of the next task to be taken
+    std::atomic<uint32_t> m_nextTask;
+
+    //! Amount of worker threads which are still processing current batch
+    uint32_t m_busyWorkers;
+
+    //! Incremented for every batch so workers can tell new batch from spurious wake up
+    uint64_t m_generation;
+
+    //! Shutdown flag
+    bool m_stop;
+};
+}
+}
+
+#endif // UNICORN_UTILITY_WORKER_POOL_HPP
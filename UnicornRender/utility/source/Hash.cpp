@@ -0,0 +1,26 @@
+/*
+* Copyright (C) 2017 by Godlike
+* This code is licensed under the MIT license (MIT)
+* (http://opensource.org/licenses/MIT)
+*/
+
+#include <unicorn/utility/Hash.hpp>
+
+namespace unicorn
+{
+namespace utility
+{
+uint64_t HashBytes(void const* pData, size_t size, uint64_t hash)
+{
+    uint8_t const* pBytes = static_cast<uint8_t const*>(pData);
+
+    for(size_t i = 0; i < size; ++i)
+    {
+        hash ^= pBytes[i];
+        hash *= 1099511628211ull;
+    }
+
+    return hash;
+}
+}
+}
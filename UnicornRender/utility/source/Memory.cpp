@@ -37,5 +37,10 @@ void AlignedFree(void* data)
     static_assert(false, "Platform not supported.");
     #endif
 }
+
+uint64_t AlignUp(uint64_t value, uint64_t alignment)
+{
+    return (value + alignment - 1) / alignment * alignment;
+}
 }
 }
@@ -0,0 +1,80 @@
+/*
+* Copyright (C) 2017 by Godlike
+* This code is licensed under the MIT license (MIT)
+* (http://opensource.org/licenses/MIT)
+*/
+
+#include <unicorn/utility/RadixSort.hpp>
+
+#include <array>
+#include <cstddef>
+#include <utility>
+
+namespace unicorn
+{
+namespace utility
+{
+
+void RadixSort(std::vector<SortItem>& items, std::vector<SortItem>& buffer)
+{
+    size_t const count = items.size();
+
+    if(count < 2)
+    {
+        return;
+    }
+
+    constexpr uint32_t digitsCount = sizeof(uint64_t);
+    constexpr uint32_t bucketsCount = 256;
+
+    // Histograms of all digits are gathered with one pass over keys
+    std::array<std::array<uint32_t, bucketsCount>, digitsCount> histograms = {};
+
+    for(SortItem const& item : items)
+    {
+        for(uint32_t digit = 0; digit < digitsCount; ++digit)
+        {
+            ++histograms[digit][(item.key >> (digit * 8)) & 0xFF];
+        }
+    }
+
+    buffer.resize(count);
+
+    std::vector<SortItem>* pSource = &items;
+    std::vector<SortItem>* pDestination = &buffer;
+
+    for(uint32_t digit = 0; digit < digitsCount; ++digit)
+    {
+        std::array<uint32_t, bucketsCount>& histogram = histograms[digit];
+
+        // All keys share this digit, so the pass wouldn't move anything
+        if(histogram[(items.front().key >> (digit * 8)) & 0xFF] == count)
+        {
+            continue;
+        }
+
+        uint32_t offset = 0;
+
+        for(uint32_t& bucket : histogram)
+        {
+            uint32_t const bucketSize = bucket;
+            bucket = offset;
+            offset += bucketSize;
+        }
+
+        for(SortItem const& item : *pSource)
+        {
+            (*pDestination)[histogram[(item.key >> (digit * 8)) & 0xFF]++] = item;
+        }
+
+        std::swap(pSource, pDestination);
+    }
+
+    if(pSource != &items)
+    {
+        items.swap(buffer);
+    }
+}
+
+}
+}
@@ -17,6 +17,18 @@ Settings::Settings()
     , m_applicationName("SAMPLE NAME")
     , m_unicornEngineName("Unicorn Render")
     , m_profilingMask(Settings::ProfilingMask::None)
+    , m_framesInFlight(2)
+    , m_recordingWorkers(1)
+    , m_isRecordedDrawsReuse(true)
+    , m_stagingBufferSize(32 * 1024 * 1024)
+    , m_isHeadless(false)
+    , m_isCpuCulling(false)
+    , m_isBindlessTextures(false)
+    , m_isShaderSpecialization(true)
+    , m_pipelineCachePath("pipeline.cache")
+    , m_isDynamicResolution(false)
+    , m_targetFrameTime(std::chrono::microseconds(16667))
+    , m_minResolutionScale(0.5f)
 {
 }
 
@@ -0,0 +1,113 @@
+/*
+* Copyright (C) 2017 by Godlike
+* This code is licensed under the MIT license (MIT)
+* (http://opensource.org/licenses/MIT)
+*/
+
+#include <unicorn/utility/WorkerPool.hpp>
+
+namespace unicorn
+{
+namespace utility
+{
+WorkerPool::WorkerPool(uint32_t workersCount)
+    : m_pTask(nullptr)
+    , m_tasksCount(0)
+    , m_nextTask(0)
+    , m_busyWorkers(0)
+    , m_generation(0)
+    , m_stop(false)
+{
+    for(uint32_t i = 1; i < workersCount; ++i)
+    {
+        m_threads.emplace_back(&WorkerPool::Run, this, i);
+    }
+}
+
+WorkerPool::~WorkerPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+
+    m_wakeUp.notify_all();
+
+    for(auto& thread : m_threads)
+    {
+        thread.join();
+    }
+}
+
+void WorkerPool::Execute(uint32_t tasksCount, Task const& task)
+{
+    if(tasksCount == 0)
+    {
+        return;
+    }
+
+    if(m_threads.empty())
+    {
+        for(uint32_t i = 0; i < tasksCount; ++i)
+        {
+            task(i, 0);
+        }
+
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_pTask = &task;
+        m_tasksCount = tasksCount;
+        m_nextTask = 0;
+        m_busyWorkers = static_cast<uint32_t>(m_threads.size());
+        ++m_generation;
+    }
+
+    m_wakeUp.notify_all();
+
+    Process(0);
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_done.wait(lock, [this]() { return m_busyWorkers == 0; });
+    m_pTask = nullptr;
+}
+
+void WorkerPool::Run(uint32_t workerIndex)
+{
+    uint64_t generation = 0;
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+
+    while(true)
+    {
+        m_wakeUp.wait(lock, [&]() { return m_stop || m_generation != generation; });
+
+        if(m_stop)
+        {
+            return;
+        }
+
+        generation = m_generation;
+
+        lock.unlock();
+        Process(workerIndex);
+        lock.lock();
+
+        if(--m_busyWorkers == 0)
+        {
+            m_done.notify_one();
+        }
+    }
+}
+
+void WorkerPool::Process(uint32_t workerIndex)
+{
+    for(uint32_t i = m_nextTask++; i < m_tasksCount; i = m_nextTask++)
+    {
+        (*m_pTask)(i, workerIndex);
+    }
+}
+}
+}
@@ -0,0 +1,137 @@
+/*
+* Copyright (C) 2017 by Godlike
+* This code is licensed under the MIT license (MIT)
+* (http://opensource.org/licenses/MIT)
+*/
+
+#ifndef UNICORN_VIDEO_BOUNDS_HPP
+#define UNICORN_VIDEO_BOUNDS_HPP
+
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <vector>
+
+namespace unicorn
+{
+namespace video
+{
+/** @brief Axis aligned bounding box */
+struct BoundingBox
+{
+    /** @brief Minimal corner */
+    glm::vec3 minimum = glm::vec3(0.0f);
+
+    /** @brief Maximal corner */
+    glm::vec3 maximum = glm::vec3(0.0f);
+
+    /**
+     * @brief Computes box enclosing given points
+     *
+     * @param[in] pPoints first point
+     * @param[in] count amount of points
+     * @param[in] stride distance between consecutive points in bytes
+     *
+     * @return bounding box, empty box at origin if there are no points
+     */
+    static BoundingBox FromPoints(glm::vec3 const* pPoints, size_t count, size_t stride);
+
+    /**
+     * @brief Computes box enclosing this box after transformation
+     *
+     * @param[in] transform affine transformation matrix
+     *
+     * @return transformed bounding box
+     */
+    BoundingBox Transformed(glm::mat4 const& transform) const;
+
+    /** @brief Returns center of the box */
+    glm::vec3 GetCenter() const { return (minimum + maximum) * 0.5f; }
+
+    /** @brief Returns half sizes of the box */
+    glm::vec3 GetExtents() const { return (maximum - minimum) * 0.5f; }
+};
+
+/** @brief Bounding sphere */
+struct BoundingSphere
+{
+    /** @brief Center of the sphere */
+    glm::vec3 center = glm::vec3(0.0f);
+
+    /** @brief Radius of the sphere */
+    float radius = 0.0f;
+
+    /**
+     * @brief Computes sphere around box center enclosing given points
+     *
+     * @param[in] box bounding box of the points
+     * @param[in] pPoints first point
+     * @param[in] count amount of points
+     * @param[in] stride distance between consecutive points in bytes
+     *
+     * @return bounding sphere
+     */
+    static BoundingSphere FromPoints(BoundingBox const& box, glm::vec3 const* pPoints, size_t count, size_t stride);
+
+    /**
+     * @brief Computes sphere enclosing this sphere after transformation
+     *
+     * Radius is scaled by the largest axis scale of @p transform
+     *
+     * @param[in] transform affine transformation matrix
+     *
+     * @return transformed bounding sphere
+     */
+    BoundingSphere Transformed(glm::mat4 const& transform) const;
+};
+
+/**
+ * @brief Bounding spheres stored as structure of arrays
+ *
+ * Layout lets frustum test several spheres with one SIMD instruction
+ */
+class SphereBatch
+{
+public:
+    /** @brief Removes all spheres */
+    void Clear();
+
+    /**
+     * @brief Reserves memory for spheres
+     *
+     * @param[in] count amount of spheres
+     */
+    void Reserve(size_t count);
+
+    /**
+     * @brief Appends sphere to the batch
+     *
+     * @param[in] sphere sphere to add
+     */
+    void Push(BoundingSphere const& sphere);
+
+    /** @brief Returns amount of spheres */
+    size_t GetSize() const { return m_radius.size(); }
+
+    /** @brief Returns X coordinates of sphere centers */
+    float const* GetCenterX() const { return m_centerX.data(); }
+
+    /** @brief Returns Y coordinates of sphere centers */
+    float const* GetCenterY() const { return m_centerY.data(); }
+
+    /** @brief Returns Z coordinates of sphere centers */
+    float const* GetCenterZ() const { return m_centerZ.data(); }
+
+    /** @brief Returns radii of spheres */
+    float const* GetRadius() const { return m_radius.data(); }
+
+private:
+    std::vector<float> m_centerX;
+    std::vector<float> m_centerY;
+    std::vector<float> m_centerZ;
+    std::vector<float> m_radius;
+};
+}
+}
+
+#endif // UNICORN_VIDEO_BOUNDS_HPP
@@ -0,0 +1,82 @@
+/*
+* Copyright (C) 2017 by Godlike
+* This code is licensed under the MIT license (MIT)
+* (http://opensource.org/licenses/MIT)
+*/
+
+#ifndef UNICORN_VIDEO_FRUSTUM_HPP
+#define UNICORN_VIDEO_FRUSTUM_HPP
+
+#include <unicorn/video/Bounds.hpp>
+
+#include <glm/glm.hpp>
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+namespace unicorn
+{
+namespace video
+{
+/**
+ * @brief View frustum described by six planes
+ *
+ * Planes bound Vulkan clip volume: -w <= x <= w, -w <= y <= w and 0 <= z <= w.
+ * Plane normals point inside, so points inside of the frustum
+ * are on positive side of all planes
+ */
+class Frustum
+{
+public:
+    /** @brief Constructs frustum which contains everything */
+    Frustum();
+
+    /**
+     * @brief Constructs frustum of the camera
+     *
+     * @param[in] viewProjection view projection matrix of the camera
+     */
+    explicit Frustum(glm::mat4 const& viewProjection);
+
+    /** @brief Returns planes, normal in xyz and distance in w */
+    std::array<glm::vec4, 6> const& GetPlanes() const { return m_planes; }
+
+    /**
+     * @brief Checks if sphere intersects the frustum
+     *
+     * @param[in] sphere bounding sphere
+     *
+     * @return @c true if sphere is at least partially inside
+     */
+    bool Intersects(BoundingSphere const& sphere) const;
+
+    /**
+     * @brief Checks if box intersects the frustum
+     *
+     * @param[in] box bounding box
+     *
+     * @return @c true if box is at least partially inside
+     */
+    bool Intersects(BoundingBox const& box) const;
+
+    /**
+     * @brief Tests all spheres of the batch against the frustum
+     *
+     * Spheres are tested 8 at a time with AVX or 4 at a time with SSE
+     * when the library is built with them
+     *
+     * @param[in] spheres spheres to test
+     * @param[out] visibility one entry per sphere, 1 if sphere is visible and 0 otherwise
+     *
+     * @return amount of visible spheres
+     */
+    uint32_t Cull(SphereBatch const& spheres, std::vector<uint8_t>& visibility) const;
+
+private:
+    std::array<glm::vec4, 6> m_planes;
+};
+}
+}
+
+#endif // UNICORN_VIDEO_FRUSTUM_HPP
@@ -151,6 +151,18 @@ public:
     */
     Renderer* SpawnRenderer(system::Window* window, Camera& camera);
 
+    /** @brief  Spawn new DriverType based Renderer which renders into offscreen images
+    *
+    *  Headless renderer doesn't need window or window system, rendered frames
+    *  are delivered through Renderer::FrameReadback
+    *
+    *  @param  width  width of rendered images
+    *  @param  height height of rendered images
+    *  @param  camera main camera
+    *  @return Pointer to newly created Renderer, nullptr if any error occured.
+    */
+    Renderer* SpawnHeadlessRenderer(uint32_t width, uint32_t height, Camera& camera);
+
     /** @brief Binds renderer to window. */
     void BindWindowRenderer(system::Window* pWindow, Renderer* pRenderer);
 
@@ -56,6 +56,18 @@ public:
      */
     bool IsVisible() const;
 
+    /**
+     * @brief Sets transparency flag
+     *
+     * Transparent materials are blended and drawn back to front after opaque ones
+     *
+     * @param[in] transparent true if material is blended and false if it's opaque
+     */
+    void SetIsTransparent(bool transparent);
+
+    /** Returns @c true if material is blended and @false otherwise */
+    bool IsTransparent() const;
+
     /**
      * @brief Sets colored mode
      *
@@ -123,6 +135,7 @@ protected:
     bool m_isColored;
     bool m_isWired;
     bool m_isVisible;
+    bool m_isTransparent;
 
     std::shared_ptr<Texture> m_albedo;
 };
@@ -7,6 +7,7 @@
 #ifndef UNICORN_VIDEO_MESH_HPP
 #define UNICORN_VIDEO_MESH_HPP
 
+#include <unicorn/video/Bounds.hpp>
 #include <unicorn/video/Material.hpp>
 #include <unicorn/video/Transform.hpp>
 
@@ -78,14 +79,33 @@ public:
     */
     std::shared_ptr<Material> GetMaterial() const;
 
+    /** @brief Returns bounding box of vertices in model space, updated by @sa SetMeshData */
+    BoundingBox const& GetLocalBoundingBox() const { return m_localBoundingBox; }
+
+    /** @brief Returns bounding sphere of vertices in model space, updated by @sa SetMeshData */
+    BoundingSphere const& GetLocalBoundingSphere() const { return m_localBoundingSphere; }
+
+    /** @brief Returns bounding box in world space, updated by @sa UpdateTransformMatrix */
+    BoundingBox const& GetWorldBoundingBox() const { return m_worldBoundingBox; }
+
+    /** @brief Returns bounding sphere in world space, updated by @sa UpdateTransformMatrix */
+    BoundingSphere const& GetWorldBoundingSphere() const { return m_worldBoundingSphere; }
+
     /** @brief Event triggered when material is changed */
     wink::signal<wink::slot<void()>> MaterialUpdated;
 
     /** @brief Event triggered when vertices are changed */
     wink::signal<wink::slot<void()>> VerticesUpdated;
 
+    /** @brief Event triggered when model matrix or bounds are recalculated */
+    wink::signal<wink::slot<void()>> TransformUpdated;
+
     /** @brief Name of mesh */
     std::string name;
+protected:
+    /** @brief Transforms local bounds into world space and notifies about new transform */
+    void OnTransformMatrixUpdated() override;
+
 private:
     /** @brief Updates renderer info about this mesh */
     void OnMaterialUpdated();
@@ -93,6 +113,11 @@ private:
     std::vector<Vertex> m_vertices;
     std::vector<uint32_t> m_indices;
     std::shared_ptr<Material> m_material;
+
+    BoundingBox m_localBoundingBox;
+    BoundingSphere m_localBoundingSphere;
+    BoundingBox m_worldBoundingBox;
+    BoundingSphere m_worldBoundingSphere;
 };
 }
 }
@@ -13,10 +13,12 @@
 
 #include <glm/glm.hpp>
 
+#include <chrono>
 #include <cstdint>
 #include <memory>
 #include <array>
 #include <list>
+#include <vector>
 
 namespace unicorn
 {
@@ -29,6 +31,74 @@ class Timer;
 
 namespace video
 {
+/** @brief Statistics of the last rendered frame */
+struct FrameStats
+{
+    //! Amount of recorded draw calls
+    uint32_t drawCount = 0;
+    //! Amount of drawn mesh instances
+    uint32_t instanceCount = 0;
+    //! Amount of draw calls with instances which passed frustum culling, reported once GPU finishes the frame
+    uint32_t visibleDrawCount = 0;
+    //! Amount of instances which passed frustum culling, reported once GPU finishes the frame
+    uint32_t visibleInstanceCount = 0;
+    //! Amount of instances whose data was uploaded to GPU
+    uint32_t uploadedInstanceCount = 0;
+    //! Amount of buffer ranges instance data was uploaded with
+    uint32_t instanceUploadRangeCount = 0;
+    //! Amount of instances rejected by CPU frustum culling
+    uint32_t culledInstanceCount = 0;
+    //! CPU time spent on frustum culling
+    std::chrono::nanoseconds cullingTime = std::chrono::nanoseconds::zero();
+    //! Amount of pipeline binds in recorded draws
+    uint32_t pipelineBindCount = 0;
+    //! Amount of vertex and index buffer binds in recorded draws
+    uint32_t vertexBufferBindCount = 0;
+    //! Amount of descriptor set binds in recorded draws
+    uint32_t descriptorSetBindCount = 0;
+    //! Amount of recorded indirect draw calls
+    uint32_t drawCallCount = 0;
+    //! Amount of binds filtered out because the state was already bound
+    uint32_t skippedBindCount = 0;
+    //! Amount of descriptor pools
+    uint32_t descriptorPoolCount = 0;
+    //! Amount of descriptor sets in use
+    uint32_t descriptorSetCount = 0;
+    //! Amount of descriptor sets all descriptor pools can hold
+    uint32_t descriptorSetCapacity = 0;
+    //! Amount of graphics pipeline variants created so far
+    uint32_t pipelineCount = 0;
+    //! Amount of threads which recorded draw calls
+    uint32_t recordingWorkers = 0;
+    //! Shows if draw calls were recorded anew, recorded draws of the frame slot were reused otherwise
+    bool areDrawsRecorded = false;
+    //! CPU time spent on command recording
+    std::chrono::nanoseconds recordingTime = std::chrono::nanoseconds::zero();
+    //! GPU time of the scene render pass, reported once GPU finishes the frame, zero if device has no timestamps
+    std::chrono::nanoseconds gpuTime = std::chrono::nanoseconds::zero();
+    //! Scale of output resolution the scene was rendered at
+    float resolutionScale = 1.0f;
+};
+
+/**
+ * @brief Rendered frame read back to CPU memory
+ *
+ * Pixel data is owned by renderer and is valid only while the event is emitted
+ */
+struct ReadbackImage
+{
+    //! Sequential number of the frame
+    uint64_t frameIndex;
+    //! Width in pixels
+    uint32_t width;
+    //! Height in pixels
+    uint32_t height;
+    //! Size of one row in bytes
+    uint32_t rowPitch;
+    //! Tightly packed RGBA8 pixels
+    uint8_t const* pPixels;
+};
+
 /**
  * @brief Abstract class for all renderer system
  */
@@ -38,7 +108,7 @@ public:
     /**
      * @brief Constructor
      * @param[in,out] manager Describes required extensions, creates window surface
-     * @param[in,out] window output window
+     * @param[in,out] window output window, @c nullptr for headless renderer
      * @param[in] camera main camera
      */
     Renderer(system::Manager& manager, system::Window* window, Camera const& camera);
@@ -56,6 +126,16 @@ public:
 
     void SetBackgroundColor(const glm::vec3& backgroundColor);
 
+    //! Returns statistics of the last rendered frame
+    FrameStats const& GetFrameStats() const { return m_frameStats; }
+
+    /**
+     * @brief Returns scale of output resolution the scene is rendered at
+     *
+     * Scale changes only with dynamic resolution, otherwise it is @c 1
+     */
+    float GetResolutionScale() const { return m_resolutionScale; }
+
     /** @brief  Event triggered from destructor before the renderer is destroyed
      *
      *  Event is emitted with the following signature:
@@ -63,6 +143,19 @@ public:
      */
     wink::signal<wink::slot<void(Renderer*)>> Destroyed;
 
+    /** @brief  Event triggered when rendered frame is read back to CPU memory
+     *
+     *  Only headless renderers read frames back. Event is emitted
+     *  when GPU finished the frame, which happens while one of
+     *  the following frames is being rendered. Frames still in flight
+     *  are finished and emitted on renderer deinitialization
+     *
+     *  Event is emitted with the following signature:
+     *  -# renderer pointer
+     *  -# read back image
+     */
+    wink::signal<wink::slot<void(Renderer*, ReadbackImage const&)>> FrameReadback;
+
     /**
      * @brief Turns on or off depth test
      * @param [in] enabled if true - depth test is enabled, false - disabled
@@ -87,6 +180,31 @@ public:
     */
     virtual bool DeleteMesh(Mesh const* pMesh) = 0;
 
+    /**
+    * @brief Adds meshes to the rendering system
+    *
+    * Works as AddMesh() called for every mesh, but renderer
+    * containers grow once for the whole batch
+    *
+    * @param [in] meshes mesh data
+    *
+    * @return true if all meshes were successfully added to the system
+    */
+    virtual bool AddMeshes(std::vector<Mesh*> const& meshes) = 0;
+
+    /**
+    * @brief Removes internal rendering data of meshes from rendering system
+    *
+    * Works as DeleteMesh() called for every mesh
+    *
+    * @note meshes are not invalidated within the method
+    *
+    * @param [in] meshes pointers to meshes
+    *
+    * @return true if data of all meshes was found and succesfully deleted
+    */
+    virtual bool DeleteMeshes(std::vector<Mesh*> const& meshes) = 0;
+
     //! Main view camera, must never be nullptr
     Camera const* camera;
 protected:
@@ -100,6 +218,10 @@ protected:
     std::array<float, 4> m_backgroundColor;
     //! Depth test
     bool m_depthTestEnabled;
+    //! Scale of output resolution the scene is rendered at
+    float m_resolutionScale;
+    //! Statistics of the last rendered frame
+    FrameStats m_frameStats;
 };
 }
 }
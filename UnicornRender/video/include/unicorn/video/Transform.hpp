@@ -204,6 +204,9 @@ protected:
     /** @brief Abstract method to calculate orientation quaternion */
     virtual void UpdateOrientation();
 
+    /** @brief Called by @sa UpdateTransformMatrix after transform matrix is recalculated */
+    virtual void OnTransformMatrixUpdated() {}
+
     glm::vec3 m_rotation;
     glm::vec3 m_translation;
     glm::quat m_orientation;
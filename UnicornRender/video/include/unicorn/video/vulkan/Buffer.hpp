@@ -40,11 +40,11 @@ public:
      * @param[in] physicalDevice GPU for memory allocation
      * @param[in] device device for allocation
      * @param[in] usage buffer specific usage
-     * @param[in] memoryPropertyFlags flags for memory usage
+     * @param[in] memoryUsage how buffer memory is accessed, memory type is picked from it
      * @param[in] size size of buffer
      * @return true if buffer was allocated correctly, false if some error occured
      */
-    bool Create(vk::PhysicalDevice physicalDevice, vk::Device device, vk::BufferUsageFlags usage, vk::MemoryPropertyFlags memoryPropertyFlags, size_t size);
+    bool Create(vk::PhysicalDevice physicalDevice, vk::Device device, vk::BufferUsageFlags usage, MemoryUsage memoryUsage, size_t size);
 
     /**
      * @brief Destroys all buffer data
@@ -57,6 +57,14 @@ public:
      */
     void Write(void const* pData) const;
 
+    /**
+     * @brief Writes part of buffer data. You need to map it first.
+     * @param[in] pData pointer to data content
+     * @param[in] size size of data in bytes
+     * @param[in] offset offset in buffer in bytes
+     */
+    void Write(void const* pData, size_t size, size_t offset) const;
+
     /**
      * @brief Maps buffer
      */
@@ -67,6 +75,29 @@ public:
      */
     void Unmap();
 
+    /**
+     * @brief Makes host writes visible to device, required for non-coherent memory
+     */
+    void Flush() const;
+
+    /**
+     * @brief Makes host writes to part of buffer visible to device
+     * @param[in] offset offset of written bytes
+     * @param[in] size amount of written bytes
+     */
+    void Flush(size_t offset, size_t size) const;
+
+    /**
+     * @brief Makes device writes visible to host, required for non-coherent memory
+     */
+    void Invalidate() const;
+
+    /**
+     * @brief Returns pointer to mapped memory
+     * @return pointer to mapped memory or nullptr if buffer is not mapped
+     */
+    void const* GetMappedMemory() const;
+
     /**
      * @brief Copies buffer to another buffer. Useful for staging buffering
      * @param[out] pool pool for allocating commands from
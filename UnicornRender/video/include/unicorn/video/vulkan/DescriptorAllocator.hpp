@@ -0,0 +1,142 @@
+/*
+* Copyright (C) 2017 by Godlike
+* This code is licensed under the MIT license (MIT)
+* (http://opensource.org/licenses/MIT)
+*/
+
+#ifndef UNICORN_VIDEO_VULKAN_DESCRIPTOR_ALLOCATOR_HPP
+#define UNICORN_VIDEO_VULKAN_DESCRIPTOR_ALLOCATOR_HPP
+
+#include <vulkan/vulkan.hpp>
+
+#include <cstdint>
+#include <map>
+#include <vector>
+
+namespace unicorn
+{
+namespace video
+{
+namespace vulkan
+{
+/**
+ * @brief Allocates descriptor sets from a chain of descriptor pools
+ *
+ * Sets are allocated from the current pool, when it is exhausted the next
+ * pool of the chain is used and a new one is created at the end of the chain.
+ * Every new pool is twice as large as the previous one up to a limit.
+ *
+ * Freed sets are not returned to their pools, they are kept in free lists
+ * of their layouts and handed out again by the next allocation with the same
+ * layout. Their descriptors have to be written anew.
+ *
+ * Transient sets are released all at once by Reset() which resets all pools
+ * and keeps them for further allocations
+ */
+class DescriptorAllocator
+{
+public:
+    //! Occupancy statistics of the allocator
+    struct Stats
+    {
+        //! Amount of pools in the chain
+        uint32_t poolsCount = 0;
+
+        //! Amount of sets all pools can hold
+        uint32_t setsCapacity = 0;
+
+        //! Amount of sets allocated from pools, including recycled ones
+        uint32_t allocatedSetsCount = 0;
+
+        //! Amount of sets waiting in free lists
+        uint32_t recycledSetsCount = 0;
+    };
+
+    /**
+     * @brief Constructs allocator without pools
+     *
+     * @param[in] device device to allocate from
+     * @param[in] poolSizes descriptor counts of the first pool
+     * @param[in] maxSets amount of sets of the first pool
+     */
+    DescriptorAllocator(vk::Device device, std::vector<vk::DescriptorPoolSize> const& poolSizes, uint32_t maxSets);
+
+    /** @brief Destroys all pools together with their sets */
+    ~DescriptorAllocator();
+
+    DescriptorAllocator(DescriptorAllocator const& other) = delete;
+    DescriptorAllocator(DescriptorAllocator&& other) = delete;
+    DescriptorAllocator& operator=(DescriptorAllocator const& other) = delete;
+    DescriptorAllocator& operator=(DescriptorAllocator&& other) = delete;
+
+    /**
+     * @brief Allocates descriptor set
+     *
+     * Recycled set of the same layout is preferred over a new one
+     *
+     * @param[in] layout layout of the set
+     * @param[out] descriptorSet allocated set
+     * @return true if set was allocated, false otherwise
+     */
+    bool Allocate(vk::DescriptorSetLayout layout, vk::DescriptorSet& descriptorSet);
+
+    /**
+     * @brief Puts descriptor set into free list of its layout
+     *
+     * GPU must not use the set anymore
+     *
+     * @param[in] layout layout the set was allocated with
+     * @param[in] descriptorSet set to recycle
+     */
+    void Free(vk::DescriptorSetLayout layout, vk::DescriptorSet descriptorSet);
+
+    /**
+     * @brief Releases all sets allocated from the allocator
+     *
+     * Pools are reset and reused by next allocations. GPU must not use
+     * any of the sets anymore
+     */
+    void Reset();
+
+    /** @brief Returns occupancy statistics of the allocator */
+    Stats GetStats() const;
+
+private:
+    struct Pool
+    {
+        vk::DescriptorPool pool;
+        uint32_t maxSets = 0;
+        uint32_t allocatedSetsCount = 0;
+    };
+
+    //! Limits growth of chained pools relative to the first one
+    static const uint32_t s_maxPoolScale;
+
+    vk::Device m_device;
+
+    //! Descriptor counts of the first pool
+    std::vector<vk::DescriptorPoolSize> m_poolSizes;
+
+    //! Amount of sets of the first pool
+    uint32_t m_maxSets;
+
+    //! Pools in order of creation
+    std::vector<Pool> m_pools;
+
+    //! Index of the pool sets are allocated from
+    size_t m_currentPool;
+
+    //! Freed sets of every layout
+    std::map<vk::DescriptorSetLayout, std::vector<vk::DescriptorSet>> m_freeSets;
+
+    /**
+     * @brief Creates a pool at the end of the chain
+     * @return true if pool was created, false otherwise
+     */
+    bool CreatePool();
+};
+}
+}
+}
+
+#endif // UNICORN_VIDEO_VULKAN_DESCRIPTOR_ALLOCATOR_HPP
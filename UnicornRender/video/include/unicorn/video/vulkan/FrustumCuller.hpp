@@ -0,0 +1,159 @@
+/*
+* Copyright (C) 2017 by Godlike
+* This code is licensed under the MIT license (MIT)
+* (http://opensource.org/licenses/MIT)
+*/
+
+#ifndef UNICORN_VIDEO_VULKAN_FRUSTUM_CULLER_HPP
+#define UNICORN_VIDEO_VULKAN_FRUSTUM_CULLER_HPP
+
+#include <unicorn/video/vulkan/Buffer.hpp>
+#include <unicorn/video/Frustum.hpp>
+
+#include <vulkan/vulkan.hpp>
+#include <glm/glm.hpp>
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+namespace unicorn
+{
+namespace video
+{
+namespace vulkan
+{
+/**
+ * @brief Per instance input of frustum culling, indexed by position in the draw list
+ *
+ * Layout matches std430 structure of the culling shader
+ */
+struct CullingData
+{
+    //! Bounding sphere in model space, center in xyz and radius in w
+    glm::vec4 boundingSphere;
+
+    //! Slot of instance data in instance buffer
+    uint32_t instanceSlot;
+
+    //! Non-zero if instance is not hidden
+    uint32_t isVisible;
+
+    uint32_t padding0;
+    uint32_t padding1;
+};
+
+/** @brief Range of the draw list drawn by one indirect command */
+struct CullingGroup
+{
+    //! Index of the first instance in the draw list and in the visible instance buffer
+    uint32_t firstInstance;
+
+    //! Amount of instances including hidden ones
+    uint32_t instanceCount;
+};
+
+/** @brief Counters incremented by culling shader */
+struct CullingCounters
+{
+    //! Amount of commands with at least one visible instance
+    uint32_t drawCount;
+
+    //! Amount of instances which passed culling
+    uint32_t instanceCount;
+};
+
+/**
+ * @brief Culls instances against view frustum in a compute pass
+ *
+ * Every workgroup handles one indirect command. It tests bounding spheres
+ * of the command instances in chunks and copies those which pass to visible
+ * instance buffer at firstInstance + prefix sum of visibility, so surviving
+ * instances keep draw list order and sorted draws stay sorted. Instance count
+ * of the command is overwritten with amount of visible instances.
+ *
+ * Uses only core Vulkan 1.0 features: storage buffers, shared memory and atomics
+ */
+class FrustumCuller
+{
+public:
+    /**
+     * @brief Constructs culler which is not created yet
+     * @param[in] device device to create objects on
+     */
+    explicit FrustumCuller(vk::Device device);
+
+    /** @brief Calls Destroy() */
+    ~FrustumCuller();
+
+    FrustumCuller(FrustumCuller const& other) = delete;
+    FrustumCuller& operator=(FrustumCuller const& other) = delete;
+
+    /**
+     * @brief Creates compute pipeline and descriptor sets
+     * @param[in] framesCount amount of frames in flight, each frame has its own descriptor set
+     * @param[in] pipelineCache cache to create pipeline with
+     * @return true if culler was created, false otherwise
+     */
+    bool Create(uint32_t framesCount, vk::PipelineCache pipelineCache);
+
+    /** @brief Destroys pipeline and descriptor sets */
+    void Destroy();
+
+    //! Returns true if culler is created
+    bool IsCreated() const { return static_cast<bool>(m_pipeline); }
+
+    /**
+     * @brief Points descriptor set of the frame to its buffers
+     *
+     * Descriptor set must not be used by pending command buffers
+     *
+     * @param[in] frameIndex index of the frame
+     * @param[in] instances instance data written by CPU
+     * @param[in] cullingData culling data of instances
+     * @param[in] commands indirect commands
+     * @param[in] visibleInstances instance data of visible instances
+     * @param[in] counters culling counters
+     * @param[in] groups draw list ranges of commands
+     */
+    void UpdateDescriptorSet(uint32_t frameIndex,
+                             Buffer const& instances,
+                             Buffer const& cullingData,
+                             Buffer const& commands,
+                             Buffer const& visibleInstances,
+                             Buffer const& counters,
+                             Buffer const& groups) const;
+
+    /**
+     * @brief Records culling dispatch followed by barrier for indirect draws and host reads
+     * @param[in] commandBuffer command buffer outside of render pass
+     * @param[in] frameIndex index of the frame
+     * @param[in] frustum frustum instances are tested against
+     * @param[in] commandCount amount of indirect commands
+     */
+    void Record(vk::CommandBuffer commandBuffer, uint32_t frameIndex, Frustum const& frustum, uint32_t commandCount) const;
+
+private:
+    //! Push constants of culling shader
+    struct Parameters
+    {
+        std::array<glm::vec4, 6> planes;
+        uint32_t commandCount;
+    };
+
+    //! Amount of workgroups dispatched along X axis, every device supports at least this many
+    static const uint32_t s_maxWorkgroupsX;
+
+    vk::Device m_device;
+    vk::ShaderModule m_shaderModule;
+    vk::DescriptorSetLayout m_descriptorSetLayout;
+    vk::PipelineLayout m_pipelineLayout;
+    vk::Pipeline m_pipeline;
+    vk::DescriptorPool m_descriptorPool;
+    std::vector<vk::DescriptorSet> m_descriptorSets;
+};
+}
+}
+}
+
+#endif // UNICORN_VIDEO_VULKAN_FRUSTUM_CULLER_HPP
@@ -0,0 +1,318 @@
+/*
+* Copyright (C) 2017 by Godlike
+* This code is licensed under the MIT license (MIT)
+* (http://opensource.org/licenses/MIT)
+*/
+
+#ifndef UNICORN_VIDEO_VULKAN_GEOMETRY_ARENA_HPP
+#define UNICORN_VIDEO_VULKAN_GEOMETRY_ARENA_HPP
+
+#include <unicorn/video/Mesh.hpp>
+#include <unicorn/video/vulkan/Buffer.hpp>
+
+#include <vulkan/vulkan.hpp>
+
+#include <cstdint>
+#include <map>
+#include <unordered_map>
+#include <vector>
+
+namespace unicorn
+{
+namespace video
+{
+namespace vulkan
+{
+class UploadService;
+
+/**
+ * @brief Packs geometry of all meshes into a few large vertex and index buffers
+ *
+ * Geometry is placed into pages, each page has one device local vertex
+ * buffer and one index buffer. Vertex and index ranges of a mesh are
+ * sub-allocated from the same page using best fit and freed ranges are
+ * merged with their neighbours, so draws of meshes from one page share
+ * bound buffers and differ only in vertexOffset and firstIndex.
+ *
+ * Identical geometry is stored once: content of every allocation is hashed
+ * and compared with a copy of shared content on hash match, meshes with
+ * equal geometry share ranges and geometry identifier, which lets renderer
+ * draw them with a single instanced draw.
+ *
+ * Pages which became sparse and fragmented can be evacuated: owner
+ * reallocates geometry of the meshes they hold, which places it into
+ * other pages, and empty pages are destroyed.
+ */
+class GeometryArena
+{
+public:
+    //! Page index of unallocated geometry
+    static const uint32_t s_invalidPage;
+
+    //! Ranges of a mesh geometry
+    struct Allocation
+    {
+        //! Page ranges belong to, s_invalidPage if geometry is not allocated
+        uint32_t pageIndex = s_invalidPage;
+
+        //! Offset of the first vertex in vertex buffer of the page, in vertices
+        uint32_t vertexOffset = 0;
+        uint32_t vertexCount = 0;
+
+        //! Offset of the first index in index buffer of the page, in indices
+        uint32_t firstIndex = 0;
+        uint32_t indexCount = 0;
+
+        //! Identifier of geometry, equal for allocations sharing the same ranges
+        uint32_t geometryId = 0;
+
+        //! Returns true if geometry is allocated
+        bool IsValid() const { return pageIndex != s_invalidPage; }
+    };
+
+    //! Usage statistics of the arena
+    struct Stats
+    {
+        uint32_t pagesCount = 0;
+        uint32_t allocationsCount = 0;
+
+        //! Amount of allocations which reused geometry of another one
+        uint32_t sharedAllocationsCount = 0;
+
+        uint64_t usedVertices = 0;
+        uint64_t vertexCapacity = 0;
+        uint64_t usedIndices = 0;
+        uint64_t indexCapacity = 0;
+
+        //! Amount of free vertex ranges in all pages
+        uint32_t freeVertexRangesCount = 0;
+    };
+
+    /**
+     * @brief Constructs an empty arena
+     * @param[in] physicalDevice GPU for memory allocation
+     * @param[in] device device for allocation
+     * @param[in] uploadService service which uploads geometry
+     */
+    GeometryArena(vk::PhysicalDevice physicalDevice, vk::Device device, UploadService& uploadService);
+
+    /** @brief Destroys all pages */
+    ~GeometryArena();
+
+    GeometryArena(GeometryArena const& other) = delete;
+    GeometryArena(GeometryArena&& other) = delete;
+    GeometryArena& operator=(GeometryArena const& other) = delete;
+    GeometryArena& operator=(GeometryArena&& other) = delete;
+
+    /**
+     * @brief Allocates ranges for geometry and uploads it
+     *
+     * If identical geometry is already allocated its ranges are shared
+     * and nothing is uploaded
+     *
+     * @param[in] vertices vertex data
+     * @param[in] indices index data, relative to the first vertex
+     * @param[out] allocation allocated ranges
+     * @param[out] uploadToken token of geometry upload
+     * @return true if geometry was allocated, false otherwise
+     */
+    bool Allocate(std::vector<Vertex> const& vertices,
+                  std::vector<uint32_t> const& indices,
+                  Allocation& allocation,
+                  uint64_t& uploadToken);
+
+    /**
+     * @brief Returns ranges to their page when they are not shared anymore
+     *
+     * GPU must not use the ranges anymore. Page is destroyed when it
+     * becomes empty unless it is the last page
+     *
+     * @param[in,out] allocation allocated ranges, reset to invalid
+     */
+    void Free(Allocation& allocation);
+
+    /**
+     * @brief Returns vertex buffer of the page
+     * @param[in] pageIndex index of the page
+     * @return vulkan buffer
+     */
+    vk::Buffer GetVertexBuffer(uint32_t pageIndex) const;
+
+    /**
+     * @brief Returns index buffer of the page
+     * @param[in] pageIndex index of the page
+     * @return vulkan buffer
+     */
+    vk::Buffer GetIndexBuffer(uint32_t pageIndex) const;
+
+    /**
+     * @brief Marks pages which are mostly free and fragmented for evacuation
+     *
+     * Evacuated pages don't take new allocations
+     *
+     * @return true if any page has to be evacuated
+     */
+    bool MarkPagesForEvacuation();
+
+    /**
+     * @brief Checks if allocations of the page have to be moved
+     * @param[in] pageIndex index of the page
+     * @return true if page is evacuated
+     */
+    bool IsEvacuated(uint32_t pageIndex) const;
+
+    /**
+     * @brief Collects usage statistics
+     * @return current statistics
+     */
+    Stats GetStats() const;
+
+    /**
+     * @brief Returns amount of pages destroyed since creation
+     *
+     * Command buffers which bound buffers of destroyed pages can't be reused
+     *
+     * @return amount of destroyed pages
+     */
+    uint64_t GetDestroyedPagesCount() const { return m_destroyedPagesCount; }
+
+private:
+    //! Pair of buffers geometry is sub-allocated from
+    struct Page
+    {
+        Buffer vertexBuffer;
+        Buffer indexBuffer;
+        uint32_t vertexCapacity = 0;
+        uint32_t indexCapacity = 0;
+
+        //! Free ranges of vertex buffer, offset to size in vertices
+        std::map<uint32_t, uint32_t> freeVertices;
+
+        //! Free ranges of index buffer, offset to size in indices
+        std::map<uint32_t, uint32_t> freeIndices;
+
+        uint32_t allocationsCount = 0;
+        uint32_t usedVertices = 0;
+        bool isEvacuated = false;
+    };
+
+    //! Ranges shared by allocations of identical geometry
+    struct SharedGeometry
+    {
+        Allocation allocation;
+        uint64_t contentHash = 0;
+
+        //! Copy of content, hash collisions must not share ranges
+        std::vector<Vertex> vertices;
+        std::vector<uint32_t> indices;
+
+        uint64_t uploadToken = 0;
+        uint32_t referencesCount = 0;
+    };
+
+    /**
+     * @brief Computes hash of geometry content
+     * @param[in] vertices vertex data
+     * @param[in] indices index data
+     * @return 64-bit FNV-1a hash
+     */
+    static uint64_t HashGeometry(std::vector<Vertex> const& vertices, std::vector<uint32_t> const& indices);
+
+    /**
+     * @brief Compares geometry content with content of shared geometry
+     * @param[in] geometry shared geometry
+     * @param[in] vertices vertex data
+     * @param[in] indices index data
+     * @return true if content is equal
+     */
+    static bool IsSameGeometry(SharedGeometry const& geometry,
+                               std::vector<Vertex> const& vertices,
+                               std::vector<uint32_t> const& indices);
+
+    /**
+     * @brief Allocates and uploads ranges which are not shared yet
+     * @param[in] vertices vertex data
+     * @param[in] indices index data
+     * @param[out] allocation allocated ranges
+     * @param[out] uploadToken token of geometry upload
+     * @return true if geometry was allocated
+     */
+    bool AllocateRanges(std::vector<Vertex> const& vertices,
+                        std::vector<uint32_t> const& indices,
+                        Allocation& allocation,
+                        uint64_t& uploadToken);
+
+    /**
+     * @brief Returns ranges to their page, destroys the page if it becomes empty
+     * @param[in] allocation allocated ranges
+     */
+    void FreeRanges(Allocation const& allocation);
+
+    /**
+     * @brief Creates page which can hold at least given amount of geometry
+     * @param[in] vertexCount amount of vertices
+     * @param[in] indexCount amount of indices
+     * @return index of new page or s_invalidPage on failure
+     */
+    uint32_t CreatePage(uint32_t vertexCount, uint32_t indexCount);
+
+    /**
+     * @brief Takes ranges from the page
+     * @param[in] page page ranges are taken from
+     * @param[in] vertexCount amount of vertices
+     * @param[in] indexCount amount of indices
+     * @param[out] allocation taken ranges
+     * @return true if page has enough space
+     */
+    static bool TakeRanges(Page& page, uint32_t vertexCount, uint32_t indexCount, Allocation& allocation);
+
+    /**
+     * @brief Takes the smallest fitting range from free ranges
+     * @param[in,out] freeRanges free ranges, offset to size
+     * @param[in] size size of the range
+     * @param[out] offset offset of the range
+     * @return true if range was found
+     */
+    static bool TakeRange(std::map<uint32_t, uint32_t>& freeRanges, uint32_t size, uint32_t& offset);
+
+    /**
+     * @brief Returns range to free ranges merging it with neighbours
+     * @param[in,out] freeRanges free ranges, offset to size
+     * @param[in] offset offset of the range
+     * @param[in] size size of the range
+     */
+    static void ReturnRange(std::map<uint32_t, uint32_t>& freeRanges, uint32_t offset, uint32_t size);
+
+    vk::PhysicalDevice m_physicalDevice;
+    vk::Device m_device;
+    UploadService& m_uploadService;
+
+    //! Pages indexed by page index, destroyed pages are nullptr
+    std::vector<Page*> m_pages;
+
+    //! Geometries indexed by geometry identifier, unused ones have no references
+    std::vector<SharedGeometry> m_geometries;
+
+    //! Identifiers of unused entries of m_geometries
+    std::vector<uint32_t> m_freeGeometryIds;
+
+    //! Content hash to identifier of geometry which takes new references
+    std::unordered_map<uint64_t, uint32_t> m_geometryIds;
+
+    //! Amount of allocations which reused geometry of another one
+    uint32_t m_sharedAllocationsCount;
+
+    //! Amount of pages destroyed since creation
+    uint64_t m_destroyedPagesCount;
+
+    //! Amount of vertices in a page unless mesh needs more
+    static const uint32_t s_pageVertexCount;
+
+    //! Amount of indices in a page unless mesh needs more
+    static const uint32_t s_pageIndexCount;
+};
+}
+}
+}
+
+#endif // UNICORN_VIDEO_VULKAN_GEOMETRY_ARENA_HPP
@@ -7,6 +7,8 @@
 #ifndef UNICORN_VIDEO_VULKAN_MEMORY_HPP
 #define UNICORN_VIDEO_VULKAN_MEMORY_HPP
 
+#include <unicorn/video/vulkan/MemoryAllocator.hpp>
+
 #include <vulkan/vulkan.hpp>
 
 namespace unicorn
@@ -16,26 +18,25 @@ namespace video
 namespace vulkan
 {
 /**
-* @brief Wrapper for vk::DeviceMemory item in Vulkan API
+* @brief Range of device memory sub-allocated by MemoryAllocator
 */
 class Memory
 {
 public:
     /**
      * @brief Creates object and allocates memory on device
-     * @param device device for allocation
-     * @param typeFilter bit field describing suitable memory types in @p physMemProperties
-     * @param physMemProperties properties of memory on physical device
-     * @param reqMemProperties required memory properties
-     * @param allocSize size of allocation
+     * @param allocator allocator memory is taken from
+     * @param requirements memory requirements of the resource
+     * @param usage how memory is accessed, memory type is picked from it
+     * @param isLinear true for buffers, false for optimal tiling images
      */
-    Memory(vk::Device device, uint32_t typeFilter,
-           vk::PhysicalDeviceMemoryProperties physMemProperties,
-           vk::MemoryPropertyFlagBits reqMemProperties,
-           uint64_t allocSize);
+    Memory(MemoryAllocator& allocator,
+           vk::MemoryRequirements const& requirements,
+           MemoryUsage usage,
+           bool isLinear);
 
     /**
-     * @brief Frees memory
+     * @brief Returns memory to allocator
      */
     ~Memory();
 
@@ -51,26 +52,43 @@ public:
     bool IsInitialized() const;
 
     /**
-     * @brief Allocates memory on device
-     * @param device device for allocation
-     * @param typeFilter bit field of memory types that are suitable
-     * @param physMemProperties properties of memory on physical device 
-     * @param reqMemProperties required memory properties
-     * @param allocSize size of allocation
-     * @return result of allocation
+     * @brief Returns reference to vk::DeviceMemory
+     * @return reference to vk::DeviceMemory of the block memory belongs to
      */
-    vk::Result Allocate(vk::Device device, uint32_t typeFilter, vk::PhysicalDeviceMemoryProperties physMemProperties,
-                        vk::MemoryPropertyFlagBits reqMemProperties, uint64_t allocSize);
+    const vk::DeviceMemory& GetMemory() const;
 
     /**
-     * @brief Returns reference to vk::DeviceMemory
-     * @return reference to vk::DeviceMemory
+     * @brief Returns offset of memory in vk::DeviceMemory
+     * @return offset in bytes
      */
-    const vk::DeviceMemory& GetMemory() const;
+    vk::DeviceSize GetOffset() const;
+
+    /**
+     * @brief Returns mapped pointer to memory
+     * @return pointer or nullptr if memory is not host visible
+     */
+    void* GetMappedData() const;
+
+    /**
+     * @brief Makes host writes visible to device
+     */
+    void Flush() const;
+
+    /**
+     * @brief Makes host writes to part of memory visible to device
+     * @param offset offset of written bytes
+     * @param size amount of written bytes
+     */
+    void Flush(vk::DeviceSize offset, vk::DeviceSize size) const;
+
+    /**
+     * @brief Makes device writes visible to host
+     */
+    void Invalidate() const;
 private:
     bool m_initialized;
-    vk::Device m_device;
-    vk::DeviceMemory m_memory;
+    MemoryAllocator& m_allocator;
+    MemoryAllocator::Allocation m_allocation;
 };
 }
 }
@@ -0,0 +1,347 @@
+/*
+* Copyright (C) 2017 by Godlike
+* This code is licensed under the MIT license (MIT)
+* (http://opensource.org/licenses/MIT)
+*/
+
+#ifndef UNICORN_VIDEO_VULKAN_MEMORY_ALLOCATOR_HPP
+#define UNICORN_VIDEO_VULKAN_MEMORY_ALLOCATOR_HPP
+
+#include <vulkan/vulkan.hpp>
+
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <vector>
+
+namespace unicorn
+{
+namespace video
+{
+namespace vulkan
+{
+/**
+ * @brief Describes how resource memory is accessed, memory type is picked from it
+ */
+enum class MemoryUsage
+{
+    //! Static geometry and textures, only GPU accesses them
+    GpuOnly,
+
+    //! Staging data written once by CPU and consumed by transfer commands
+    Upload,
+
+    //! Data rewritten by CPU every frame and read by shaders, e.g. uniforms
+    Dynamic,
+
+    //! Data written by GPU and read back by CPU
+    Readback
+};
+
+/**
+ * @brief Sub-allocates device memory from large blocks
+ *
+ * Every memory type has its own set of blocks, resources are placed into
+ * free ranges of a block using best fit and freed ranges are merged with
+ * their neighbours. Linear (buffers) and optimal (images) resources never
+ * share a block, so bufferImageGranularity never has to be accounted for.
+ * Resources larger than half of a block get dedicated device memory.
+ *
+ * Blocks of host visible memory are persistently mapped.
+ *
+ * Memory type is picked by MemoryUsage: memory types are ranked by how well
+ * their properties fit the usage and types of heaps which are out of
+ * budget are skipped while there are alternatives. Budget is reported by
+ * driver when VK_EXT_memory_budget is enabled, otherwise it is estimated
+ * from heap size and memory allocated by this allocator.
+ *
+ * Allocator is registered for its logical device, so resources which only
+ * know the device can find it with Find()
+ */
+class MemoryAllocator
+{
+public:
+    //! Sub-allocated range of device memory
+    struct Allocation
+    {
+        //! Device memory of the block range belongs to
+        vk::DeviceMemory memory;
+
+        //! Offset of the range in the block
+        vk::DeviceSize offset = 0;
+
+        //! Size of the range
+        vk::DeviceSize size = 0;
+
+        //! Mapped pointer to the beginning of the range or nullptr if memory is not host visible
+        void* pMappedData = nullptr;
+
+        //! Internal block handle
+        void* pBlock = nullptr;
+    };
+
+    //! Budget of a memory heap
+    struct HeapBudget
+    {
+        //! Size of the heap
+        vk::DeviceSize size = 0;
+
+        //! Amount of memory the process can use without performance penalty
+        vk::DeviceSize budget = 0;
+
+        //! Amount of memory the process currently uses
+        vk::DeviceSize usage = 0;
+
+        //! Amount of memory allocated by this allocator
+        vk::DeviceSize allocatedBytes = 0;
+
+        //! True if heap is device local
+        bool isDeviceLocal = false;
+    };
+
+    //! Usage statistics of the allocator
+    struct Stats
+    {
+        //! Amount of device memory allocations made by allocator
+        uint32_t blocksCount = 0;
+
+        //! Amount of blocks which hold a single dedicated resource
+        uint32_t dedicatedBlocksCount = 0;
+
+        //! Amount of live sub-allocations
+        uint32_t allocationsCount = 0;
+
+        //! Total size of allocated device memory
+        vk::DeviceSize allocatedBytes = 0;
+
+        //! Size of memory occupied by sub-allocations
+        vk::DeviceSize usedBytes = 0;
+
+        //! Amount of free ranges in all blocks
+        uint32_t freeRangesCount = 0;
+
+        //! Size of the largest free range
+        vk::DeviceSize largestFreeRange = 0;
+
+        /**
+         * @brief Returns fragmentation of free memory
+         * @return value in range [0, 1], 0 when all free memory is a single range
+         */
+        float GetFragmentation() const;
+    };
+
+    /**
+     * @brief Constructs the allocator and registers it for @p device
+     * @param[in] instance instance @p physicalDevice belongs to
+     * @param[in] physicalDevice physical device memory properties are taken from
+     * @param[in] device logical device memory is allocated on
+     * @param[in] hasMemoryBudget true if VK_EXT_memory_budget is enabled on @p device
+     */
+    MemoryAllocator(vk::Instance instance, vk::PhysicalDevice physicalDevice, vk::Device device, bool hasMemoryBudget);
+
+    /** @brief Frees all blocks and unregisters the allocator */
+    ~MemoryAllocator();
+
+    MemoryAllocator(MemoryAllocator const& other) = delete;
+    MemoryAllocator(MemoryAllocator&& other) = delete;
+    MemoryAllocator& operator=(MemoryAllocator const& other) = delete;
+    MemoryAllocator& operator=(MemoryAllocator&& other) = delete;
+
+    /**
+     * @brief Returns allocator registered for @p device
+     * @param[in] device logical device
+     * @return pointer to allocator or nullptr if there is none
+     */
+    static MemoryAllocator* Find(vk::Device device);
+
+    /**
+     * @brief Allocates memory range for a resource
+     * @param[in] requirements memory requirements of the resource
+     * @param[in] usage how memory is accessed
+     * @param[in] isLinear true for buffers and linear images, false for optimal images
+     * @param[out] allocation allocated range
+     * @return true if memory was allocated, false otherwise
+     */
+    bool Allocate(vk::MemoryRequirements const& requirements,
+                  MemoryUsage usage,
+                  bool isLinear,
+                  Allocation& allocation);
+
+    /**
+     * @brief Returns memory range to the allocator
+     * @param[in] allocation range received from Allocate()
+     */
+    void Free(Allocation const& allocation);
+
+    /**
+     * @brief Flushes host writes to non-coherent memory
+     * @param[in] allocation range received from Allocate()
+     */
+    void Flush(Allocation const& allocation) const;
+
+    /**
+     * @brief Flushes host writes to part of non-coherent memory
+     * @param[in] allocation range received from Allocate()
+     * @param[in] offset offset of written bytes in the allocation
+     * @param[in] size amount of written bytes
+     */
+    void Flush(Allocation const& allocation, vk::DeviceSize offset, vk::DeviceSize size) const;
+
+    /**
+     * @brief Makes device writes to non-coherent memory visible to host
+     * @param[in] allocation range received from Allocate()
+     */
+    void Invalidate(Allocation const& allocation) const;
+
+    /**
+     * @brief Collects usage statistics
+     * @return current statistics
+     */
+    Stats GetStats() const;
+
+    /**
+     * @brief Returns budgets of all memory heaps
+     * @return budgets indexed by heap index
+     */
+    std::vector<HeapBudget> GetHeapBudgets() const;
+
+    //! Returns logical device of the allocator
+    vk::Device GetDevice() const { return m_device; }
+
+private:
+    //! Block of device memory ranges are taken from
+    struct Block
+    {
+        vk::DeviceMemory memory;
+        vk::DeviceSize size;
+        uint32_t memoryTypeIndex;
+        bool isLinear;
+        bool isDedicated;
+        bool isCoherent;
+        void* pMappedData;
+
+        //! Free ranges of the block, offset to size
+        std::map<vk::DeviceSize, vk::DeviceSize> freeRanges;
+
+        //! Amount of live sub-allocations
+        uint32_t allocationsCount;
+    };
+
+    /**
+     * @brief Ranks memory types suitable for the usage
+     * @param[in] typeFilter bit field of suitable memory types
+     * @param[in] usage how memory is accessed
+     * @return indices of suitable memory types, the best one first
+     */
+    std::vector<uint32_t> RankMemoryTypes(uint32_t typeFilter, MemoryUsage usage) const;
+
+    /**
+     * @brief Sub-allocates range from memory of given type
+     * @param[in] memoryTypeIndex memory type
+     * @param[in] requirements memory requirements of the resource
+     * @param[in] isLinear kind of the resource
+     * @param[in] ignoreBudget allows new blocks in heaps which are out of budget
+     * @param[out] allocation allocated range
+     * @return true if memory was allocated
+     */
+    bool AllocateFromType(uint32_t memoryTypeIndex,
+                          vk::MemoryRequirements const& requirements,
+                          bool isLinear,
+                          bool ignoreBudget,
+                          Allocation& allocation);
+
+    /**
+     * @brief Checks if heap can hold @p size more bytes within its budget
+     * @param[in] heapIndex memory heap
+     * @param[in] size amount of bytes to be allocated
+     * @return true if allocation fits into the budget
+     */
+    bool FitsBudget(uint32_t heapIndex, vk::DeviceSize size);
+
+    /**
+     * @brief Updates heap budgets reported by the driver
+     */
+    void UpdateBudget();
+
+    /**
+     * @brief Allocates new device memory block
+     * @param[in] memoryTypeIndex memory type of the block
+     * @param[in] size size of the block
+     * @param[in] isLinear kind of resources the block is used for
+     * @param[in] isDedicated true if block holds a single resource
+     * @return pointer to new block or nullptr if allocation failed
+     */
+    Block* CreateBlock(uint32_t memoryTypeIndex, vk::DeviceSize size, bool isLinear, bool isDedicated);
+
+    /**
+     * @brief Frees device memory of the block and deletes it
+     * @param[in] pBlock block to destroy
+     */
+    void DestroyBlock(Block* pBlock);
+
+    /**
+     * @brief Takes a range from free ranges of the block
+     * @param[in] block block range is taken from
+     * @param[in] size size of the range
+     * @param[in] alignment alignment of the range offset
+     * @param[out] offset offset of the range
+     * @return true if block has enough space
+     */
+    static bool TakeRange(Block& block, vk::DeviceSize size, vk::DeviceSize alignment, vk::DeviceSize& offset);
+
+    /**
+     * @brief Returns range to free ranges of the block merging it with neighbours
+     * @param[in] block block range belongs to
+     * @param[in] offset offset of the range
+     * @param[in] size size of the range
+     */
+    static void ReturnRange(Block& block, vk::DeviceSize offset, vk::DeviceSize size);
+
+    /**
+     * @brief Builds memory range for flushing and invalidating
+     * @param[in] allocation allocated range
+     * @return range aligned to nonCoherentAtomSize
+     */
+    vk::MappedMemoryRange GetMappedRange(Allocation const& allocation) const;
+
+    /**
+     * @brief Builds memory range covering part of allocation for flushing
+     * @param[in] allocation allocated range
+     * @param[in] offset offset in the allocation
+     * @param[in] size size of the part
+     * @return range aligned to nonCoherentAtomSize
+     */
+    vk::MappedMemoryRange GetMappedRange(Allocation const& allocation, vk::DeviceSize offset, vk::DeviceSize size) const;
+
+    vk::PhysicalDevice m_physicalDevice;
+    vk::Device m_device;
+    vk::PhysicalDeviceMemoryProperties m_memoryProperties;
+    vk::DeviceSize m_nonCoherentAtomSize;
+
+    //! Preferred block size for each memory heap
+    std::vector<vk::DeviceSize> m_blockSizes;
+
+    std::vector<Block*> m_blocks;
+
+    //! Budgets of memory heaps indexed by heap index
+    std::vector<HeapBudget> m_heapBudgets;
+
+    //! Queries budgets from the driver, nullptr if VK_EXT_memory_budget is not enabled
+    PFN_vkGetPhysicalDeviceMemoryProperties2KHR m_getMemoryProperties2;
+
+    //! True if usage of static resources had to fall back to host memory
+    bool m_hasReportedFallback;
+
+    mutable std::mutex m_mutex;
+
+    //! Size of a block unless memory heap is too small for it
+    static const vk::DeviceSize s_blockSize;
+
+    //! Share of heap size used as a budget when driver doesn't report it, in percents
+    static const vk::DeviceSize s_estimatedBudgetPercent;
+};
+}
+}
+}
+
+#endif // UNICORN_VIDEO_VULKAN_MEMORY_ALLOCATOR_HPP
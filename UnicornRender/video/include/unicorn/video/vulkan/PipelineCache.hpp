@@ -0,0 +1,113 @@
+/*
+* Copyright (C) 2017 by Godlike
+* This code is licensed under the MIT license (MIT)
+* (http://opensource.org/licenses/MIT)
+*/
+
+#ifndef UNICORN_VIDEO_VULKAN_PIPELINE_CACHE_HPP
+#define UNICORN_VIDEO_VULKAN_PIPELINE_CACHE_HPP
+
+#include <vulkan/vulkan.hpp>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace unicorn
+{
+namespace video
+{
+namespace vulkan
+{
+/**
+ * @brief Vulkan pipeline cache which persists between application runs
+ *
+ * Cache data is stored in a file with a versioned header keyed by
+ * vendor, device, driver version and pipeline cache UUID of the device.
+ * File written by a different device or driver is ignored and the cache
+ * starts empty, so stale data never reaches the driver
+ */
+class PipelineCache
+{
+public:
+    /**
+     * @brief Constructs empty cache
+     *
+     * @param[in] device device to create cache on
+     * @param[in] properties properties of physical device of @p device
+     */
+    PipelineCache(vk::Device device, vk::PhysicalDeviceProperties const& properties);
+
+    /** @brief Calls Destroy() */
+    ~PipelineCache();
+
+    PipelineCache(PipelineCache const& other) = delete;
+    PipelineCache& operator=(PipelineCache const& other) = delete;
+
+    /**
+     * @brief Creates cache seeded with data of the file
+     *
+     * Missing or mismatching file is not an error, cache is created empty
+     *
+     * @param[in] path path of cache file, empty path disables persistence
+     * @return true if cache was created, false otherwise
+     */
+    bool Create(std::string const& path);
+
+    /**
+     * @brief Writes cache data into the file
+     *
+     * Data is written into a temporary file which replaces the old one,
+     * so interrupted write doesn't corrupt existing cache
+     *
+     * @return true if data was written or persistence is disabled, false otherwise
+     */
+    bool Save() const;
+
+    /** @brief Saves and destroys the cache */
+    void Destroy();
+
+    //! Returns cache handle, null handle if cache is not created
+    vk::PipelineCache GetCache() const { return m_cache; }
+
+private:
+    //! Header of cache file, followed by cache data
+    struct FileHeader
+    {
+        uint32_t magic;
+        uint32_t version;
+        uint32_t vendorId;
+        uint32_t deviceId;
+        uint32_t driverVersion;
+        uint8_t uuid[VK_UUID_SIZE];
+        uint64_t dataSize;
+        uint64_t dataHash;
+    };
+
+    //! Identifies cache files
+    static const uint32_t s_magic;
+    //! Changes whenever layout of cache file changes
+    static const uint32_t s_version;
+
+    vk::Device m_device;
+    vk::PhysicalDeviceProperties m_properties;
+    vk::PipelineCache m_cache;
+    std::string m_path;
+
+    //! Fills header of data written by the device
+    FileHeader MakeHeader(std::vector<uint8_t> const& data) const;
+
+    /**
+     * @brief Reads data of cache file
+     * @param[out] data cache data, empty if file is missing or doesn't match the device
+     */
+    void Load(std::vector<uint8_t>& data) const;
+
+    //! Checks if data begins with Vulkan cache header of the device
+    bool IsDeviceData(std::vector<uint8_t> const& data) const;
+};
+}
+}
+}
+
+#endif // UNICORN_VIDEO_VULKAN_PIPELINE_CACHE_HPP
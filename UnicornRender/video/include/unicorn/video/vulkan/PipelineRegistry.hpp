@@ -0,0 +1,154 @@
+/*
+* Copyright (C) 2017 by Godlike
+* This code is licensed under the MIT license (MIT)
+* (http://opensource.org/licenses/MIT)
+*/
+
+#ifndef UNICORN_VIDEO_VULKAN_PIPELINE_REGISTRY_HPP
+#define UNICORN_VIDEO_VULKAN_PIPELINE_REGISTRY_HPP
+
+#include <unicorn/video/vulkan/ShaderProgram.hpp>
+
+#include <vulkan/vulkan.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace unicorn
+{
+namespace video
+{
+namespace vulkan
+{
+/**
+ * @brief Fixed function state and shaders of a graphics pipeline
+ *
+ * State which is set dynamically by command buffers is not part of
+ * the description, pipelines created for it may use any value
+ */
+struct PipelineState
+{
+    //! Shader variant registered with PipelineRegistry::AddShaderVariant()
+    uint32_t shaderVariant = 0;
+    //! Specialization of the shader variant
+    MaterialShading shading = MaterialShading::Dynamic;
+    vk::PrimitiveTopology topology = vk::PrimitiveTopology::eTriangleList;
+    vk::PolygonMode polygonMode = vk::PolygonMode::eFill;
+    vk::CullModeFlagBits cullMode = vk::CullModeFlagBits::eNone;
+    bool isDepthTest = true;
+    bool isDepthWrite = true;
+    bool isBlend = true;
+
+    bool operator==(PipelineState const& other) const;
+    bool operator!=(PipelineState const& other) const { return !(*this == other); }
+
+    //! Returns hash of the description
+    size_t Hash() const;
+
+    struct Hasher
+    {
+        size_t operator()(PipelineState const& state) const { return state.Hash(); }
+    };
+};
+
+/**
+ * @brief Creates graphics pipelines on first request and keeps them for reuse
+ *
+ * Pipelines are looked up by hashed state description. Shader programs
+ * of variants are loaded when the first pipeline using them is created.
+ * Viewport and scissor are always dynamic, other dynamic states are
+ * passed on construction
+ */
+class PipelineRegistry
+{
+public:
+    /**
+     * @brief Constructs empty registry
+     *
+     * @param[in] device device to create pipelines on
+     * @param[in] pipelineCache cache to create pipelines with
+     * @param[in] pipelineLayout layout of all pipelines
+     * @param[in] dynamicStates states set by command buffers besides viewport and scissor
+     */
+    PipelineRegistry(vk::Device device, vk::PipelineCache pipelineCache, vk::PipelineLayout pipelineLayout,
+        std::vector<vk::DynamicState> const& dynamicStates);
+
+    /** @brief Destroys all pipelines and shader programs */
+    ~PipelineRegistry();
+
+    PipelineRegistry(PipelineRegistry const& other) = delete;
+    PipelineRegistry& operator=(PipelineRegistry const& other) = delete;
+
+    /**
+     * @brief Registers shaders of a variant
+     *
+     * @param[in] variant identifier used in PipelineState::shaderVariant
+     * @param[in] vertShaderPath path to vertex shader
+     * @param[in] fragShaderPath path to fragment shader
+     */
+    void AddShaderVariant(uint32_t variant, std::string const& vertShaderPath, std::string const& fragShaderPath);
+
+    /**
+     * @brief Sets render pass new pipelines are created for
+     *
+     * Existing pipelines stay valid for compatible render passes. Attachments
+     * of renderer passes differ only by formats, so pipelines are destroyed
+     * when formats change
+     *
+     * @param[in] renderPass render pass pipelines are used in
+     * @param[in] colorFormat format of color attachment
+     * @param[in] depthFormat format of depth attachment
+     */
+    void SetRenderPass(vk::RenderPass renderPass, vk::Format colorFormat, vk::Format depthFormat);
+
+    /**
+     * @brief Returns pipeline of the state, creates it on first request
+     *
+     * @param[in] state state description
+     * @return pipeline or null handle if it can't be created
+     */
+    vk::Pipeline Get(PipelineState const& state);
+
+    /** @brief Destroys all pipelines, GPU must not use them anymore */
+    void Clear();
+
+    //! Returns amount of created pipelines
+    size_t GetPipelinesCount() const { return m_pipelines.size(); }
+
+private:
+    struct ShaderVariantEntry
+    {
+        std::string vertShaderPath;
+        std::string fragShaderPath;
+        //! Loaded on first use
+        ShaderProgram* pShaderProgram = nullptr;
+    };
+
+    vk::Device m_device;
+    vk::PipelineCache m_pipelineCache;
+    vk::PipelineLayout m_pipelineLayout;
+    std::vector<vk::DynamicState> m_dynamicStates;
+
+    vk::RenderPass m_renderPass;
+    vk::Format m_colorFormat;
+    vk::Format m_depthFormat;
+
+    //! Shader variants indexed by identifier
+    std::vector<ShaderVariantEntry> m_shaderVariants;
+
+    std::unordered_map<PipelineState, vk::Pipeline, PipelineState::Hasher> m_pipelines;
+
+    //! Returns shader program of the variant, loads it on first use
+    ShaderProgram* GetShaderProgram(uint32_t variant);
+
+    //! Creates pipeline of the state
+    vk::Pipeline CreatePipeline(PipelineState const& state, ShaderProgram& shaderProgram) const;
+};
+}
+}
+}
+
+#endif // UNICORN_VIDEO_VULKAN_PIPELINE_REGISTRY_HPP
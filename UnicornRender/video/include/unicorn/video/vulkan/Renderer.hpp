@@ -12,10 +12,14 @@
 #include <unicorn/video/vulkan/Image.hpp>
 #include <unicorn/video/vulkan/VkTexture.hpp>
 #include <unicorn/video/vulkan/Context.hpp>
+#include <unicorn/video/vulkan/ShaderProgram.hpp>
+#include <unicorn/video/vulkan/FrustumCuller.hpp>
+#include <unicorn/utility/RadixSort.hpp>
+#include <unicorn/utility/SlotMap.hpp>
 
 #include <vulkan/vulkan.hpp>
 
-#include <list>
+#include <unordered_map>
 #include <vector>
 #include <functional>
 
@@ -27,6 +31,11 @@ class Manager;
 class Window;
 }
 
+namespace utility
+{
+class WorkerPool;
+}
+
 namespace video
 {
 namespace vulkan
@@ -38,6 +47,8 @@ struct QueueFamilyIndices
 {
     int32_t graphicsFamily = -1;
     int32_t presentFamily = -1;
+    //! Dedicated transfer family if device has one, graphics family otherwise
+    int32_t transferFamily = -1;
 
     /**
      * @brief Checks if all needed family indices are exists.
@@ -61,15 +72,139 @@ struct UniformCameraData
     glm::mat4 projection = glm::mat4();
 };
 
-/** @brief Struct which holds all models uniform data for sending to shader */
-struct UniformAllMeshesData
+/**
+ * @brief Meshes drawn with a single instanced draw
+ *
+ * Each group has one entry in the indirect buffer. Hidden meshes stay in
+ * the group and are skipped by frustum culling, so hiding a mesh doesn't
+ * change groups
+ */
+struct DrawGroup
 {
-    glm::mat4* model = nullptr;
+    //! Index of the first instance in the draw list and in the visible instance buffer
+    uint32_t firstInstance = 0;
+    //! Amount of visible instances
+    uint32_t instanceCount = 0;
+};
+
+/** @brief Draw groups sharing bound state, recorded as indirect draws of consecutive commands */
+struct DrawBatch
+{
+    vk::Pipeline pipeline;
+    vk::Buffer vertexBuffer;
+    vk::Buffer indexBuffer;
+    vk::DescriptorSet materialDescriptorSet;
+    //! Index of the first command in the indirect buffer
+    uint32_t firstCommand = 0;
+    //! Amount of commands
+    uint32_t commandCount = 0;
+
+    bool operator==(DrawBatch const& other) const;
+    bool operator!=(DrawBatch const& other) const { return !(*this == other); }
+};
+
+/** @brief Amount of commands recorded into secondary command buffers */
+struct DrawCounters
+{
+    uint32_t pipelineBinds = 0;
+    //! Vertex and index buffer binds
+    uint32_t vertexBufferBinds = 0;
+    uint32_t descriptorSetBinds = 0;
+    uint32_t drawCalls = 0;
+    //! Binds which were not recorded because the state was already bound
+    uint32_t skippedBinds = 0;
+
+    DrawCounters& operator+=(DrawCounters const& other);
+};
+
+/**
+ * @brief Resources owned by a single frame in flight
+ *
+ * GPU may still read resources of one frame while CPU updates another,
+ * so every frame has its own synchronization primitives, uniform buffers
+ * and transient command buffer which is recorded anew every frame.
+ * Draws are recorded into secondary command buffers which read draw
+ * parameters from the indirect buffer, they are reused while bound state
+ * of the scene doesn't change
+ */
+struct FrameData
+{
+    //! Signaled when GPU finishes processing of the frame
+    vk::Fence inFlightFence;
+    //! Signaled when swapchain image is acquired
+    vk::Semaphore imageAvailableSemaphore;
+    //! Signaled when rendering is finished and image can be presented
+    vk::Semaphore renderFinishedSemaphore;
+    //! Camera data of the frame
+    Buffer uniformViewProjection;
+    //! Per instance data of the frame indexed by instance slots, read by frustum culling
+    Buffer instanceBuffer;
+    //! Instance slots whose data in instanceBuffer is outdated
+    std::vector<uint32_t> dirtyInstanceSlots;
+    //! Marks instance slots which are listed in dirtyInstanceSlots
+    std::vector<uint8_t> isInstanceSlotDirty;
+    //! Culling data of the frame indexed by draw list positions
+    Buffer cullingBuffer;
+    //! Instances which passed frustum culling, read by vertex shader through mvpDescriptorSet
+    Buffer visibleInstanceBuffer;
+    //! Amount of instances which fit into instance buffers
+    size_t instanceCapacity = 0;
+    //! Counters of frustum culling, read after frame fence is signaled
+    Buffer cullingCountersBuffer;
+    //! Shows if cullingCountersBuffer receives counters of submitted frame
+    bool isCullingPending = false;
+    //! Indexed indirect draw commands of the frame, one for each draw group
+    Buffer indirectBuffer;
+    //! Draw list ranges of indirect commands, read by frustum culling
+    Buffer cullingGroupBuffer;
+    //! Amount of commands which fit into indirectBuffer and cullingGroupBuffer
+    size_t indirectCapacity = 0;
+    //! Descriptor set pointing to frame uniform buffer and visible instances
+    vk::DescriptorSet mvpDescriptorSet;
+    //! Transient pool which is reset when frame is recorded
+    vk::CommandPool commandPool;
+    //! Primary command buffer of the frame
+    vk::CommandBuffer commandBuffer;
+    //! Command pools of recording workers, one pool per worker
+    std::vector<vk::CommandPool> workerCommandPools;
+    //! Secondary command buffers, allocated from workerCommandPools with the same index
+    std::vector<vk::CommandBuffer> secondaryCommandBuffers;
+    //! Amount of secondary command buffers holding recorded draws
+    size_t recordedChunksCount = 0;
+    //! Batches recorded into secondary command buffers
+    std::vector<DrawBatch> recordedBatches;
+    //! First instances of recorded draw groups, used if indirect draws can't set first instance
+    std::vector<uint32_t> recordedFirstInstances;
+    //! Shows if secondary command buffers hold valid draws
+    bool hasRecordedDraws = false;
+    //! Commands recorded into secondary command buffers
+    DrawCounters recordedCounters;
+    //! Meshes deleted while frame was in flight, released after its fence is signaled
+    std::vector<VkMesh*> deletedMeshes;
+    //! Materials replaced while frame was in flight, released after its fence is signaled
+    std::vector<std::shared_ptr<VkMaterial>> releasedMaterials;
+    //! Geometry replaced while frame was in flight, freed after its fence is signaled
+    std::vector<GeometryArena::Allocation> releasedGeometry;
+    //! Host visible copy of rendered image, used only by headless renderer
+    Buffer readbackBuffer;
+    //! Shows if readbackBuffer receives image of submitted frame
+    bool isReadbackPending = false;
+    //! Shows if timestamp queries of the frame receive times of submitted frame
+    bool isTimestampPending = false;
+    //! Sequential number of the last frame submitted with this data
+    uint64_t frameIndex = 0;
+    //! Upload batch the frame waits on, released after its fence is signaled
+    uint64_t uploadToken = 0;
 };
 
-class ShaderProgram;
 class UniformObject;
 class Image;
+class UploadService;
+class GeometryArena;
+class DescriptorAllocator;
+class PipelineCache;
+class PipelineRegistry;
+struct PipelineState;
 
 /** @brief Vulkan renderer backend */
 class Renderer : public video::Renderer
@@ -83,6 +218,19 @@ public:
      */
     Renderer(system::Manager& manager, system::Window* window, Camera const& camera);
 
+    /**
+     * @brief Constructs and initializes new headless renderer instance
+     *
+     * Headless renderer draws into offscreen images and reads
+     * every frame back to CPU memory instead of presenting it
+     *
+     * @param[in] manager Describes required extensions
+     * @param[in] width width of rendered images
+     * @param[in] height height of rendered images
+     * @param[in] camera main camera
+     */
+    Renderer(system::Manager& manager, uint32_t width, uint32_t height, Camera const& camera);
+
     /**
      * @brief Destructor which calls Deinit()
      */
@@ -99,6 +247,8 @@ public:
     bool RecreateSwapChain();
     bool AddMesh(Mesh* mesh) override;
     bool DeleteMesh(Mesh const* pMesh) override;
+    bool AddMeshes(std::vector<Mesh*> const& meshes) override;
+    bool DeleteMeshes(std::vector<Mesh*> const& meshes) override;
     void SetDepthTest(bool enabled) override;
 
 private:
@@ -107,101 +257,310 @@ private:
     vk::SwapchainKHR m_vkSwapChain;
     vk::Queue m_graphicsQueue;
     vk::Queue m_presentQueue;
+    vk::Queue m_transferQueue;
     vk::SurfaceKHR m_vkWindowSurface;
     vk::Format m_swapChainImageFormat;
     vk::Format m_depthImageFormat;
     vk::Extent2D m_swapChainExtent;
     vk::PipelineLayout m_pipelineLayout;
     vk::RenderPass m_renderPass;
-    vk::CommandPool m_commandPool;
-    vk::Semaphore m_imageAvailableSemaphore;
-    vk::Semaphore m_renderFinishedSemaphore;
-    vk::DescriptorPool m_descriptorPool;
+    //! Allocates frame and material descriptor sets
+    DescriptorAllocator* m_pDescriptorAllocator;
     vk::PhysicalDeviceProperties m_physicalDeviceProperties;
     std::string m_gpuName;
     std::vector<vk::Image> m_swapChainImages;
     std::vector<vk::ImageView> m_swapChainImageViews;
     std::vector<vk::Framebuffer> m_swapChainFramebuffers;
-    std::vector<vk::CommandBuffer> m_commandBuffers;
     vk::PhysicalDeviceFeatures m_deviceFeatures;
-    vk::PipelineCache pipelineCache;
-
-    struct
-    {
-        vk::Pipeline solid;
-        vk::Pipeline wired;
-    } m_pipelines;
+    //! Pipeline cache persisted between runs, used by all pipelines of the renderer
+    PipelineCache* m_pPipelineCache;
+    //! Graphics pipelines of all states draws were recorded with
+    PipelineRegistry* m_pPipelineRegistry;
 
-    std::list<VkMesh*> m_vkMeshes;
+    //! Meshes of the renderer, stored densely
+    utility::SlotMap<VkMesh*> m_vkMeshes;
+    //! Handles in m_vkMeshes by rendered mesh
+    std::unordered_map<Mesh const*, utility::SlotHandle> m_meshHandles;
+    //! Valid meshes which are recorded into current frame, sorted by draw sort keys
+    std::vector<VkMesh*> m_drawList;
+    //! Valid meshes of the current frame before sorting
+    std::vector<VkMesh*> m_unsortedDrawList;
+    //! Sort keys of m_unsortedDrawList
+    std::vector<utility::SortItem> m_drawSortItems;
+    //! Scratch memory of draw list sorting
+    std::vector<utility::SortItem> m_drawSortBuffer;
+    //! Instanced draws of the current frame, each covers a range of m_drawList
+    std::vector<DrawGroup> m_drawGroups;
+    //! Draw groups of the current frame grouped by bound state
+    std::vector<DrawBatch> m_drawBatches;
+    //! Indirect commands of m_drawGroups, instance counts are written by frustum culling
+    std::vector<vk::DrawIndexedIndirectCommand> m_indirectCommands;
     Image* m_pDepthImage;
+    //! Color targets of headless renderer, one for each frame in flight
+    std::vector<Image*> m_offscreenImages;
+    //! Color targets scene is rendered into with dynamic resolution, one for each frame in flight
+    std::vector<Image*> m_sceneImages;
+    //! Size of the area scene is rendered into, equals swapchain extent without dynamic resolution
+    vk::Extent2D m_renderExtent;
+    //! Filter scene images are upscaled with
+    vk::Filter m_upscaleFilter;
+    //! Start and end timestamps of every frame in flight, null handle if device has no timestamps
+    vk::QueryPool m_timestampQueryPool;
+    //! Nanoseconds per timestamp tick
+    float m_timestampPeriod;
+    //! Valid bits of timestamps
+    uint64_t m_timestampMask;
     std::shared_ptr<VkMaterial> m_pReplaceMeMaterial;
 
-    std::list<std::weak_ptr<VkMaterial>> m_materials;
+    //! Material shared by meshes with the same albedo texture
+    struct MaterialEntry
+    {
+        //! Identifier of the texture
+        uint32_t handle;
+        std::weak_ptr<VkMaterial> pMaterial;
+    };
+
+    //! Materials created by the renderer, entries of expired ones are removed by RemoveExpiredMaterials()
+    std::vector<MaterialEntry> m_materials;
+    //! Indices in m_materials by texture identifier
+    std::unordered_map<uint32_t, size_t> m_materialIndices;
 
     std::array<vk::DescriptorSetLayout, 2> m_descriptorSetLayouts; // 0 - mvp, 1 - albedo
-    vk::DescriptorSet m_mvpDescriptorSet;
 
-    ShaderProgram* m_shaderProgram;
-    Buffer m_uniformViewProjection;
-    Buffer m_uniformModel;
-    size_t m_dynamicAlignment;
-    UniformAllMeshesData m_uniformModelsData;
+    //! Pool of bindless texture array, its set may be updated while bound
+    vk::DescriptorPool m_bindlessDescriptorPool;
+    //! Textures of all materials, used instead of per material sets in bindless mode
+    vk::DescriptorSet m_bindlessDescriptorSet;
+    //! Amount of textures which fit into bindless texture array
+    uint32_t m_bindlessCapacity;
+    //! Amount of bindless texture indices ever acquired
+    uint32_t m_bindlessTextureCount;
+    //! Bindless texture indices released by destroyed materials
+    std::vector<uint32_t> m_freeTextureIndices;
+
+    //! Per frame resources, one entry for each frame in flight
+    std::vector<FrameData> m_frames;
+    //! Index of frame in m_frames which is being prepared by CPU
+    uint32_t m_currentFrame;
+    //! Threads recording secondary command buffers
+    utility::WorkerPool* m_pWorkerPool;
+    //! Sub-allocates device memory for buffers and images of the renderer
+    MemoryAllocator* m_pMemoryAllocator;
+    //! Batches geometry and texture uploads
+    UploadService* m_pUploadService;
+    //! Holds geometry of all meshes
+    GeometryArena* m_pGeometryArena;
+
+    //! Per instance data of all meshes indexed by instance slots, copied into instance buffers when changed
+    std::vector<InstanceData> m_instanceData;
+    //! Mesh of each instance slot, @c nullptr for free slots
+    std::vector<VkMesh*> m_instanceSlots;
+    //! Instance slots released by deleted meshes
+    std::vector<uint32_t> m_freeInstanceSlots;
+    //! Culling data of the draw list
+    std::vector<CullingData> m_cullingData;
+    //! Draw list ranges of m_drawGroups
+    std::vector<CullingGroup> m_cullingGroups;
+    //! Culls draw list instances on GPU
+    FrustumCuller* m_pFrustumCuller;
+    //! Frustum passed to GPU culling, contains everything when meshes are culled on CPU
+    Frustum m_cullingFrustum;
+    //! World bounding spheres of the draw list for CPU culling
+    SphereBatch m_cullingSpheres;
+    //! CPU culling result per draw list instance
+    std::vector<uint8_t> m_cullingVisibility;
     UniformCameraData m_uniformCameraData;
 
     vk::Instance const m_contextInstance;
 
     bool m_hasDirtyMeshes;
 
+    //! Renders into m_offscreenImages instead of swapchain
+    bool const m_isHeadless;
+    //! Amount of submitted frames
+    uint64_t m_frameCounter;
+    //! Shows if a single indirect call can issue several draws
+    bool m_hasMultiDrawIndirect;
+    //! Shows if indirect commands can have non-zero first instance
+    bool m_hasIndirectFirstInstance;
+    //! Shows if materials reference textures by index in m_bindlessDescriptorSet
+    bool m_isBindless;
+    //! Shows if materials are drawn with shaders specialized for their shading, updated every frame
+    bool m_isShaderSpecialization;
+    //! Shows if depth test and cull mode are set by command buffers instead of pipelines
+    bool m_hasExtendedDynamicState;
+    //! Shows if scene is rendered into m_sceneImages at scaled resolution and upscaled
+    bool m_isDynamicResolution;
+    //! Smoothed GPU frame time in nanoseconds measured at current resolution scale
+    double m_averageGpuTime;
+    //! Amount of GPU times measured at current resolution scale
+    uint32_t m_gpuTimeSamples;
+    //! First frame rendered at current resolution scale
+    uint64_t m_resolutionFrame;
+#ifdef VK_EXT_extended_dynamic_state
+    PFN_vkCmdSetDepthTestEnableEXT m_cmdSetDepthTestEnable;
+    PFN_vkCmdSetCullModeEXT m_cmdSetCullMode;
+#endif
+    //! Amount of arena pages destroyed before draws were last invalidated
+    uint64_t m_destroyedPagesCount;
+
     static const bool s_enableValidationLayers;
     static const uint32_t s_swapChainAttachmentsAmount;
+    static const size_t s_minDrawsPerWorker;
+    static const uint32_t s_maxBindlessTextures;
+    static const uint32_t s_materialSetsPerPool;
+    static const float s_resolutionScaleStep;
+    static const uint32_t s_resolutionSamples;
+    static const float s_upscaleHeadroom;
 
     static void DeleteVkMesh(VkMesh* pVkMesh);
 
     void FreeSurface();
     void FreeLogicalDevice();
+    void FreeUploadService();
     void FreeSwapChain();
+    void FreeOffscreenImages();
+    void FreeSceneImages();
     void FreeImageViews();
     void FreeDepthBuffer();
     void FreeRenderPass();
     void FreeGraphicsPipeline();
+    void FreeFrustumCuller();
     void FreeFrameBuffers();
     void FreeCommandPool();
-    void FreeCommandBuffers();
-    void FreeSemaphores();
+    void FreeWorkerCommandPools(FrameData& frame);
+    void FreeRecordingWorkers();
+    void FreeSyncObjects();
     void FreeUniforms();
-    void FreeDescriptorPoolAndLayouts() const;
+    void FreeDescriptorPoolAndLayouts();
     void FreePipelineCache();
+    void FreeTimestampQueries();
     void FreeEngineHelpData();
 
     bool PrepareUniformBuffers();
-    void UpdateViewProjectionDescriptorSet();
-    void UpdateModelDescriptorSet() const;
-    void UpdateUniformBuffer();
-    void UpdateDynamicUniformBuffer();
-    void UpdateVkMeshMatrices();
+    //! Points frame descriptor set to camera uniform buffer and visible instances
+    void UpdateFrameDescriptorSet(FrameData& frame) const;
+    void UpdateUniformBuffer(FrameData& frame);
+    bool UpdateInstanceBuffer(FrameData& frame);
+    //! Copies data of dirty instance slots into instance buffer of the frame
+    void UploadDirtyInstances(FrameData& frame);
+    //! Refreshes instance data of the mesh and marks its slot dirty in all frames
+    void UpdateInstanceData(VkMesh const& vkMesh);
+    static void MarkInstanceSlotDirty(FrameData& frame, uint32_t slot);
+    void AcquireInstanceSlot(VkMesh& vkMesh);
+    void ReleaseInstanceSlot(VkMesh const& vkMesh);
+    //! Reports culling counters of the frame if GPU finished it
+    void ReadCullingCounters(FrameData& frame);
+    //! Reports GPU time of the current frame slot if GPU finished it and feeds it to dynamic resolution
+    void ReadGpuTime(FrameData& frame);
+    /**
+     * @brief Moves resolution scale towards the one which fits target frame time
+     *
+     * Shaded pixels grow with square of the scale, so the scale changes
+     * with square root of measured to target time ratio. Scale changes
+     * by fixed steps, so recorded draws are not invalidated every frame
+     */
+    void UpdateResolutionScale();
+    //! Sets render extent of the scale, recorded draws are invalidated when it changes
+    void SetRenderExtent(float scale);
+    bool ReserveInstanceBuffer(FrameData& frame, size_t count);
+    bool UpdateIndirectBuffer(FrameData& frame);
+    bool ReserveIndirectBuffer(FrameData& frame, size_t count);
+    //! Makes secondary command buffers of all frames record draws anew
+    void InvalidateRecordedDraws();
+    //! Checks if draws recorded for the frame match current batches
+    bool AreRecordedDrawsValid(FrameData const& frame) const;
+    void BuildDrawList();
+    /**
+     * @brief Makes key which orders draws by pass, pipeline, material, geometry and depth
+     *
+     * Opaque draws are ordered front to back and blended ones back to front
+     */
+    uint64_t MakeDrawSortKey(VkMesh const& vkMesh) const;
+    //! Describes pipeline the material is drawn with, dynamic state is left out
+    PipelineState MakePipelineState(Material const& material) const;
+    //! Moves geometry out of sparse arena pages
+    void CompactGeometry();
+    void ReleaseFrameResources(FrameData& frame);
+    //! Returns data of the most recently submitted frame, its slot is reused after all frames in flight
+    FrameData& GetLastSubmittedFrame();
     bool PickPhysicalDevice();
 
     bool CreateLogicalDevice();
+    bool CreateUploadService();
+    //! Checks if instance has VK_KHR_get_physical_device_properties2 which device extension queries need
+    bool HasProperties2() const;
+    //! Checks if physical device has the extension
+    bool HasDeviceExtension(char const* name) const;
+    //! Checks if device can report heap budgets through VK_EXT_memory_budget
+    bool IsMemoryBudgetSupported() const;
+    /**
+     * @brief Checks if device can index texture array with VK_EXT_descriptor_indexing
+     *
+     * @param[out] capacity amount of textures which fit into bindless texture array
+     */
+    bool IsDescriptorIndexingSupported(uint32_t& capacity) const;
+    //! Checks if device can set depth test and cull mode dynamically with VK_EXT_extended_dynamic_state
+    bool IsExtendedDynamicStateSupported() const;
     bool CreateSurface();
     bool CreateDescriptionSetLayout();
     bool CreateSwapChain();
+    bool CreateOffscreenImages();
+    /**
+     * @brief Creates color targets of dynamic resolution
+     *
+     * Targets have size of swapchain images, so changing the scale
+     * only changes render area and doesn't reallocate them
+     */
+    bool CreateSceneImages();
+    //! Creates query pool of GPU timestamps, dynamic resolution is turned off without timestamps
+    bool CreateTimestampQueries();
+    //! Blits render area of the scene image into output image
+    void RecordUpscale(FrameData& frame, uint32_t imageIndex) const;
+    bool CreateReadbackBuffers();
+    void RecordReadback(FrameData& frame, uint32_t imageIndex) const;
+    void EmitReadback(FrameData& frame);
     bool CreateImageViews();
     bool CreateRenderPass();
+    /**
+     * @brief Prepares pipeline registry for current render pass
+     *
+     * Registry is created once, pipelines are kept while render pass
+     * stays compatible. Default pipelines are created ahead of the first frame
+     */
     bool CreateGraphicsPipeline();
+    bool CreateFrustumCuller();
     bool CreateFramebuffers();
     bool CreateCommandPool();
     bool CreateDepthBuffer();
-    bool CreateCommandBuffers();
-    bool CreateSemaphores();
+    bool PrepareRecordingWorkers(FrameData& frame);
+    bool RecordCommandBuffer(FrameData& frame, uint32_t imageIndex);
+    //! Records draw batches into secondary command buffers of the frame
+    bool RecordDrawCommands(FrameData& frame);
+    //! Records indirect commands [firstCommand, lastCommand) with state of their batches
+    void RecordDraws(vk::CommandBuffer commandBuffer, FrameData const& frame, size_t firstCommand, size_t lastCommand, DrawCounters& counters) const;
+    bool CreateSyncObjects();
     bool CreatePipelineCache();
     bool LoadEngineHelpData();
 
     bool IsDeviceSuitable(vk::PhysicalDevice const& device);
     bool AllocateMaterial(Mesh const& mesh, VkMesh& vkmesh);
+    //! Removes entries of materials which are not used by any mesh
+    void RemoveExpiredMaterials();
+    /**
+     * @brief Creates material which samples the texture
+     *
+     * Material takes ownership of the texture. In bindless mode texture
+     * is written into bindless texture array, otherwise material gets its own set
+     *
+     * @return new material or @c nullptr if descriptors can't be allocated
+     */
+    std::shared_ptr<VkMaterial> CreateVkMaterial(VkTexture* pTexture, uint32_t handle);
     static bool CheckDeviceExtensionSupport(vk::PhysicalDevice const& device);
     bool Frame();
-    void ResizeUnifromModelBuffer(VkMesh*);
     void OnMeshMaterialUpdated(Mesh* mesh, VkMesh*);
+    void OnMeshTransformUpdated(VkMesh* vkMesh);
+    void OnMeshGeometryRetired(GeometryArena::Allocation const& geometry);
     QueueFamilyIndices FindQueueFamilies(vk::PhysicalDevice const& device) const;
     bool FindSupportedFormat(std::vector<vk::Format> const& candidates, vk::ImageTiling tiling, vk::FormatFeatureFlags features, vk::Format& returnFormat) const;
     bool FindDepthFormat(vk::Format& desiredFormat) const;
@@ -0,0 +1,150 @@
+/*
+* Copyright (C) 2017 by Godlike
+* This code is licensed under the MIT license (MIT)
+* (http://opensource.org/licenses/MIT)
+*/
+
+#ifndef UNICORN_VIDEO_VULKAN_SHADER_MODULE_CACHE_HPP
+#define UNICORN_VIDEO_VULKAN_SHADER_MODULE_CACHE_HPP
+
+#include <vulkan/vulkan.hpp>
+#include <mule/templates/Singleton.hpp>
+
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace unicorn
+{
+namespace video
+{
+namespace vulkan
+{
+/** @brief Resources a shader module uses, read from its SPIR-V code */
+struct ShaderReflection
+{
+    struct Binding
+    {
+        uint32_t set;
+        uint32_t binding;
+        vk::DescriptorType type;
+        //! Amount of descriptors, 0 for runtime sized arrays
+        uint32_t count;
+    };
+
+    //! Stages of module entry points
+    vk::ShaderStageFlags stages;
+    //! Descriptor bindings sorted by set and binding
+    std::vector<Binding> bindings;
+    //! Size of push constant block, 0 if module has none
+    uint32_t pushConstantSize = 0;
+};
+
+/**
+ * @brief Shares shader modules between everything that loads the same shaders
+ *
+ * Shader files are read once and keyed by hash of their SPIR-V code, so
+ * files with equal contents share one entry. Reflection of the code is done
+ * once per entry. Shader modules are created once for every device and
+ * reference counted, they are destroyed when the last user releases them
+ */
+class ShaderModuleCache : public mule::templates::Singleton<ShaderModuleCache>
+{
+public:
+    /** @brief Shader module acquired from the cache */
+    struct Module
+    {
+        //! Null handle if module can't be loaded
+        vk::ShaderModule module;
+        //! Reflection of module code, owned by the cache
+        ShaderReflection const* pReflection = nullptr;
+    };
+
+    /**
+     * @brief Returns module of the shader file, creates it on first request for the device
+     *
+     * Every successful call must be paired with Release()
+     *
+     * @param[in] device device to create module on
+     * @param[in] path path to SPIR-V file
+     * @return module with null handle if the file can't be loaded
+     */
+    Module Acquire(vk::Device device, std::string const& path);
+
+    /**
+     * @brief Releases module acquired with Acquire()
+     *
+     * @param[in] device device module was acquired for
+     * @param[in] module module handle
+     */
+    void Release(vk::Device device, vk::ShaderModule module);
+
+    //! Returns amount of unique SPIR-V codes in the cache
+    size_t GetCodesCount() const;
+
+    //! Returns amount of alive shader modules on all devices
+    size_t GetModulesCount() const;
+
+private:
+    friend class mule::templates::Singleton<ShaderModuleCache>;
+
+    ShaderModuleCache() = default;
+
+    /** @brief Reports modules which were not released */
+    ~ShaderModuleCache();
+
+    ShaderModuleCache(ShaderModuleCache const& other) = delete;
+    ShaderModuleCache& operator=(ShaderModuleCache const& other) = delete;
+
+    ShaderModuleCache(ShaderModuleCache&& other) = delete;
+    ShaderModuleCache& operator=(ShaderModuleCache&& other) = delete;
+
+    //! Unique SPIR-V code
+    struct Code
+    {
+        std::vector<uint32_t> words;
+        uint64_t hash;
+        ShaderReflection reflection;
+    };
+
+    struct ModuleEntry
+    {
+        vk::ShaderModule module;
+        uint32_t refCount;
+    };
+
+    //! Module is identified by device and code it was created from
+    typedef std::pair<VkDevice, Code const*> ModuleKey;
+
+    mutable std::mutex m_mutex;
+
+    //! Codes grouped by hash, collisions are resolved by comparing words
+    std::unordered_map<uint64_t, std::vector<Code*>> m_codes;
+    //! Codes of loaded files, so files are read once
+    std::unordered_map<std::string, Code const*> m_paths;
+
+    std::map<ModuleKey, ModuleEntry> m_modules;
+    //! Finds key of released module
+    std::unordered_map<VkShaderModule, ModuleKey> m_moduleKeys;
+
+    //! Returns code of the file, loads it on first request
+    Code const* GetCode(std::string const& path);
+
+    /**
+     * @brief Reads descriptor bindings and push constants of SPIR-V code
+     *
+     * @param[in] words SPIR-V code
+     * @param[out] reflection resources of the code
+     * @return false if code is not valid SPIR-V
+     */
+    static bool Reflect(std::vector<uint32_t> const& words, ShaderReflection& reflection);
+};
+}
+}
+}
+
+#endif // UNICORN_VIDEO_VULKAN_SHADER_MODULE_CACHE_HPP
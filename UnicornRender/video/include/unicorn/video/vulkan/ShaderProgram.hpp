@@ -8,7 +8,17 @@
 #define UNICORN_VIDEO_SHADER_PROGRAM_HPP
 
 #include <vulkan/vulkan.hpp>
+#include <glm/glm.hpp>
 #include <array>
+#include <string>
+
+namespace unicorn
+{
+namespace video
+{
+class Material;
+}
+}
 
 namespace unicorn
 {
@@ -16,8 +26,70 @@ namespace video
 {
 namespace vulkan
 {
+struct ShaderReflection;
+
+/**
+ * @brief Per instance data of the shader program
+ *
+ * Instances are read from storage buffer at set 0 binding 1 by instance index,
+ * layout matches std430 rules
+ */
+struct InstanceData
+{
+    //! Model matrix
+    glm::mat4 model;
+
+    //! Color in xyz and flag of enabled color in w
+    glm::vec4 color;
+
+    //! Normalized sprite area of the texture
+    glm::vec4 spriteCoord;
+
+    //! Index of the texture in bindless texture array
+    uint32_t textureIndex;
+
+    //! Pads structure to std430 array stride
+    uint32_t padding[3];
+};
+
+/** @brief Push constants of draws recorded with the shader program */
+struct DrawParameters
+{
+    //! Added to instance index if indirect draws can't set first instance
+    uint32_t instanceOffset;
+};
+
+/** @brief Shader programs graphics pipelines are created with */
+enum class ShaderVariant : uint32_t
+{
+    //! Texture of every material is bound as its own descriptor set
+    Uber,
+    //! Textures are indexed in bindless texture array
+    UberBindless
+};
+
+/**
+ * @brief Shading of materials, specializes shader program
+ *
+ * Values match specialization constant 0 of the shaders. Specialized shadings
+ * run without per fragment branching and pass only the data they use
+ */
+enum class MaterialShading : uint32_t
+{
+    //! Chooses between color and sprite of the texture for every fragment
+    Dynamic,
+    //! Flat color
+    Colored,
+    //! Texture sampled at mesh texture coordinates
+    Textured,
+    //! Area of texture atlas
+    Sprite
+};
+
 /**
 * @brief Abstraction for shader program, which renderer uses for rendering meshes
+*
+* Shader modules are shared through ShaderModuleCache
 */
 class ShaderProgram
 {
@@ -31,34 +103,58 @@ public:
     */
     ShaderProgram(vk::Device device, const std::string& vertShaderPath, const std::string& fragShaderPath);
 
+    ShaderProgram(ShaderProgram const& other) = delete;
+    ShaderProgram& operator=(ShaderProgram const& other) = delete;
+
     /**
     * @brief Function to check is shader was successfully loaded and created
     * @return true if shader was created and false if not
     */
     bool IsCreated();
 
-    /** @brief Returns pointer to shader stage creation information */
-    vk::PipelineShaderStageCreateInfo* GetShaderStageInfoData();
+    /**
+     * @brief Returns pointer to shader stage creation information
+     * @param shading shading the stages are specialized for
+     */
+    vk::PipelineShaderStageCreateInfo* GetShaderStageInfoData(MaterialShading shading);
+
+    /** @brief Returns the most specialized shading the material can be drawn with */
+    static MaterialShading SelectShading(Material const& material);
+
+    //! Returns resources of vertex shader, null if program is not created
+    ShaderReflection const* GetVertexReflection() const { return m_pVertReflection; }
+
+    //! Returns resources of fragment shader, null if program is not created
+    ShaderReflection const* GetFragmentReflection() const { return m_pFragReflection; }
 
     /** @brief Returns pointer to vertex input state creation information */
     vk::PipelineVertexInputStateCreateInfo GetVertexInputInfo();
 
     /**
-    * @brief Destroys shader modules
+    * @brief Releases shader modules to the cache
     */
     void DestroyShaderModules();
 private:
     bool m_isCreated;
     void CreateBindingDescription();
     void CreateAttributeDescription();
-    bool CreateShaderModule(const std::vector<uint8_t>& code, vk::ShaderModule& shaderModule);
     void CreateVertexInputInfo();
 
     vk::Device m_device;
-    vk::VertexInputBindingDescription m_bindingDescription;
+    std::array<vk::VertexInputBindingDescription, 1> m_bindingDescription;
     std::array<vk::VertexInputAttributeDescription, 2> m_attributeDescription;
-    std::array<vk::PipelineShaderStageCreateInfo, 2> m_shaderStages;
+    //! Amount of MaterialShading values
+    static const uint32_t s_shadingsCount = 4;
+
+    //! Specialization constant values, one for each shading
+    std::array<uint32_t, s_shadingsCount> m_shadingConstants;
+    vk::SpecializationMapEntry m_shadingMapEntry;
+    std::array<vk::SpecializationInfo, s_shadingsCount> m_specializationInfos;
+    //! Vertex and fragment stages of every shading
+    std::array<std::array<vk::PipelineShaderStageCreateInfo, 2>, s_shadingsCount> m_shaderStages;
     vk::ShaderModule m_vertShaderModule, m_fragShaderModule;
+    ShaderReflection const* m_pVertReflection;
+    ShaderReflection const* m_pFragReflection;
     vk::PipelineVertexInputStateCreateInfo m_vertexInputInfo;
 };
 }
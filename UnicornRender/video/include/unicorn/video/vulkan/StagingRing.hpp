@@ -0,0 +1,109 @@
+/*
+* Copyright (C) 2017 by Godlike
+* This code is licensed under the MIT license (MIT)
+* (http://opensource.org/licenses/MIT)
+*/
+
+#ifndef UNICORN_VIDEO_VULKAN_STAGING_RING_HPP
+#define UNICORN_VIDEO_VULKAN_STAGING_RING_HPP
+
+#include <unicorn/video/vulkan/Buffer.hpp>
+
+#include <vulkan/vulkan.hpp>
+
+#include <cstdint>
+
+namespace unicorn
+{
+namespace video
+{
+namespace vulkan
+{
+/**
+ * @brief Persistently mapped host visible buffer uploads are staged in
+ *
+ * Ranges are taken from the head of the ring and returned from its tail
+ * in the same order. Owner partitions the ring by remembering GetHead()
+ * when it submits work reading staged data and passes it to Release()
+ * once that work is finished.
+ *
+ * Positions are counted in bytes written since creation, so head and tail
+ * never wrap and the ring is empty when they are equal.
+ */
+class StagingRing
+{
+public:
+    //! Alignment of every range, satisfies buffer to image copies of any format
+    static const vk::DeviceSize s_alignment;
+
+    StagingRing();
+
+    /** @brief Calls Destroy() */
+    ~StagingRing();
+
+    StagingRing(StagingRing const& other) = delete;
+    StagingRing& operator=(StagingRing const& other) = delete;
+
+    /**
+     * @brief Creates and maps the ring buffer
+     * @param[in] physicalDevice GPU for memory allocation
+     * @param[in] device device for allocation
+     * @param[in] size size of the ring in bytes
+     * @return true if ring was created, false otherwise
+     */
+    bool Create(vk::PhysicalDevice physicalDevice, vk::Device device, vk::DeviceSize size);
+
+    /**
+     * @brief Destroys the ring buffer
+     */
+    void Destroy();
+
+    /**
+     * @brief Copies data into free range of the ring
+     * @param[in] pData data to stage
+     * @param[in] size size of data in bytes
+     * @param[out] offset offset of the range in the ring buffer
+     * @return true if data was staged, false if ring has no contiguous free range of @p size bytes
+     */
+    bool Write(void const* pData, vk::DeviceSize size, vk::DeviceSize& offset);
+
+    /**
+     * @brief Makes staged data visible to device, required for non-coherent memory
+     */
+    void Flush() const;
+
+    /**
+     * @brief Returns position following the last written range
+     * @return position to be passed to Release()
+     */
+    uint64_t GetHead() const { return m_head; }
+
+    /**
+     * @brief Returns ranges written before @p position to the ring
+     * @param[in] position value of GetHead() taken after the ranges were written
+     */
+    void Release(uint64_t position);
+
+    //! Returns ring buffer
+    vk::Buffer GetVkBuffer() const { return m_buffer.GetVkBuffer(); }
+
+    //! Returns size of the ring in bytes
+    vk::DeviceSize GetSize() const { return m_size; }
+
+    //! Returns true if ring buffer is created
+    bool IsCreated() const { return m_size != 0; }
+private:
+    Buffer m_buffer;
+    vk::DeviceSize m_size;
+
+    //! Position of the next range
+    uint64_t m_head;
+
+    //! Position of the oldest range which is still in use
+    uint64_t m_tail;
+};
+}
+}
+}
+
+#endif // UNICORN_VIDEO_VULKAN_STAGING_RING_HPP
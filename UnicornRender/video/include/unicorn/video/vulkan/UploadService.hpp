@@ -0,0 +1,243 @@
+/*
+* Copyright (C) 2017 by Godlike
+* This code is licensed under the MIT license (MIT)
+* (http://opensource.org/licenses/MIT)
+*/
+
+#ifndef UNICORN_VIDEO_VULKAN_UPLOAD_SERVICE_HPP
+#define UNICORN_VIDEO_VULKAN_UPLOAD_SERVICE_HPP
+
+#include <unicorn/video/vulkan/StagingRing.hpp>
+
+#include <vulkan/vulkan.hpp>
+
+#include <cstdint>
+#include <deque>
+#include <vector>
+
+namespace unicorn
+{
+namespace video
+{
+namespace vulkan
+{
+class Image;
+
+/**
+ * @brief Batches CPU to GPU uploads into one submission per frame
+ *
+ * Copies and layout transitions are recorded into a command buffer of the
+ * transfer queue family, which is a dedicated one when device has it.
+ * The batch is submitted when renderer calls Flush() and the frame which
+ * consumes it waits on the returned semaphore. When transfer queue family
+ * differs from the graphics one, queue family ownership of uploaded
+ * resources is released on the transfer queue and acquired by barriers
+ * recorded with RecordAcquireBarriers() into the same frame.
+ *
+ * Data is staged in a persistently mapped ring which is partitioned by
+ * batches, a partition is reused once its batch is recycled. Uploads larger
+ * than half of the ring or not fitting into its free space get dedicated
+ * staging buffers.
+ *
+ * Every upload returns a token of its batch, resources may be used by
+ * frames recorded after IsComplete() returns true for the token.
+ */
+class UploadService
+{
+public:
+    //! Token of an upload which doesn't need to be waited for
+    static const uint64_t s_completeToken = 0;
+
+    /**
+     * @brief Returns stages at which render submission waits on semaphore returned by Flush()
+     * @return pipeline stages reading uploaded data
+     */
+    static vk::PipelineStageFlags GetConsumerStages();
+
+    /**
+     * @brief Constructs the service
+     * @param[in] physicalDevice physical device staging memory is allocated on
+     * @param[in] device logical device
+     * @param[in] graphicsFamily queue family index of graphics queue
+     * @param[in] transferFamily queue family index of transfer queue
+     * @param[in] transferQueue queue uploads are submitted to
+     * @param[in] stagingBufferSize size of staging ring in bytes
+     */
+    UploadService(vk::PhysicalDevice physicalDevice,
+                  vk::Device device,
+                  uint32_t graphicsFamily,
+                  uint32_t transferFamily,
+                  vk::Queue transferQueue,
+                  vk::DeviceSize stagingBufferSize);
+
+    /** @brief Waits for pending uploads and frees all resources */
+    ~UploadService();
+
+    UploadService(UploadService const& other) = delete;
+    UploadService(UploadService&& other) = delete;
+    UploadService& operator=(UploadService const& other) = delete;
+    UploadService& operator=(UploadService&& other) = delete;
+
+    /**
+     * @brief Creates command pool and staging ring of the service
+     * @return true if service is ready for uploads
+     */
+    bool Init();
+
+    /**
+     * @brief Records copy of host data into device buffer
+     * @param[in] pData data to upload
+     * @param[in] size size of data in bytes
+     * @param[in] dstBuffer destination buffer, must be alive until upload is complete
+     * @param[in] dstOffset offset in destination buffer
+     * @return token of the upload or s_completeToken if upload failed
+     */
+    uint64_t UploadBuffer(void const* pData, size_t size, Buffer const& dstBuffer, vk::DeviceSize dstOffset);
+
+    /**
+     * @brief Records copy of host data into image and transitions it for sampling
+     * @param[in] pData tightly packed texel data
+     * @param[in] size size of data in bytes
+     * @param[in] dstImage destination image in undefined layout, must be alive until upload is complete
+     * @return token of the upload or s_completeToken if upload failed
+     */
+    uint64_t UploadImage(void const* pData, size_t size, Image const& dstImage);
+
+    /**
+     * @brief Checks if upload is visible for frames recorded from now on
+     * @param[in] token token returned by upload
+     * @return true if upload was submitted and is waited on by renderer
+     */
+    bool IsComplete(uint64_t token) const { return token <= m_flushedToken; }
+
+    /**
+     * @brief Checks if upload may be used by the frame which is submitted right after the next Flush()
+     *
+     * Such frame records acquire barriers of the recording batch and waits on it
+     *
+     * @param[in] token token returned by upload
+     * @return true if upload was submitted or belongs to the recording batch
+     */
+    bool IsReadyForFrame(uint64_t token) const
+    {
+        return IsComplete(token) || (m_pRecordingBatch && token == m_pRecordingBatch->token);
+    }
+
+    /**
+     * @brief Submits recorded uploads
+     *
+     * Must be called right before submission of the frame which recorded
+     * acquire barriers, uploads can't be recorded in between
+     *
+     * @param[out] token token of submitted batch, s_completeToken if nothing was submitted
+     * @return semaphore render submission must wait on, null if there is nothing to wait
+     */
+    vk::Semaphore Flush(uint64_t& token);
+
+    /**
+     * @brief Records queue family ownership acquisition of resources uploaded by recording batch
+     *        and by batches finished with Finish()
+     * @param[in] commandBuffer graphics command buffer of the frame which waits on the next flushed batch
+     */
+    void RecordAcquireBarriers(vk::CommandBuffer commandBuffer) const;
+
+    /**
+     * @brief Recycles batch after the frame which waited on it is finished by GPU
+     * @param[in] token token received from Flush()
+     */
+    void Release(uint64_t token);
+
+    /**
+     * @brief Submits recorded uploads and waits until they are finished
+     *
+     * Used before destination resources of pending uploads are destroyed
+     */
+    void Finish();
+
+private:
+    //! Uploads submitted together
+    struct Batch
+    {
+        uint64_t token = 0;
+        vk::CommandBuffer commandBuffer;
+        vk::Fence fence;
+        vk::Semaphore semaphore;
+
+        //! Staging ring position following data of the batch
+        uint64_t stagingRingEnd = 0;
+
+        //! Dedicated staging buffers of uploads which didn't fit into the ring
+        std::vector<Buffer*> stagingBuffers;
+    };
+
+    /**
+     * @brief Returns batch uploads are recorded into, begins it if needed
+     * @return pointer to batch or nullptr on failure
+     */
+    Batch* GetRecordingBatch();
+
+    /**
+     * @brief Stages @p pData in the ring or in a dedicated buffer owned by the batch
+     * @param[in] batch batch the copy is recorded into
+     * @param[in] pData data to upload
+     * @param[in] size size of data in bytes
+     * @param[out] buffer staging buffer holding the data
+     * @param[out] offset offset of the data in @p buffer
+     * @return true if data was staged, false otherwise
+     */
+    bool Stage(Batch& batch, void const* pData, size_t size, vk::Buffer& buffer, vk::DeviceSize& offset);
+
+    /**
+     * @brief Ends and submits recording batch
+     * @param[in] signalSemaphore true if batch signals its semaphore
+     * @return true if batch was submitted
+     */
+    bool Submit(bool signalSemaphore);
+
+    /**
+     * @brief Waits for the batch and returns its resources for reuse
+     * @param[in] pBatch batch to recycle
+     */
+    void Recycle(Batch* pBatch);
+
+    //! Returns true if uploads cross queue families
+    bool IsOwnershipTransferred() const { return m_graphicsFamily != m_transferFamily; }
+
+    vk::PhysicalDevice m_physicalDevice;
+    vk::Device m_device;
+    uint32_t m_graphicsFamily;
+    uint32_t m_transferFamily;
+    vk::Queue m_transferQueue;
+    vk::CommandPool m_commandPool;
+
+    StagingRing m_stagingRing;
+    vk::DeviceSize m_stagingBufferSize;
+
+    //! Batch uploads are recorded into, nullptr if there are none
+    Batch* m_pRecordingBatch;
+
+    //! Submitted batches which are not released yet, oldest first
+    std::deque<Batch*> m_submittedBatches;
+
+    //! Recycled batches
+    std::vector<Batch*> m_freeBatches;
+
+    //! Acquire barriers of resources uploaded by recording batch
+    std::vector<vk::BufferMemoryBarrier> m_pendingBufferBarriers;
+    std::vector<vk::ImageMemoryBarrier> m_pendingImageBarriers;
+
+    //! Acquire barriers of resources uploaded by batches finished with Finish()
+    std::vector<vk::BufferMemoryBarrier> m_acquireBufferBarriers;
+    std::vector<vk::ImageMemoryBarrier> m_acquireImageBarriers;
+
+    //! Token of the next batch
+    uint64_t m_nextToken;
+
+    //! Token of the last submitted batch
+    uint64_t m_flushedToken;
+};
+}
+}
+}
+
+#endif // UNICORN_VIDEO_VULKAN_UPLOAD_SERVICE_HPP
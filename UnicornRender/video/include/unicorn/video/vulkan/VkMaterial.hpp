@@ -23,8 +23,8 @@ struct VkMaterial
     uint32_t handle = 0;
     vk::DescriptorSet descriptorSet = nullptr;
     VkTexture* texture = nullptr;
-    vk::Device device = nullptr;
-    vk::DescriptorPool pool = nullptr;
+    //! Index of the texture in bindless texture array, unused without bindless textures
+    uint32_t textureIndex = 0;
 };
 }
 }
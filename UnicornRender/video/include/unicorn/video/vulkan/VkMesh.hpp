@@ -8,7 +8,7 @@
 #define UNICORN_VIDEO_VULKAN_MESH_HPP
 
 #include <unicorn/video/Mesh.hpp>
-#include <unicorn/video/vulkan/Buffer.hpp>
+#include <unicorn/video/vulkan/GeometryArena.hpp>
 #include <unicorn/video/vulkan/VkMaterial.hpp>
 
 #include <vulkan/vulkan.hpp>
@@ -20,6 +20,8 @@ namespace video
 {
 namespace vulkan
 {
+class UploadService;
+
 /**
  * @brief Mesh info for Vulkan backend
  */
@@ -28,13 +30,11 @@ class VkMesh
 public:
     /**
      * @brief Constructor
-     * @param device Which device to use
-     * @param physicalDevice Where to allocate mesh
-     * @param pool Which pool to allocate commands from
-     * @param queue Which queue to use to buffer copying
+     * @param uploadService Which service uploads geometry
+     * @param geometryArena Where to place geometry
      * @param mesh Geometry data
      */
-    VkMesh(vk::Device device, vk::PhysicalDevice physicalDevice, vk::CommandPool pool, vk::Queue queue, Mesh& mesh);
+    VkMesh(UploadService& uploadService, GeometryArena& geometryArena, Mesh& mesh);
     ~VkMesh();
 
     /**
@@ -55,6 +55,9 @@ public:
 
     /**
      * @brief Allocation on GPU
+     *
+     * Previous geometry of valid mesh is passed to GeometryRetired
+     * instead of being freed
      */
     void AllocateOnGPU();
 
@@ -64,17 +67,44 @@ public:
     void DeallocateOnGPU();
 
     /**
-     * @brief Returns vertex buffer
+     * @brief Stops tracking of geometry mesh
+     *
+     * After this call VkMesh may outlive the mesh it was created for,
+     * which allows to release its GPU data later than the mesh itself
+     */
+    void Detach();
+
+    /**
+     * @brief Returns vertex buffer shared with other meshes of the same arena page
      * @return vulkan buffer
      */
     vk::Buffer GetVertexBuffer() const;
 
     /**
-     * @brief Returns index buffer
+     * @brief Returns index buffer shared with other meshes of the same arena page
      * @return vulkan buffer
      */
     vk::Buffer GetIndexBuffer() const;
 
+    /**
+     * @brief Returns ranges of mesh geometry in the arena
+     * @return geometry allocation
+     */
+    GeometryArena::Allocation const& GetGeometry() const { return m_geometry; }
+
+    /**
+     * @brief Returns token of geometry upload
+     *
+     * Mesh may be drawn once upload service reports the token as complete
+     */
+    uint64_t GetUploadToken() const { return m_uploadToken; }
+
+    /**
+     * @brief Returns bounding sphere of mesh vertices in model space
+     * @return center in xyz and radius in w
+     */
+    glm::vec4 GetBoundingSphere() const;
+
     /** @brief Returns model matrix */
     const glm::mat4& GetModelMatrix() const;
 
@@ -86,30 +116,47 @@ public:
      */
     void OnMaterialUpdated();
 
+    /** @brief Notifies renderer that model matrix of mesh was updated */
+    void OnTransformUpdated();
+
+    /** @brief Returns index of mesh data in instance buffers */
+    uint32_t GetInstanceSlot() const { return m_instanceSlot; }
+
+    /**
+     * @brief Sets index of mesh data in instance buffers
+     * @param[in] instanceSlot index assigned by renderer
+     */
+    void SetInstanceSlot(uint32_t instanceSlot) { m_instanceSlot = instanceSlot; }
+
     /**
      * @brief Material in vulkan is a combination of descriptor set and bound data
      */
     std::shared_ptr<VkMaterial> pMaterial;
 
     /**
-     * @brief Signal for command buffer reallocation
+     * @brief Signal for geometry replaced by AllocateOnGPU(), receiver frees it with the arena
      */
-    wink::signal<wink::slot<void(VkMesh*)>> ReallocatedOnGpu;
+    wink::signal<wink::slot<void(GeometryArena::Allocation const&)>> GeometryRetired;
 
     /**
     * @brief Signal for material update
     */
     wink::signal<wink::slot<void(Mesh*, VkMesh*)>> MaterialUpdated;
+
+    /**
+    * @brief Signal for model matrix update
+    */
+    wink::signal<wink::slot<void(VkMesh*)>> TransformUpdated;
 private:
     bool m_valid;
 
-    vk::Device m_device;
-    vk::PhysicalDevice m_physicalDevice;
-    vulkan::Buffer m_vertexBuffer, m_indexBuffer;
-    vk::CommandPool m_pool;
-    vk::Queue m_queue;
+    UploadService& m_uploadService;
+    GeometryArena& m_geometryArena;
+    GeometryArena::Allocation m_geometry;
+    uint64_t m_uploadToken;
+    uint32_t m_instanceSlot;
 
-    Mesh& m_mesh;
+    Mesh* m_pMesh;
 };
 }
 }
@@ -20,6 +20,8 @@ class Texture;
 
 namespace vulkan
 {
+class UploadService;
+
 /**
  * @brief VkTexture represents texture at Vulkan backend
  */
@@ -39,13 +41,12 @@ public:
      * @brief Creates vulkan render texture
      * @param physicalDevice physical device for staging buffer
      * @param device device which allocate from
-     * @param commandPool pool which allocate commands from
-     * @param queue queue where push commands
+     * @param uploadService service which uploads texture data
      * @param texture texture data
      * @return true if creation was successful and false if not
      */
     bool Create(vk::PhysicalDevice const& physicalDevice, vk::Device const& device,
-                vk::CommandPool const& commandPool, vk::Queue const& queue, Texture const& texture);
+                UploadService& uploadService, Texture const& texture);
 
     /**
      * @brief Removes texture from GPU and destroys sampler
@@ -54,11 +55,20 @@ public:
 
     /** @brief Returns @c true if texture is initialized and @c false otherwise */
     bool IsInitialized() const;
+
+    /**
+     * @brief Returns token of texture data upload
+     *
+     * Texture may be sampled once upload service reports the token as complete
+     */
+    uint64_t GetUploadToken() const { return m_uploadToken; }
 private:
     vk::Device m_device;
     vk::DescriptorImageInfo m_imageInfo;
     Image* m_vkImage;
     vk::Sampler m_sampler;
+    UploadService* m_pUploadService;
+    uint64_t m_uploadToken;
     bool m_isInitialized;
 };
 }
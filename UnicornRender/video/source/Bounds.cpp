@@ -0,0 +1,125 @@
+/*
+* Copyright (C) 2017 by Godlike
+* This code is licensed under the MIT license (MIT)
+* (http://opensource.org/licenses/MIT)
+*/
+
+#include <unicorn/video/Bounds.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+namespace unicorn
+{
+namespace video
+{
+namespace
+{
+glm::vec3 const& PointAt(glm::vec3 const* pPoints, size_t index, size_t stride)
+{
+    return *reinterpret_cast<glm::vec3 const*>(reinterpret_cast<uint8_t const*>(pPoints) + index * stride);
+}
+}
+
+BoundingBox BoundingBox::FromPoints(glm::vec3 const* pPoints, size_t count, size_t stride)
+{
+    BoundingBox box;
+
+    if(count == 0)
+    {
+        return box;
+    }
+
+    box.minimum = PointAt(pPoints, 0, stride);
+    box.maximum = box.minimum;
+
+    for(size_t i = 1; i < count; ++i)
+    {
+        glm::vec3 const& point = PointAt(pPoints, i, stride);
+
+        box.minimum = glm::min(box.minimum, point);
+        box.maximum = glm::max(box.maximum, point);
+    }
+
+    return box;
+}
+
+BoundingBox BoundingBox::Transformed(glm::mat4 const& transform) const
+{
+    // Extents of transformed box are extents projected onto absolute basis (Arvo)
+    glm::vec3 const center = glm::vec3(transform * glm::vec4(GetCenter(), 1.0f));
+    glm::vec3 const extents = GetExtents();
+
+    glm::vec3 transformedExtents(0.0f);
+
+    for(int column = 0; column < 3; ++column)
+    {
+        transformedExtents += glm::abs(glm::vec3(transform[column])) * extents[column];
+    }
+
+    BoundingBox box;
+    box.minimum = center - transformedExtents;
+    box.maximum = center + transformedExtents;
+
+    return box;
+}
+
+BoundingSphere BoundingSphere::FromPoints(BoundingBox const& box, glm::vec3 const* pPoints, size_t count, size_t stride)
+{
+    // Sphere around box center is not the tightest one, but it takes a single pass
+    BoundingSphere sphere;
+    sphere.center = box.GetCenter();
+
+    float radiusSquared = 0.0f;
+
+    for(size_t i = 0; i < count; ++i)
+    {
+        glm::vec3 const offset = PointAt(pPoints, i, stride) - sphere.center;
+
+        radiusSquared = std::max(radiusSquared, glm::dot(offset, offset));
+    }
+
+    sphere.radius = std::sqrt(radiusSquared);
+
+    return sphere;
+}
+
+BoundingSphere BoundingSphere::Transformed(glm::mat4 const& transform) const
+{
+    float const scaleSquared = std::max(glm::dot(glm::vec3(transform[0]), glm::vec3(transform[0])),
+        std::max(glm::dot(glm::vec3(transform[1]), glm::vec3(transform[1])),
+                 glm::dot(glm::vec3(transform[2]), glm::vec3(transform[2]))));
+
+    BoundingSphere sphere;
+    sphere.center = glm::vec3(transform * glm::vec4(center, 1.0f));
+    sphere.radius = radius * std::sqrt(scaleSquared);
+
+    return sphere;
+}
+
+void SphereBatch::Clear()
+{
+    m_centerX.clear();
+    m_centerY.clear();
+    m_centerZ.clear();
+    m_radius.clear();
+}
+
+void SphereBatch::Reserve(size_t count)
+{
+    m_centerX.reserve(count);
+    m_centerY.reserve(count);
+    m_centerZ.reserve(count);
+    m_radius.reserve(count);
+}
+
+void SphereBatch::Push(BoundingSphere const& sphere)
+{
+    m_centerX.push_back(sphere.center.x);
+    m_centerY.push_back(sphere.center.y);
+    m_centerZ.push_back(sphere.center.z);
+    m_radius.push_back(sphere.radius);
+}
+}
+}
@@ -0,0 +1,199 @@
+/*
+* Copyright (C) 2017 by Godlike
+* This code is licensed under the MIT license (MIT)
+* (http://opensource.org/licenses/MIT)
+*/
+
+#include <unicorn/video/Frustum.hpp>
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#define UNICORN_FRUSTUM_AVX
+#elif defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#include <xmmintrin.h>
+#define UNICORN_FRUSTUM_SSE
+#endif
+
+namespace unicorn
+{
+namespace video
+{
+Frustum::Frustum()
+{
+    // Every point is on positive side of a plane with zero normal and positive distance
+    m_planes.fill(glm::vec4(0.0f, 0.0f, 0.0f, 1.0f));
+}
+
+Frustum::Frustum(glm::mat4 const& viewProjection)
+{
+    // Matrix is column major, so rows are gathered from columns
+    glm::vec4 rows[4];
+
+    for(int row = 0; row < 4; ++row)
+    {
+        rows[row] = glm::vec4(viewProjection[0][row], viewProjection[1][row], viewProjection[2][row], viewProjection[3][row]);
+    }
+
+    m_planes[0] = rows[3] + rows[0];
+    m_planes[1] = rows[3] - rows[0];
+    m_planes[2] = rows[3] + rows[1];
+    m_planes[3] = rows[3] - rows[1];
+    m_planes[4] = rows[2];
+    m_planes[5] = rows[3] - rows[2];
+
+    for(auto& plane : m_planes)
+    {
+        float const length = glm::length(glm::vec3(plane));
+
+        if(length > 0.0f)
+        {
+            plane /= length;
+        }
+    }
+}
+
+bool Frustum::Intersects(BoundingSphere const& sphere) const
+{
+    for(auto const& plane : m_planes)
+    {
+        if(glm::dot(glm::vec3(plane), sphere.center) + plane.w < -sphere.radius)
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool Frustum::Intersects(BoundingBox const& box) const
+{
+    for(auto const& plane : m_planes)
+    {
+        // Corner of the box which is the furthest along plane normal
+        glm::vec3 const corner(plane.x >= 0.0f ? box.maximum.x : box.minimum.x,
+                               plane.y >= 0.0f ? box.maximum.y : box.minimum.y,
+                               plane.z >= 0.0f ? box.maximum.z : box.minimum.z);
+
+        if(glm::dot(glm::vec3(plane), corner) + plane.w < 0.0f)
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+uint32_t Frustum::Cull(SphereBatch const& spheres, std::vector<uint8_t>& visibility) const
+{
+    size_t const count = spheres.GetSize();
+
+    visibility.resize(count);
+
+    float const* pX = spheres.GetCenterX();
+    float const* pY = spheres.GetCenterY();
+    float const* pZ = spheres.GetCenterZ();
+    float const* pRadius = spheres.GetRadius();
+
+    uint32_t visibleCount = 0;
+    size_t i = 0;
+
+#if defined(UNICORN_FRUSTUM_AVX)
+    // Each plane is tested against 8 spheres at once
+    __m256 planeX[6], planeY[6], planeZ[6], planeW[6];
+
+    for(int plane = 0; plane < 6; ++plane)
+    {
+        planeX[plane] = _mm256_set1_ps(m_planes[plane].x);
+        planeY[plane] = _mm256_set1_ps(m_planes[plane].y);
+        planeZ[plane] = _mm256_set1_ps(m_planes[plane].z);
+        planeW[plane] = _mm256_set1_ps(m_planes[plane].w);
+    }
+
+    __m256 const zero = _mm256_setzero_ps();
+
+    for(; i + 8 <= count; i += 8)
+    {
+        __m256 const x = _mm256_loadu_ps(pX + i);
+        __m256 const y = _mm256_loadu_ps(pY + i);
+        __m256 const z = _mm256_loadu_ps(pZ + i);
+        __m256 const negativeRadius = _mm256_sub_ps(zero, _mm256_loadu_ps(pRadius + i));
+
+        __m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+
+        for(int plane = 0; plane < 6; ++plane)
+        {
+            __m256 distance = _mm256_add_ps(_mm256_mul_ps(planeX[plane], x), planeW[plane]);
+            distance = _mm256_add_ps(distance, _mm256_mul_ps(planeY[plane], y));
+            distance = _mm256_add_ps(distance, _mm256_mul_ps(planeZ[plane], z));
+
+            inside = _mm256_and_ps(inside, _mm256_cmp_ps(distance, negativeRadius, _CMP_GE_OQ));
+        }
+
+        int const mask = _mm256_movemask_ps(inside);
+
+        for(int lane = 0; lane < 8; ++lane)
+        {
+            uint8_t const isVisible = static_cast<uint8_t>((mask >> lane) & 1);
+            visibility[i + lane] = isVisible;
+            visibleCount += isVisible;
+        }
+    }
+#elif defined(UNICORN_FRUSTUM_SSE)
+    // Each plane is tested against 4 spheres at once
+    __m128 planeX[6], planeY[6], planeZ[6], planeW[6];
+
+    for(int plane = 0; plane < 6; ++plane)
+    {
+        planeX[plane] = _mm_set1_ps(m_planes[plane].x);
+        planeY[plane] = _mm_set1_ps(m_planes[plane].y);
+        planeZ[plane] = _mm_set1_ps(m_planes[plane].z);
+        planeW[plane] = _mm_set1_ps(m_planes[plane].w);
+    }
+
+    __m128 const zero = _mm_setzero_ps();
+
+    for(; i + 4 <= count; i += 4)
+    {
+        __m128 const x = _mm_loadu_ps(pX + i);
+        __m128 const y = _mm_loadu_ps(pY + i);
+        __m128 const z = _mm_loadu_ps(pZ + i);
+        __m128 const negativeRadius = _mm_sub_ps(zero, _mm_loadu_ps(pRadius + i));
+
+        __m128 inside = _mm_cmpeq_ps(zero, zero);
+
+        for(int plane = 0; plane < 6; ++plane)
+        {
+            __m128 distance = _mm_add_ps(_mm_mul_ps(planeX[plane], x), planeW[plane]);
+            distance = _mm_add_ps(distance, _mm_mul_ps(planeY[plane], y));
+            distance = _mm_add_ps(distance, _mm_mul_ps(planeZ[plane], z));
+
+            inside = _mm_and_ps(inside, _mm_cmpge_ps(distance, negativeRadius));
+        }
+
+        int const mask = _mm_movemask_ps(inside);
+
+        for(int lane = 0; lane < 4; ++lane)
+        {
+            uint8_t const isVisible = static_cast<uint8_t>((mask >> lane) & 1);
+            visibility[i + lane] = isVisible;
+            visibleCount += isVisible;
+        }
+    }
+#endif
+
+    // Spheres which don't fill a whole register
+    for(; i < count; ++i)
+    {
+        BoundingSphere sphere;
+        sphere.center = glm::vec3(pX[i], pY[i], pZ[i]);
+        sphere.radius = pRadius[i];
+
+        uint8_t const isVisible = Intersects(sphere) ? 1 : 0;
+        visibility[i] = isVisible;
+        visibleCount += isVisible;
+    }
+
+    return visibleCount;
+}
+}
+}
@@ -13,8 +13,10 @@
 
 #include <unicorn/video/vulkan/Context.hpp>
 #include <unicorn/video/vulkan/Renderer.hpp>
+#include <unicorn/video/vulkan/ShaderModuleCache.hpp>
 
 #include <unicorn/utility/InternalLoggers.hpp>
+#include <unicorn/utility/Settings.hpp>
 
 namespace unicorn
 {
@@ -48,7 +50,7 @@ bool Graphics::Init(const DriverType& driver)
     switch (m_driver)
     {
     case DriverType::Vulkan:
-        if (!m_systemManager.IsVulkanSupported())
+        if (!utility::Settings::Instance().IsHeadless() && !m_systemManager.IsVulkanSupported())
         {
             LOG_VIDEO->Error("Vulkan not supported!");
             return false;
@@ -80,6 +82,8 @@ void Graphics::Deinit()
     switch (m_driver)
     {
     case DriverType::Vulkan:
+        // Renderers released their shader modules, cached code is dropped with the context
+        vulkan::ShaderModuleCache::Destroy();
         vulkan::Context::Instance().Deinitialize();
         break;
     }
@@ -98,7 +102,8 @@ bool Graphics::Render()
     {
         for (RendererWindowPairSet::const_iterator cit = m_renderers.cbegin(); cit != m_renderers.cend();)
         {
-            if (!cit->second->ShouldClose() && cit->first->Render())
+            // Headless renderers have no window and live until they fail
+            if ((!cit->second || !cit->second->ShouldClose()) && cit->first->Render())
             {
                 ++cit;
             }
@@ -180,7 +185,7 @@ void Graphics::ProcessExpiredRenderers()
         {
             delete cit->first;
 
-            if (!m_systemManager.DestroyWindow(cit->second))
+            if (cit->second && !m_systemManager.DestroyWindow(cit->second))
             {
                 LOG_VIDEO->Warning("Failed to destroy window {}", cit->second->GetName().c_str());
 
@@ -213,5 +218,27 @@ Renderer* Graphics::SpawnRenderer(system::Window* window, Camera& camera)
     }
     return renderer;
 }
+
+Renderer* Graphics::SpawnHeadlessRenderer(uint32_t width, uint32_t height, Camera& camera)
+{
+    vulkan::Renderer* renderer = nullptr;
+    switch (m_driver)
+    {
+        case DriverType::Vulkan:
+            renderer = new vulkan::Renderer(m_systemManager, width, height, camera);
+            if(!renderer->Init())
+            {
+                LOG_VIDEO->Error("Can't Create headless Vulkan renderer!");
+                delete renderer;
+                return nullptr;
+            }
+            BindWindowRenderer(nullptr, renderer);
+            break;
+        default:
+            LOG_VIDEO->Error("Unexpected render type!");
+            break;
+    }
+    return renderer;
+}
 }
 }
@@ -20,6 +20,7 @@ Material::Material()
     , m_isColored(true)
     , m_isWired(false)
     , m_isVisible(true)
+    , m_isTransparent(false)
     , m_albedo(nullptr)
 {
 }
@@ -99,6 +100,18 @@ bool Material::IsVisible() const
     return m_isVisible;
 }
 
+void Material::SetIsTransparent(bool transparent)
+{
+    m_isTransparent = transparent;
+
+    DataUpdated.emit();
+}
+
+bool Material::IsTransparent() const
+{
+    return m_isTransparent;
+}
+
 std::shared_ptr<Texture> Material::GetAlbedo() const
 {
     return m_albedo;
@@ -29,6 +29,13 @@ void Mesh::SetMeshData(const std::vector<Vertex>& vertices, const std::vector<ui
     m_vertices = vertices;
     m_indices = indices;
 
+    glm::vec3 const* pPositions = m_vertices.empty() ? nullptr : &m_vertices.front().pos;
+
+    m_localBoundingBox = BoundingBox::FromPoints(pPositions, m_vertices.size(), sizeof(Vertex));
+    m_localBoundingSphere = BoundingSphere::FromPoints(m_localBoundingBox, pPositions, m_vertices.size(), sizeof(Vertex));
+
+    OnTransformMatrixUpdated();
+
     VerticesUpdated.emit();
 }
 
@@ -65,5 +72,13 @@ void Mesh::OnMaterialUpdated()
     MaterialUpdated.emit();
 }
 
+void Mesh::OnTransformMatrixUpdated()
+{
+    m_worldBoundingBox = m_localBoundingBox.Transformed(m_transformMatrix);
+    m_worldBoundingSphere = m_localBoundingSphere.Transformed(m_transformMatrix);
+
+    TransformUpdated.emit();
+}
+
 }
 }
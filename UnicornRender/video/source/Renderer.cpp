@@ -21,17 +21,15 @@ Renderer::Renderer(system::Manager& manager, system::Window* window, Camera cons
     , m_pWindow(window)
     , m_backgroundColor({ {0.0f, 0.0f, 0.0f, 0.0f} })
     , m_depthTestEnabled(true)
+    , m_resolutionScale(1.0f)
 {
-    if(m_pWindow == nullptr)
-    {
-        LOG_VIDEO->Error("Window pointer in nullptr!");
-    }
 }
 
 Renderer::~Renderer()
 {
     Destroyed.emit(this);
     Destroyed.clear();
+    FrameReadback.clear();
 }
 
 void Renderer::SetBackgroundColor(const glm::vec3& backgroundColor)
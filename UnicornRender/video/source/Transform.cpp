@@ -194,6 +194,8 @@ void Transform::UpdateTransformMatrix()
         m_transformMatrix = T * R * S;
 
         m_isDirty = false;
+
+        OnTransformMatrixUpdated();
     }
 }
 
@@ -28,7 +28,7 @@ Buffer::~Buffer()
 }
 
 bool Buffer::Create(vk::PhysicalDevice physicalDevice, vk::Device device,
-                    vk::BufferUsageFlags usage, vk::MemoryPropertyFlags memoryPropertyFlags, size_t size)
+                    vk::BufferUsageFlags usage, MemoryUsage memoryUsage, size_t size)
 {
     if(size == 0)
     {
@@ -53,13 +53,16 @@ bool Buffer::Create(vk::PhysicalDevice physicalDevice, vk::Device device,
         return false;
     }
 
-    vk::PhysicalDeviceMemoryProperties memoryProperties;
-    physicalDevice.getMemoryProperties(&memoryProperties);
+    MemoryAllocator* pAllocator = MemoryAllocator::Find(m_device);
+    if(!pAllocator)
+    {
+        LOG_VULKAN->Error("There is no memory allocator for device!");
+        return false;
+    }
 
     vk::MemoryRequirements req;
     m_device.getBufferMemoryRequirements(m_buffer, &req);
-    m_deviceMemory = new Memory(m_device, req.memoryTypeBits, memoryProperties,
-                                vk::MemoryPropertyFlagBits::eHostVisible, req.size);
+    m_deviceMemory = new Memory(*pAllocator, req, memoryUsage, true);
     if(!m_deviceMemory->IsInitialized())
     {
         LOG_VULKAN->Error("Can't allocate memory on gpu!");
@@ -73,7 +76,7 @@ bool Buffer::Create(vk::PhysicalDevice physicalDevice, vk::Device device,
     m_descriptor.buffer = m_buffer;
     m_descriptor.range = VK_WHOLE_SIZE;
 
-    m_device.bindBufferMemory(m_buffer, m_deviceMemory->GetMemory(), 0);
+    m_device.bindBufferMemory(m_buffer, m_deviceMemory->GetMemory(), m_deviceMemory->GetOffset());
     return true;
 }
 
@@ -104,20 +107,62 @@ void Buffer::Write(const void* pData) const
     }
 }
 
+void Buffer::Write(const void* pData, size_t size, size_t offset) const
+{
+    if(offset + size > m_size)
+    {
+        LOG_VULKAN->Error("Can't write {} bytes at offset {}, buffer size is {}!", size, offset, m_size);
+    }
+    else if(m_mappedMemory)
+    {
+        memcpy(static_cast<uint8_t*>(m_mappedMemory) + offset, pData, size);
+    }
+    else
+    {
+        LOG_VULKAN->Warning("Can't write buffer, because it's not mapped!");
+    }
+}
+
 void Buffer::Map()
 {
-    if(!m_mappedMemory)
+    // Host visible memory blocks are persistently mapped by allocator
+    if(!m_mappedMemory && m_deviceMemory)
     {
-        m_device.mapMemory(m_deviceMemory->GetMemory(), 0, m_size, vk::MemoryMapFlagBits(), &m_mappedMemory);
+        m_mappedMemory = m_deviceMemory->GetMappedData();
+
+        if(!m_mappedMemory)
+        {
+            LOG_VULKAN->Warning("Can't map buffer, because its memory is not host visible!");
+        }
     }
 }
 
 void Buffer::Unmap()
 {
-    if(m_mappedMemory)
+    m_mappedMemory = nullptr;
+}
+
+void Buffer::Flush() const
+{
+    if(m_deviceMemory)
     {
-        m_device.unmapMemory(m_deviceMemory->GetMemory());
-        m_mappedMemory = nullptr;
+        m_deviceMemory->Flush();
+    }
+}
+
+void Buffer::Flush(size_t offset, size_t size) const
+{
+    if(m_deviceMemory)
+    {
+        m_deviceMemory->Flush(offset, size);
+    }
+}
+
+void Buffer::Invalidate() const
+{
+    if(m_deviceMemory)
+    {
+        m_deviceMemory->Invalidate();
     }
 }
 
@@ -158,6 +203,11 @@ void Buffer::CopyToImage(const vulkan::Image& dstImage, const vk::CommandPool& p
     EndSingleTimeCommands(commandBuffer, queue, m_device, pool);
 }
 
+void const* Buffer::GetMappedMemory() const
+{
+    return m_mappedMemory;
+}
+
 size_t Buffer::GetSize() const
 {
     return m_size;
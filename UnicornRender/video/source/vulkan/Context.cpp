@@ -80,6 +80,16 @@ bool Context::Initialize(system::Manager& manager)
 
     m_instanceExtensions = FillRequiredExtensions(manager);
 
+    // Without window system there is nothing to present to
+    if (settings.IsHeadless())
+    {
+        m_deviceExtensions.clear();
+    }
+    else
+    {
+        m_deviceExtensions = {VK_KHR_SWAPCHAIN_EXTENSION_NAME};
+    }
+
     createInfo.enabledExtensionCount = static_cast<uint32_t>(m_instanceExtensions.size());
     createInfo.ppEnabledExtensionNames = m_instanceExtensions.data();
 
@@ -160,13 +170,35 @@ void Context::Deinitialize()
 
 std::vector<const char*> Context::FillRequiredExtensions(system::Manager& manager)
 {
-    std::vector<const char*> extensions(manager.GetRequiredVulkanExtensions());
+    std::vector<const char*> extensions;
+
+    if (!utility::Settings::Instance().IsHeadless())
+    {
+        extensions = manager.GetRequiredVulkanExtensions();
+    }
 
     if (s_enableValidationLayers)
     {
         extensions.push_back(VK_EXT_DEBUG_REPORT_EXTENSION_NAME);
     }
 
+    // Optional, lets devices report memory budget through VK_EXT_memory_budget
+    vk::Result result;
+    std::vector<vk::ExtensionProperties> availableExtensions;
+    std::tie(result, availableExtensions) = vk::enumerateInstanceExtensionProperties();
+
+    if (result == vk::Result::eSuccess)
+    {
+        for (auto const& extension : availableExtensions)
+        {
+            if (strcmp(extension.extensionName, VK_KHR_GET_PHYSICAL_DEVICE_PROPERTIES_2_EXTENSION_NAME) == 0)
+            {
+                extensions.push_back(VK_KHR_GET_PHYSICAL_DEVICE_PROPERTIES_2_EXTENSION_NAME);
+                break;
+            }
+        }
+    }
+
     return extensions;
 }
 
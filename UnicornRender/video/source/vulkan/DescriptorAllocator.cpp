@@ -0,0 +1,165 @@
+/*
+* Copyright (C) 2017 by Godlike
+* This code is licensed under the MIT license (MIT)
+* (http://opensource.org/licenses/MIT)
+*/
+
+#include <unicorn/video/vulkan/DescriptorAllocator.hpp>
+
+#include <unicorn/utility/InternalLoggers.hpp>
+
+#include <algorithm>
+
+namespace unicorn
+{
+namespace video
+{
+namespace vulkan
+{
+const uint32_t DescriptorAllocator::s_maxPoolScale = 16;
+
+DescriptorAllocator::DescriptorAllocator(vk::Device device, std::vector<vk::DescriptorPoolSize> const& poolSizes, uint32_t maxSets)
+    : m_device(device)
+    , m_poolSizes(poolSizes)
+    , m_maxSets(std::max(maxSets, 1u))
+    , m_currentPool(0)
+{
+}
+
+DescriptorAllocator::~DescriptorAllocator()
+{
+    for(Pool const& pool : m_pools)
+    {
+        // Descriptor sets are freed together with their pool
+        m_device.destroyDescriptorPool(pool.pool);
+    }
+
+    m_pools.clear();
+    m_freeSets.clear();
+}
+
+bool DescriptorAllocator::Allocate(vk::DescriptorSetLayout layout, vk::DescriptorSet& descriptorSet)
+{
+    auto freeSetsIt = m_freeSets.find(layout);
+
+    if(freeSetsIt != m_freeSets.end() && !freeSetsIt->second.empty())
+    {
+        descriptorSet = freeSetsIt->second.back();
+        freeSetsIt->second.pop_back();
+
+        return true;
+    }
+
+    vk::DescriptorSetAllocateInfo allocInfo;
+    allocInfo.descriptorSetCount = 1;
+    allocInfo.pSetLayouts = &layout;
+
+    for(; ; ++m_currentPool)
+    {
+        bool const isNewPool = m_currentPool == m_pools.size();
+
+        if(isNewPool && !CreatePool())
+        {
+            return false;
+        }
+
+        Pool& pool = m_pools[m_currentPool];
+
+        if(pool.allocatedSetsCount == pool.maxSets)
+        {
+            continue;
+        }
+
+        allocInfo.descriptorPool = pool.pool;
+
+        // Pool is treated as exhausted on any error, it may run out of a descriptor type before sets
+        if(m_device.allocateDescriptorSets(&allocInfo, &descriptorSet) == vk::Result::eSuccess)
+        {
+            ++pool.allocatedSetsCount;
+
+            return true;
+        }
+
+        if(isNewPool)
+        {
+            LOG_VULKAN->Error("Can't allocate descriptor set from a new pool!");
+
+            return false;
+        }
+    }
+}
+
+void DescriptorAllocator::Free(vk::DescriptorSetLayout layout, vk::DescriptorSet descriptorSet)
+{
+    m_freeSets[layout].push_back(descriptorSet);
+}
+
+void DescriptorAllocator::Reset()
+{
+    for(Pool& pool : m_pools)
+    {
+        m_device.resetDescriptorPool(pool.pool);
+        pool.allocatedSetsCount = 0;
+    }
+
+    m_currentPool = 0;
+    m_freeSets.clear();
+}
+
+DescriptorAllocator::Stats DescriptorAllocator::GetStats() const
+{
+    Stats stats;
+    stats.poolsCount = static_cast<uint32_t>(m_pools.size());
+
+    for(Pool const& pool : m_pools)
+    {
+        stats.setsCapacity += pool.maxSets;
+        stats.allocatedSetsCount += pool.allocatedSetsCount;
+    }
+
+    for(auto const& freeSets : m_freeSets)
+    {
+        stats.recycledSetsCount += static_cast<uint32_t>(freeSets.second.size());
+    }
+
+    return stats;
+}
+
+bool DescriptorAllocator::CreatePool()
+{
+    uint32_t scale = 1;
+
+    for(size_t i = 0; i < m_pools.size() && scale < s_maxPoolScale; ++i)
+    {
+        scale *= 2;
+    }
+
+    std::vector<vk::DescriptorPoolSize> poolSizes = m_poolSizes;
+
+    for(auto& poolSize : poolSizes)
+    {
+        poolSize.descriptorCount *= scale;
+    }
+
+    Pool pool;
+    pool.maxSets = m_maxSets * scale;
+
+    vk::DescriptorPoolCreateInfo poolCreateInfo;
+    poolCreateInfo.poolSizeCount = static_cast<uint32_t>(poolSizes.size());
+    poolCreateInfo.pPoolSizes = poolSizes.data();
+    poolCreateInfo.maxSets = pool.maxSets;
+
+    if(m_device.createDescriptorPool(&poolCreateInfo, nullptr, &pool.pool) != vk::Result::eSuccess)
+    {
+        LOG_VULKAN->Error("Can't create descriptor pool!");
+
+        return false;
+    }
+
+    m_pools.push_back(pool);
+
+    return true;
+}
+}
+}
+}
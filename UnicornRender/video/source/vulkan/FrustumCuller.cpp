@@ -0,0 +1,247 @@
+/*
+* Copyright (C) 2017 by Godlike
+* This code is licensed under the MIT license (MIT)
+* (http://opensource.org/licenses/MIT)
+*/
+
+#include <unicorn/video/vulkan/FrustumCuller.hpp>
+#include <unicorn/video/vulkan/ShaderModuleCache.hpp>
+
+#include <unicorn/utility/InternalLoggers.hpp>
+
+#include <algorithm>
+#include <tuple>
+
+namespace unicorn
+{
+namespace video
+{
+namespace vulkan
+{
+const uint32_t FrustumCuller::s_maxWorkgroupsX = 65535;
+
+FrustumCuller::FrustumCuller(vk::Device device)
+    : m_device(device)
+{
+}
+
+FrustumCuller::~FrustumCuller()
+{
+    Destroy();
+}
+
+bool FrustumCuller::Create(uint32_t framesCount, vk::PipelineCache pipelineCache)
+{
+    Destroy();
+
+    ShaderModuleCache::Module const shaderModule = ShaderModuleCache::Instance().Acquire(m_device, "data/shaders/FrustumCulling.comp.spv");
+    m_shaderModule = shaderModule.module;
+
+    if(!m_shaderModule)
+    {
+        LOG_VULKAN->Error("Can't create frustum culling shader module!");
+        return false;
+    }
+
+    // Instances, culling data, commands, visible instances, counters and groups
+    std::array<vk::DescriptorSetLayoutBinding, 6> bindings;
+
+    for(uint32_t i = 0; i < bindings.size(); ++i)
+    {
+        bindings[i].binding = i;
+        bindings[i].descriptorType = vk::DescriptorType::eStorageBuffer;
+        bindings[i].descriptorCount = 1;
+        bindings[i].stageFlags = vk::ShaderStageFlagBits::eCompute;
+    }
+
+    // Shader must agree with buffers bound by UpdateDescriptorSet() and Parameters
+    if(shaderModule.pReflection->bindings.size() != bindings.size() ||
+        shaderModule.pReflection->pushConstantSize > sizeof(Parameters))
+    {
+        LOG_VULKAN->Error("Frustum culling shader doesn't match its pipeline layout!");
+        Destroy();
+        return false;
+    }
+
+    vk::DescriptorSetLayoutCreateInfo layoutInfo;
+    layoutInfo.bindingCount = static_cast<uint32_t>(bindings.size());
+    layoutInfo.pBindings = bindings.data();
+
+    vk::Result result = m_device.createDescriptorSetLayout(&layoutInfo, {}, &m_descriptorSetLayout);
+    if(result != vk::Result::eSuccess)
+    {
+        LOG_VULKAN->Error("Can't create frustum culling descriptor set layout!");
+        Destroy();
+        return false;
+    }
+
+    vk::PushConstantRange pushConstantRange;
+    pushConstantRange.stageFlags = vk::ShaderStageFlagBits::eCompute;
+    pushConstantRange.offset = 0;
+    pushConstantRange.size = sizeof(Parameters);
+
+    vk::PipelineLayoutCreateInfo pipelineLayoutInfo;
+    pipelineLayoutInfo.setLayoutCount = 1;
+    pipelineLayoutInfo.pSetLayouts = &m_descriptorSetLayout;
+    pipelineLayoutInfo.pushConstantRangeCount = 1;
+    pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
+
+    result = m_device.createPipelineLayout(&pipelineLayoutInfo, {}, &m_pipelineLayout);
+    if(result != vk::Result::eSuccess)
+    {
+        LOG_VULKAN->Error("Can't create frustum culling pipeline layout!");
+        Destroy();
+        return false;
+    }
+
+    vk::ComputePipelineCreateInfo pipelineInfo;
+    pipelineInfo.stage.stage = vk::ShaderStageFlagBits::eCompute;
+    pipelineInfo.stage.module = m_shaderModule;
+    pipelineInfo.stage.pName = "main";
+    pipelineInfo.layout = m_pipelineLayout;
+
+    std::tie(result, m_pipeline) = m_device.createComputePipeline(pipelineCache, pipelineInfo);
+    if(result != vk::Result::eSuccess)
+    {
+        LOG_VULKAN->Error("Can't create frustum culling pipeline!");
+        m_pipeline = nullptr;
+        Destroy();
+        return false;
+    }
+
+    vk::DescriptorPoolSize poolSize;
+    poolSize.type = vk::DescriptorType::eStorageBuffer;
+    poolSize.descriptorCount = framesCount * static_cast<uint32_t>(bindings.size());
+
+    vk::DescriptorPoolCreateInfo poolInfo;
+    poolInfo.maxSets = framesCount;
+    poolInfo.poolSizeCount = 1;
+    poolInfo.pPoolSizes = &poolSize;
+
+    result = m_device.createDescriptorPool(&poolInfo, {}, &m_descriptorPool);
+    if(result != vk::Result::eSuccess)
+    {
+        LOG_VULKAN->Error("Can't create frustum culling descriptor pool!");
+        Destroy();
+        return false;
+    }
+
+    std::vector<vk::DescriptorSetLayout> const layouts(framesCount, m_descriptorSetLayout);
+    m_descriptorSets.resize(framesCount);
+
+    vk::DescriptorSetAllocateInfo allocInfo;
+    allocInfo.descriptorPool = m_descriptorPool;
+    allocInfo.descriptorSetCount = framesCount;
+    allocInfo.pSetLayouts = layouts.data();
+
+    result = m_device.allocateDescriptorSets(&allocInfo, m_descriptorSets.data());
+    if(result != vk::Result::eSuccess)
+    {
+        LOG_VULKAN->Error("Can't allocate frustum culling descriptor sets!");
+        Destroy();
+        return false;
+    }
+
+    return true;
+}
+
+void FrustumCuller::Destroy()
+{
+    if(m_descriptorPool)
+    {
+        // Descriptor sets are freed together with their pool
+        m_device.destroyDescriptorPool(m_descriptorPool);
+        m_descriptorPool = nullptr;
+    }
+    m_descriptorSets.clear();
+
+    if(m_pipeline)
+    {
+        m_device.destroyPipeline(m_pipeline);
+        m_pipeline = nullptr;
+    }
+
+    if(m_pipelineLayout)
+    {
+        m_device.destroyPipelineLayout(m_pipelineLayout);
+        m_pipelineLayout = nullptr;
+    }
+
+    if(m_descriptorSetLayout)
+    {
+        m_device.destroyDescriptorSetLayout(m_descriptorSetLayout);
+        m_descriptorSetLayout = nullptr;
+    }
+
+    if(m_shaderModule)
+    {
+        ShaderModuleCache::Instance().Release(m_device, m_shaderModule);
+        m_shaderModule = nullptr;
+    }
+}
+
+void FrustumCuller::UpdateDescriptorSet(uint32_t frameIndex,
+                                        Buffer const& instances,
+                                        Buffer const& cullingData,
+                                        Buffer const& commands,
+                                        Buffer const& visibleInstances,
+                                        Buffer const& counters,
+                                        Buffer const& groups) const
+{
+    std::array<vk::DescriptorBufferInfo const*, 6> const bufferInfos = {{
+        &instances.GetDescriptorInfo(),
+        &cullingData.GetDescriptorInfo(),
+        &commands.GetDescriptorInfo(),
+        &visibleInstances.GetDescriptorInfo(),
+        &counters.GetDescriptorInfo(),
+        &groups.GetDescriptorInfo()
+    }};
+
+    std::array<vk::WriteDescriptorSet, 6> writes;
+
+    for(uint32_t i = 0; i < writes.size(); ++i)
+    {
+        writes[i].dstSet = m_descriptorSets[frameIndex];
+        writes[i].dstBinding = i;
+        writes[i].descriptorType = vk::DescriptorType::eStorageBuffer;
+        writes[i].descriptorCount = 1;
+        writes[i].pBufferInfo = bufferInfos[i];
+    }
+
+    m_device.updateDescriptorSets(static_cast<uint32_t>(writes.size()), writes.data(), 0, nullptr);
+}
+
+void FrustumCuller::Record(vk::CommandBuffer commandBuffer, uint32_t frameIndex, Frustum const& frustum, uint32_t commandCount) const
+{
+    Parameters parameters;
+    parameters.planes = frustum.GetPlanes();
+    parameters.commandCount = commandCount;
+
+    commandBuffer.bindPipeline(vk::PipelineBindPoint::eCompute, m_pipeline);
+    commandBuffer.bindDescriptorSets(vk::PipelineBindPoint::eCompute, m_pipelineLayout,
+        0, 1, &m_descriptorSets[frameIndex], 0, nullptr);
+    commandBuffer.pushConstants(m_pipelineLayout, vk::ShaderStageFlagBits::eCompute, 0, sizeof(Parameters), &parameters);
+
+    // One workgroup per command, commands which don't fit into X axis continue along Y axis
+    if(commandCount > 0)
+    {
+        uint32_t const workgroupsX = std::min(commandCount, s_maxWorkgroupsX);
+        commandBuffer.dispatch(workgroupsX, (commandCount + workgroupsX - 1) / workgroupsX, 1);
+    }
+
+    // Draws read commands, vertex shader reads visible instances, host reads counters after frame fence
+    vk::MemoryBarrier barrier;
+    barrier.srcAccessMask = vk::AccessFlagBits::eShaderWrite;
+    barrier.dstAccessMask = vk::AccessFlagBits::eIndirectCommandRead
+        | vk::AccessFlagBits::eShaderRead
+        | vk::AccessFlagBits::eHostRead;
+
+    commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eComputeShader,
+        vk::PipelineStageFlagBits::eDrawIndirect | vk::PipelineStageFlagBits::eVertexShader | vk::PipelineStageFlagBits::eHost,
+        {}, 1, &barrier, 0, nullptr, 0, nullptr);
+}
+}
+}
+}
+}
+}
@@ -0,0 +1,437 @@
+/*
+* Copyright (C) 2017 by Godlike
+* This code is licensed under the MIT license (MIT)
+* (http://opensource.org/licenses/MIT)
+*/
+
+#include <unicorn/video/vulkan/GeometryArena.hpp>
+#include <unicorn/video/vulkan/UploadService.hpp>
+
+#include <unicorn/utility/Hash.hpp>
+#include <unicorn/utility/InternalLoggers.hpp>
+
+#include <algorithm>
+#include <cstring>
+#include <iterator>
+#include <limits>
+
+namespace unicorn
+{
+namespace video
+{
+namespace vulkan
+{
+const uint32_t GeometryArena::s_invalidPage = std::numeric_limits<uint32_t>::max();
+const uint32_t GeometryArena::s_pageVertexCount = 1 << 20;
+const uint32_t GeometryArena::s_pageIndexCount = 1 << 22;
+
+GeometryArena::GeometryArena(vk::PhysicalDevice physicalDevice, vk::Device device, UploadService& uploadService)
+    : m_physicalDevice(physicalDevice)
+    , m_device(device)
+    , m_uploadService(uploadService)
+    , m_sharedAllocationsCount(0)
+    , m_destroyedPagesCount(0)
+{
+}
+
+GeometryArena::~GeometryArena()
+{
+    for(Page* pPage : m_pages)
+    {
+        delete pPage;
+    }
+
+    m_pages.clear();
+}
+
+bool GeometryArena::Allocate(std::vector<Vertex> const& vertices,
+                             std::vector<uint32_t> const& indices,
+                             Allocation& allocation,
+                             uint64_t& uploadToken)
+{
+    allocation = Allocation();
+    uploadToken = UploadService::s_completeToken;
+
+    if(vertices.empty() || indices.empty())
+    {
+        return false;
+    }
+
+    uint64_t const contentHash = HashGeometry(vertices, indices);
+    auto geometryIdIt = m_geometryIds.find(contentHash);
+
+    if(geometryIdIt != m_geometryIds.end())
+    {
+        SharedGeometry& geometry = m_geometries[geometryIdIt->second];
+
+        if(IsEvacuated(geometry.allocation.pageIndex))
+        {
+            // Existing references keep old ranges until they are reallocated
+            m_geometryIds.erase(geometryIdIt);
+        }
+        else if(IsSameGeometry(geometry, vertices, indices))
+        {
+            ++geometry.referencesCount;
+            ++m_sharedAllocationsCount;
+
+            allocation = geometry.allocation;
+            uploadToken = geometry.uploadToken;
+
+            return true;
+        }
+    }
+
+    if(!AllocateRanges(vertices, indices, allocation, uploadToken))
+    {
+        return false;
+    }
+
+    if(m_freeGeometryIds.empty())
+    {
+        allocation.geometryId = static_cast<uint32_t>(m_geometries.size());
+        m_geometries.emplace_back();
+    }
+    else
+    {
+        allocation.geometryId = m_freeGeometryIds.back();
+        m_freeGeometryIds.pop_back();
+    }
+
+    SharedGeometry& geometry = m_geometries[allocation.geometryId];
+    geometry.allocation = allocation;
+    geometry.contentHash = contentHash;
+    geometry.vertices = vertices;
+    geometry.indices = indices;
+    geometry.uploadToken = uploadToken;
+    geometry.referencesCount = 1;
+
+    // Colliding geometry takes the hash over, previous one is not shared anymore
+    m_geometryIds[contentHash] = allocation.geometryId;
+
+    return true;
+}
+
+void GeometryArena::Free(Allocation& allocation)
+{
+    if(!allocation.IsValid() || allocation.geometryId >= m_geometries.size())
+    {
+        allocation = Allocation();
+        return;
+    }
+
+    SharedGeometry& geometry = m_geometries[allocation.geometryId];
+
+    if(geometry.referencesCount > 1)
+    {
+        --geometry.referencesCount;
+        --m_sharedAllocationsCount;
+    }
+    else
+    {
+        auto geometryIdIt = m_geometryIds.find(geometry.contentHash);
+
+        if(geometryIdIt != m_geometryIds.end() && geometryIdIt->second == allocation.geometryId)
+        {
+            m_geometryIds.erase(geometryIdIt);
+        }
+
+        FreeRanges(geometry.allocation);
+
+        geometry = SharedGeometry();
+        m_freeGeometryIds.push_back(allocation.geometryId);
+    }
+
+    allocation = Allocation();
+}
+
+uint64_t GeometryArena::HashGeometry(std::vector<Vertex> const& vertices, std::vector<uint32_t> const& indices)
+{
+    uint64_t const hash = utility::HashBytes(vertices.data(), sizeof(Vertex) * vertices.size());
+
+    return utility::HashBytes(indices.data(), sizeof(uint32_t) * indices.size(), hash);
+}
+
+bool GeometryArena::IsSameGeometry(SharedGeometry const& geometry,
+                                   std::vector<Vertex> const& vertices,
+                                   std::vector<uint32_t> const& indices)
+{
+    return geometry.vertices.size() == vertices.size() &&
+           geometry.indices == indices &&
+           std::memcmp(geometry.vertices.data(), vertices.data(), sizeof(Vertex) * vertices.size()) == 0;
+}
+
+bool GeometryArena::AllocateRanges(std::vector<Vertex> const& vertices,
+                                   std::vector<uint32_t> const& indices,
+                                   Allocation& allocation,
+                                   uint64_t& uploadToken)
+{
+    uint32_t const vertexCount = static_cast<uint32_t>(vertices.size());
+    uint32_t const indexCount = static_cast<uint32_t>(indices.size());
+
+    for(uint32_t i = 0; i < m_pages.size() && !allocation.IsValid(); ++i)
+    {
+        if(m_pages[i] && !m_pages[i]->isEvacuated && TakeRanges(*m_pages[i], vertexCount, indexCount, allocation))
+        {
+            allocation.pageIndex = i;
+        }
+    }
+
+    if(!allocation.IsValid())
+    {
+        uint32_t const pageIndex = CreatePage(vertexCount, indexCount);
+
+        if(pageIndex == s_invalidPage || !TakeRanges(*m_pages[pageIndex], vertexCount, indexCount, allocation))
+        {
+            LOG_VULKAN->Error("Can't allocate geometry of {} vertices and {} indices!", vertexCount, indexCount);
+            return false;
+        }
+
+        allocation.pageIndex = pageIndex;
+    }
+
+    Page& page = *m_pages[allocation.pageIndex];
+
+    uint64_t const vertexToken = m_uploadService.UploadBuffer(vertices.data(),
+                                                              sizeof(Vertex) * vertices.size(),
+                                                              page.vertexBuffer,
+                                                              sizeof(Vertex) * allocation.vertexOffset);
+    uint64_t const indexToken = m_uploadService.UploadBuffer(indices.data(),
+                                                             sizeof(uint32_t) * indices.size(),
+                                                             page.indexBuffer,
+                                                             sizeof(uint32_t) * allocation.firstIndex);
+
+    if(vertexToken == UploadService::s_completeToken || indexToken == UploadService::s_completeToken)
+    {
+        // Copy which was recorded writes into ranges nobody reads until they are reused
+        m_uploadService.Finish();
+        FreeRanges(allocation);
+        allocation = Allocation();
+        return false;
+    }
+
+    // Copies are recorded into the same batch unless it was flushed in between
+    uploadToken = std::max(vertexToken, indexToken);
+
+    return true;
+}
+
+void GeometryArena::FreeRanges(Allocation const& allocation)
+{
+    if(allocation.pageIndex >= m_pages.size() || !m_pages[allocation.pageIndex])
+    {
+        return;
+    }
+
+    Page* pPage = m_pages[allocation.pageIndex];
+
+    ReturnRange(pPage->freeVertices, allocation.vertexOffset, allocation.vertexCount);
+    ReturnRange(pPage->freeIndices, allocation.firstIndex, allocation.indexCount);
+
+    --pPage->allocationsCount;
+    pPage->usedVertices -= allocation.vertexCount;
+
+    if(pPage->allocationsCount == 0)
+    {
+        size_t const livePagesCount = m_pages.size() - std::count(m_pages.begin(), m_pages.end(), nullptr);
+
+        // The last page is kept to avoid reallocation when meshes are respawned
+        if(pPage->isEvacuated || livePagesCount > 1)
+        {
+            delete pPage;
+            m_pages[allocation.pageIndex] = nullptr;
+            ++m_destroyedPagesCount;
+        }
+    }
+}
+
+vk::Buffer GeometryArena::GetVertexBuffer(uint32_t pageIndex) const
+{
+    return m_pages[pageIndex]->vertexBuffer.GetVkBuffer();
+}
+
+vk::Buffer GeometryArena::GetIndexBuffer(uint32_t pageIndex) const
+{
+    return m_pages[pageIndex]->indexBuffer.GetVkBuffer();
+}
+
+bool GeometryArena::MarkPagesForEvacuation()
+{
+    size_t const livePagesCount = m_pages.size() - std::count(m_pages.begin(), m_pages.end(), nullptr);
+
+    if(livePagesCount < 2)
+    {
+        return false;
+    }
+
+    bool isMarked = false;
+
+    for(Page* pPage : m_pages)
+    {
+        // Geometry of a page which is less than a quarter full and has holes fits elsewhere
+        if(pPage && !pPage->isEvacuated
+            && static_cast<uint64_t>(pPage->usedVertices) * 4 < pPage->vertexCapacity
+            && pPage->freeVertices.size() > 1)
+        {
+            pPage->isEvacuated = true;
+            isMarked = true;
+        }
+    }
+
+    return isMarked;
+}
+
+bool GeometryArena::IsEvacuated(uint32_t pageIndex) const
+{
+    return pageIndex < m_pages.size() && m_pages[pageIndex] && m_pages[pageIndex]->isEvacuated;
+}
+
+GeometryArena::Stats GeometryArena::GetStats() const
+{
+    Stats stats;
+    stats.sharedAllocationsCount = m_sharedAllocationsCount;
+
+    for(Page const* pPage : m_pages)
+    {
+        if(!pPage)
+        {
+            continue;
+        }
+
+        ++stats.pagesCount;
+        stats.allocationsCount += pPage->allocationsCount;
+        stats.usedVertices += pPage->usedVertices;
+        stats.vertexCapacity += pPage->vertexCapacity;
+        stats.indexCapacity += pPage->indexCapacity;
+        stats.freeVertexRangesCount += static_cast<uint32_t>(pPage->freeVertices.size());
+
+        uint64_t freeIndices = 0;
+
+        for(auto const& range : pPage->freeIndices)
+        {
+            freeIndices += range.second;
+        }
+
+        stats.usedIndices += pPage->indexCapacity - freeIndices;
+    }
+
+    return stats;
+}
+
+uint32_t GeometryArena::CreatePage(uint32_t vertexCount, uint32_t indexCount)
+{
+    Page* pPage = new Page;
+    pPage->vertexCapacity = std::max(vertexCount, s_pageVertexCount);
+    pPage->indexCapacity = std::max(indexCount, s_pageIndexCount);
+
+    if(!pPage->vertexBuffer.Create(m_physicalDevice, m_device,
+                                   vk::BufferUsageFlagBits::eVertexBuffer | vk::BufferUsageFlagBits::eTransferDst,
+                                   MemoryUsage::GpuOnly, sizeof(Vertex) * pPage->vertexCapacity) ||
+        !pPage->indexBuffer.Create(m_physicalDevice, m_device,
+                                   vk::BufferUsageFlagBits::eIndexBuffer | vk::BufferUsageFlagBits::eTransferDst,
+                                   MemoryUsage::GpuOnly, sizeof(uint32_t) * pPage->indexCapacity))
+    {
+        LOG_VULKAN->Error("Can't create geometry page of {} vertices and {} indices!", pPage->vertexCapacity, pPage->indexCapacity);
+        delete pPage;
+        return s_invalidPage;
+    }
+
+    pPage->freeVertices[0] = pPage->vertexCapacity;
+    pPage->freeIndices[0] = pPage->indexCapacity;
+
+    // Slots of destroyed pages are reused, so page indices stay small
+    auto freeSlotIt = std::find(m_pages.begin(), m_pages.end(), nullptr);
+
+    if(freeSlotIt != m_pages.end())
+    {
+        *freeSlotIt = pPage;
+        return static_cast<uint32_t>(freeSlotIt - m_pages.begin());
+    }
+
+    m_pages.push_back(pPage);
+
+    return static_cast<uint32_t>(m_pages.size() - 1);
+}
+
+bool GeometryArena::TakeRanges(Page& page, uint32_t vertexCount, uint32_t indexCount, Allocation& allocation)
+{
+    if(!TakeRange(page.freeVertices, vertexCount, allocation.vertexOffset))
+    {
+        return false;
+    }
+
+    if(!TakeRange(page.freeIndices, indexCount, allocation.firstIndex))
+    {
+        ReturnRange(page.freeVertices, allocation.vertexOffset, vertexCount);
+        return false;
+    }
+
+    allocation.vertexCount = vertexCount;
+    allocation.indexCount = indexCount;
+
+    ++page.allocationsCount;
+    page.usedVertices += vertexCount;
+
+    return true;
+}
+
+bool GeometryArena::TakeRange(std::map<uint32_t, uint32_t>& freeRanges, uint32_t size, uint32_t& offset)
+{
+    auto bestIt = freeRanges.end();
+
+    for(auto it = freeRanges.begin(); it != freeRanges.end(); ++it)
+    {
+        if(it->second >= size && (bestIt == freeRanges.end() || it->second < bestIt->second))
+        {
+            bestIt = it;
+
+            if(it->second == size)
+            {
+                break;
+            }
+        }
+    }
+
+    if(bestIt == freeRanges.end())
+    {
+        return false;
+    }
+
+    offset = bestIt->first;
+    uint32_t const rest = bestIt->second - size;
+
+    freeRanges.erase(bestIt);
+
+    if(rest > 0)
+    {
+        freeRanges[offset + size] = rest;
+    }
+
+    return true;
+}
+
+void GeometryArena::ReturnRange(std::map<uint32_t, uint32_t>& freeRanges, uint32_t offset, uint32_t size)
+{
+    auto nextIt = freeRanges.lower_bound(offset);
+
+    if(nextIt != freeRanges.end() && offset + size == nextIt->first)
+    {
+        size += nextIt->second;
+        nextIt = freeRanges.erase(nextIt);
+    }
+
+    if(nextIt != freeRanges.begin())
+    {
+        auto prevIt = std::prev(nextIt);
+
+        if(prevIt->first + prevIt->second == offset)
+        {
+            prevIt->second += size;
+            return;
+        }
+    }
+
+    freeRanges[offset] = size;
+}
+}
+}
+}
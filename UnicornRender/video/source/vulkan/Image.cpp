@@ -53,13 +53,17 @@ Image::Image(vk::PhysicalDevice physicalDevice,
         return;
     }
 
+    MemoryAllocator* pAllocator = MemoryAllocator::Find(m_device);
+    if(!pAllocator)
+    {
+        LOG_VULKAN->Error("There is no memory allocator for device!");
+        return;
+    }
+
     vk::MemoryRequirements req;
     m_device.getImageMemoryRequirements(m_image, &req);
 
-    vk::PhysicalDeviceMemoryProperties memoryProperties;
-    physicalDevice.getMemoryProperties(&memoryProperties);
-
-    m_deviceMemory = new Memory(m_device, req.memoryTypeBits, memoryProperties, vk::MemoryPropertyFlagBits::eDeviceLocal, req.size);
+    m_deviceMemory = new Memory(*pAllocator, req, MemoryUsage::GpuOnly, false);
 
     if(!m_deviceMemory->IsInitialized())
     {
@@ -67,7 +71,7 @@ Image::Image(vk::PhysicalDevice physicalDevice,
         return;
     }
 
-    m_device.bindImageMemory(m_image, m_deviceMemory->GetMemory(), 0);
+    m_device.bindImageMemory(m_image, m_deviceMemory->GetMemory(), m_deviceMemory->GetOffset());
 
     vk::ImageAspectFlags aspect;
     if(m_usage & vk::ImageUsageFlagBits::eColorAttachment)
@@ -12,40 +12,21 @@ namespace video
 {
 namespace vulkan
 {
-Memory::Memory(vk::Device device, uint32_t typeFilter,
-               vk::PhysicalDeviceMemoryProperties physMemProperties,
-               vk::MemoryPropertyFlagBits reqMemProperties,
-               uint64_t allocSize) : m_initialized(false)
-                                   , m_device(device)
-                                   , m_memory(nullptr)
-{
-    uint32_t memoryTypeIndex = 0;
-    for(uint32_t i = 0; i < physMemProperties.memoryTypeCount; i++)
-    {
-        if((typeFilter & (1 << i))
-            && (physMemProperties.memoryTypes[i].propertyFlags & reqMemProperties) == reqMemProperties)
-        {
-            memoryTypeIndex = i;
-        }
-    }
-
-    vk::MemoryAllocateInfo memoryInfo;
-    memoryInfo.setMemoryTypeIndex(memoryTypeIndex);
-    memoryInfo.setAllocationSize(allocSize);
-
-    vk::Result result = m_device.allocateMemory(&memoryInfo, nullptr, &m_memory);
-    if(result == vk::Result::eSuccess)
-    {
-        m_initialized = true;
-    }
+Memory::Memory(MemoryAllocator& allocator,
+               vk::MemoryRequirements const& requirements,
+               MemoryUsage usage,
+               bool isLinear) : m_initialized(false)
+                              , m_allocator(allocator)
+{
+    m_initialized = m_allocator.Allocate(requirements, usage, isLinear, m_allocation);
 }
 
 Memory::~Memory()
 {
-    if(m_device && m_initialized && m_memory)
+    if(m_initialized)
     {
-        m_device.freeMemory(m_memory);
-        m_memory = nullptr;
+        m_allocator.Free(m_allocation);
+        m_initialized = false;
     }
 }
 
@@ -56,7 +37,32 @@ bool Memory::IsInitialized() const
 
 const vk::DeviceMemory& Memory::GetMemory() const
 {
-    return m_memory;
+    return m_allocation.memory;
+}
+
+vk::DeviceSize Memory::GetOffset() const
+{
+    return m_allocation.offset;
+}
+
+void* Memory::GetMappedData() const
+{
+    return m_allocation.pMappedData;
+}
+
+void Memory::Flush() const
+{
+    m_allocator.Flush(m_allocation);
+}
+
+void Memory::Flush(vk::DeviceSize offset, vk::DeviceSize size) const
+{
+    m_allocator.Flush(m_allocation, offset, size);
+}
+
+void Memory::Invalidate() const
+{
+    m_allocator.Invalidate(m_allocation);
 }
 }
 }
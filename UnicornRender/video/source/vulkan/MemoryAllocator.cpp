@@ -0,0 +1,654 @@
+/*
+* Copyright (C) 2017 by Godlike
+* This code is licensed under the MIT license (MIT)
+* (http://opensource.org/licenses/MIT)
+*/
+
+#include <unicorn/video/vulkan/MemoryAllocator.hpp>
+
+#include <unicorn/utility/InternalLoggers.hpp>
+#include <unicorn/utility/Memory.hpp>
+
+#include <algorithm>
+#include <iterator>
+#include <limits>
+
+namespace unicorn
+{
+namespace video
+{
+namespace vulkan
+{
+namespace
+{
+//! Allocators of all logical devices
+std::map<VkDevice, MemoryAllocator*> s_allocators;
+
+//! Guards s_allocators
+std::mutex s_allocatorsMutex;
+
+uint32_t CountBits(vk::MemoryPropertyFlags flags)
+{
+    uint32_t count = 0;
+
+    for(uint32_t bits = static_cast<uint32_t>(flags); bits != 0; bits &= bits - 1)
+    {
+        ++count;
+    }
+
+    return count;
+}
+
+bool IsCoherent(vk::MemoryPropertyFlags flags)
+{
+    return !(flags & vk::MemoryPropertyFlagBits::eHostVisible) || (flags & vk::MemoryPropertyFlagBits::eHostCoherent);
+}
+}
+
+const vk::DeviceSize MemoryAllocator::s_blockSize = 64 * 1024 * 1024;
+
+// Leaves room for other processes and for the driver when budget is unknown
+const vk::DeviceSize MemoryAllocator::s_estimatedBudgetPercent = 80;
+
+float MemoryAllocator::Stats::GetFragmentation() const
+{
+    vk::DeviceSize const freeBytes = allocatedBytes - usedBytes;
+
+    if(freeBytes == 0)
+    {
+        return 0.0f;
+    }
+
+    return 1.0f - static_cast<float>(largestFreeRange) / static_cast<float>(freeBytes);
+}
+
+MemoryAllocator::MemoryAllocator(vk::Instance instance, vk::PhysicalDevice physicalDevice, vk::Device device, bool hasMemoryBudget)
+    : m_physicalDevice(physicalDevice)
+    , m_device(device)
+    , m_getMemoryProperties2(nullptr)
+    , m_hasReportedFallback(false)
+{
+    physicalDevice.getMemoryProperties(&m_memoryProperties);
+
+    vk::PhysicalDeviceProperties properties;
+    physicalDevice.getProperties(&properties);
+    m_nonCoherentAtomSize = std::max<vk::DeviceSize>(properties.limits.nonCoherentAtomSize, 1);
+
+    // Small heaps (e.g. host visible device local memory) get smaller blocks
+    for(uint32_t i = 0; i < m_memoryProperties.memoryHeapCount; ++i)
+    {
+        vk::DeviceSize const heapSize = m_memoryProperties.memoryHeaps[i].size;
+
+        m_blockSizes.push_back(heapSize / 8 < s_blockSize ? utility::AlignUp(heapSize / 8, 1024 * 1024) : s_blockSize);
+
+        HeapBudget heapBudget;
+        heapBudget.size = heapSize;
+        heapBudget.isDeviceLocal = static_cast<bool>(m_memoryProperties.memoryHeaps[i].flags & vk::MemoryHeapFlagBits::eDeviceLocal);
+        m_heapBudgets.push_back(heapBudget);
+    }
+
+    if(hasMemoryBudget)
+    {
+        m_getMemoryProperties2 = reinterpret_cast<PFN_vkGetPhysicalDeviceMemoryProperties2KHR>(
+            instance.getProcAddr("vkGetPhysicalDeviceMemoryProperties2KHR"));
+    }
+
+    LOG_VULKAN->Info("Memory heap budgets are {}.", m_getMemoryProperties2 ? "reported by driver" : "estimated");
+
+    UpdateBudget();
+
+    std::lock_guard<std::mutex> lock(s_allocatorsMutex);
+    s_allocators[static_cast<VkDevice>(m_device)] = this;
+}
+
+MemoryAllocator::~MemoryAllocator()
+{
+    {
+        std::lock_guard<std::mutex> lock(s_allocatorsMutex);
+        s_allocators.erase(static_cast<VkDevice>(m_device));
+    }
+
+    Stats const stats = GetStats();
+
+    if(stats.allocationsCount != 0)
+    {
+        LOG_VULKAN->Error("Memory allocator is destroyed with {} live allocations!", stats.allocationsCount);
+    }
+
+    for(Block* pBlock : m_blocks)
+    {
+        DestroyBlock(pBlock);
+    }
+
+    m_blocks.clear();
+}
+
+MemoryAllocator* MemoryAllocator::Find(vk::Device device)
+{
+    std::lock_guard<std::mutex> lock(s_allocatorsMutex);
+
+    auto const it = s_allocators.find(static_cast<VkDevice>(device));
+
+    return it != s_allocators.end() ? it->second : nullptr;
+}
+
+bool MemoryAllocator::Allocate(vk::MemoryRequirements const& requirements,
+                               MemoryUsage usage,
+                               bool isLinear,
+                               Allocation& allocation)
+{
+    std::vector<uint32_t> const memoryTypes = RankMemoryTypes(requirements.memoryTypeBits, usage);
+
+    if(memoryTypes.empty())
+    {
+        LOG_VULKAN->Error("Can't find suitable memory type for allocation!");
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    // Heaps out of budget are used only when there is nothing else left
+    for(bool const ignoreBudget : {false, true})
+    {
+        for(uint32_t const memoryTypeIndex : memoryTypes)
+        {
+            if(!AllocateFromType(memoryTypeIndex, requirements, isLinear, ignoreBudget, allocation))
+            {
+                continue;
+            }
+
+            vk::MemoryPropertyFlags const typeFlags = m_memoryProperties.memoryTypes[memoryTypeIndex].propertyFlags;
+
+            if(usage == MemoryUsage::GpuOnly && !(typeFlags & vk::MemoryPropertyFlagBits::eDeviceLocal)
+                && !m_hasReportedFallback && (m_memoryProperties.memoryTypes[memoryTypes.front()].propertyFlags & vk::MemoryPropertyFlagBits::eDeviceLocal))
+            {
+                LOG_VULKAN->Warning("Device local memory is out of budget, GPU only resources are placed into host memory!");
+                m_hasReportedFallback = true;
+            }
+
+            return true;
+        }
+    }
+
+    LOG_VULKAN->Error("Can't allocate {} bytes of device memory!", requirements.size);
+
+    return false;
+}
+
+void MemoryAllocator::Free(Allocation const& allocation)
+{
+    if(!allocation.pBlock)
+    {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    Block* pBlock = static_cast<Block*>(allocation.pBlock);
+
+    --pBlock->allocationsCount;
+
+    if(pBlock->isDedicated)
+    {
+        m_blocks.erase(std::find(m_blocks.begin(), m_blocks.end(), pBlock));
+        DestroyBlock(pBlock);
+
+        return;
+    }
+
+    ReturnRange(*pBlock, allocation.offset, allocation.size);
+
+    if(pBlock->allocationsCount != 0)
+    {
+        return;
+    }
+
+    // One empty block of each kind is kept, so short living resources
+    // like staging buffers don't allocate device memory every time
+    auto const emptyBlock = std::find_if(m_blocks.begin(), m_blocks.end(), [pBlock](Block const* pOther)
+    {
+        return pOther != pBlock
+            && !pOther->isDedicated
+            && pOther->allocationsCount == 0
+            && pOther->memoryTypeIndex == pBlock->memoryTypeIndex
+            && pOther->isLinear == pBlock->isLinear;
+    });
+
+    if(emptyBlock != m_blocks.end())
+    {
+        m_blocks.erase(std::find(m_blocks.begin(), m_blocks.end(), pBlock));
+        DestroyBlock(pBlock);
+    }
+}
+
+void MemoryAllocator::Flush(Allocation const& allocation) const
+{
+    Block const* pBlock = static_cast<Block const*>(allocation.pBlock);
+
+    if(pBlock && !pBlock->isCoherent)
+    {
+        vk::MappedMemoryRange const range = GetMappedRange(allocation);
+        m_device.flushMappedMemoryRanges(1, &range);
+    }
+}
+
+void MemoryAllocator::Flush(Allocation const& allocation, vk::DeviceSize offset, vk::DeviceSize size) const
+{
+    Block const* pBlock = static_cast<Block const*>(allocation.pBlock);
+
+    if(pBlock && !pBlock->isCoherent && size > 0)
+    {
+        vk::MappedMemoryRange const range = GetMappedRange(allocation, offset, size);
+        m_device.flushMappedMemoryRanges(1, &range);
+    }
+}
+
+void MemoryAllocator::Invalidate(Allocation const& allocation) const
+{
+    Block const* pBlock = static_cast<Block const*>(allocation.pBlock);
+
+    if(pBlock && !pBlock->isCoherent)
+    {
+        vk::MappedMemoryRange const range = GetMappedRange(allocation);
+        m_device.invalidateMappedMemoryRanges(1, &range);
+    }
+}
+
+std::vector<MemoryAllocator::HeapBudget> MemoryAllocator::GetHeapBudgets() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    return m_heapBudgets;
+}
+
+MemoryAllocator::Stats MemoryAllocator::GetStats() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    Stats stats;
+
+    for(Block const* pBlock : m_blocks)
+    {
+        ++stats.blocksCount;
+        stats.allocationsCount += pBlock->allocationsCount;
+        stats.allocatedBytes += pBlock->size;
+        stats.usedBytes += pBlock->size;
+
+        if(pBlock->isDedicated)
+        {
+            ++stats.dedicatedBlocksCount;
+        }
+
+        for(auto const& range : pBlock->freeRanges)
+        {
+            ++stats.freeRangesCount;
+            stats.usedBytes -= range.second;
+            stats.largestFreeRange = std::max(stats.largestFreeRange, range.second);
+        }
+    }
+
+    return stats;
+}
+
+std::vector<uint32_t> MemoryAllocator::RankMemoryTypes(uint32_t typeFilter, MemoryUsage usage) const
+{
+    vk::MemoryPropertyFlags required;
+    vk::MemoryPropertyFlags preferred;
+    vk::MemoryPropertyFlags avoided;
+
+    switch(usage)
+    {
+        case MemoryUsage::GpuOnly:
+        {
+            preferred = vk::MemoryPropertyFlagBits::eDeviceLocal;
+            avoided = vk::MemoryPropertyFlagBits::eHostVisible;
+            break;
+        }
+        case MemoryUsage::Upload:
+        {
+            // Small device local host visible heap is kept for dynamic data
+            required = vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent;
+            avoided = vk::MemoryPropertyFlagBits::eDeviceLocal | vk::MemoryPropertyFlagBits::eHostCached;
+            break;
+        }
+        case MemoryUsage::Dynamic:
+        {
+            // Device local host visible memory (ReBAR) saves reading over PCIe in shaders
+            required = vk::MemoryPropertyFlagBits::eHostVisible;
+            preferred = vk::MemoryPropertyFlagBits::eDeviceLocal | vk::MemoryPropertyFlagBits::eHostCoherent;
+            avoided = vk::MemoryPropertyFlagBits::eHostCached;
+            break;
+        }
+        case MemoryUsage::Readback:
+        {
+            required = vk::MemoryPropertyFlagBits::eHostVisible;
+            preferred = vk::MemoryPropertyFlagBits::eHostCached | vk::MemoryPropertyFlagBits::eHostCoherent;
+            break;
+        }
+    }
+
+    std::vector<std::pair<uint32_t, uint32_t>> candidates;
+
+    for(uint32_t i = 0; i < m_memoryProperties.memoryTypeCount; ++i)
+    {
+        vk::MemoryPropertyFlags const flags = m_memoryProperties.memoryTypes[i].propertyFlags;
+
+        if((typeFilter & (1u << i)) && (flags & required) == required)
+        {
+            uint32_t const cost = CountBits(preferred & ~flags) + CountBits(avoided & flags);
+
+            candidates.emplace_back(cost, i);
+        }
+    }
+
+    // Types of equal cost keep driver order, which lists faster types first
+    std::stable_sort(candidates.begin(), candidates.end(), [](std::pair<uint32_t, uint32_t> const& lhs, std::pair<uint32_t, uint32_t> const& rhs)
+    {
+        return lhs.first < rhs.first;
+    });
+
+    std::vector<uint32_t> memoryTypes;
+
+    for(auto const& candidate : candidates)
+    {
+        memoryTypes.push_back(candidate.second);
+    }
+
+    return memoryTypes;
+}
+
+bool MemoryAllocator::AllocateFromType(uint32_t memoryTypeIndex,
+                                       vk::MemoryRequirements const& requirements,
+                                       bool isLinear,
+                                       bool ignoreBudget,
+                                       Allocation& allocation)
+{
+    // Ranges of non-coherent memory are flushed with nonCoherentAtomSize granularity,
+    // so they must not share atoms with neighbours
+    bool const isCoherent = IsCoherent(m_memoryProperties.memoryTypes[memoryTypeIndex].propertyFlags);
+
+    vk::DeviceSize alignment = std::max<vk::DeviceSize>(requirements.alignment, 1);
+    vk::DeviceSize size = requirements.size;
+
+    if(!isCoherent)
+    {
+        alignment = std::max(alignment, m_nonCoherentAtomSize);
+        size = utility::AlignUp(size, m_nonCoherentAtomSize);
+    }
+
+    uint32_t const heapIndex = m_memoryProperties.memoryTypes[memoryTypeIndex].heapIndex;
+    vk::DeviceSize const blockSize = m_blockSizes[heapIndex];
+
+    Block* pTarget = nullptr;
+    vk::DeviceSize offset = 0;
+
+    if(size > blockSize / 2)
+    {
+        if(!ignoreBudget && !FitsBudget(heapIndex, size))
+        {
+            return false;
+        }
+
+        pTarget = CreateBlock(memoryTypeIndex, size, isLinear, true);
+
+        if(!pTarget)
+        {
+            return false;
+        }
+
+        pTarget->freeRanges.clear();
+    }
+    else
+    {
+        for(Block* pBlock : m_blocks)
+        {
+            if(!pBlock->isDedicated
+                && pBlock->memoryTypeIndex == memoryTypeIndex
+                && pBlock->isLinear == isLinear
+                && TakeRange(*pBlock, size, alignment, offset))
+            {
+                pTarget = pBlock;
+                break;
+            }
+        }
+
+        if(!pTarget)
+        {
+            if(!ignoreBudget && !FitsBudget(heapIndex, blockSize))
+            {
+                return false;
+            }
+
+            pTarget = CreateBlock(memoryTypeIndex, blockSize, isLinear, false);
+
+            if(!pTarget || !TakeRange(*pTarget, size, alignment, offset))
+            {
+                return false;
+            }
+        }
+    }
+
+    ++pTarget->allocationsCount;
+
+    allocation.memory = pTarget->memory;
+    allocation.offset = offset;
+    allocation.size = size;
+    allocation.pMappedData = pTarget->pMappedData ? static_cast<uint8_t*>(pTarget->pMappedData) + offset : nullptr;
+    allocation.pBlock = pTarget;
+
+    return true;
+}
+
+bool MemoryAllocator::FitsBudget(uint32_t heapIndex, vk::DeviceSize size)
+{
+    UpdateBudget();
+
+    HeapBudget const& heapBudget = m_heapBudgets[heapIndex];
+
+    return heapBudget.usage + size <= heapBudget.budget;
+}
+
+void MemoryAllocator::UpdateBudget()
+{
+#ifdef VK_EXT_memory_budget
+    if(m_getMemoryProperties2)
+    {
+        VkPhysicalDeviceMemoryBudgetPropertiesEXT budgetProperties = {};
+        budgetProperties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_BUDGET_PROPERTIES_EXT;
+
+        VkPhysicalDeviceMemoryProperties2KHR memoryProperties = {};
+        memoryProperties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_PROPERTIES_2_KHR;
+        memoryProperties.pNext = &budgetProperties;
+
+        m_getMemoryProperties2(static_cast<VkPhysicalDevice>(m_physicalDevice), &memoryProperties);
+
+        for(size_t i = 0; i < m_heapBudgets.size(); ++i)
+        {
+            m_heapBudgets[i].budget = budgetProperties.heapBudget[i];
+            m_heapBudgets[i].usage = budgetProperties.heapUsage[i];
+        }
+
+        return;
+    }
+#endif
+
+    for(HeapBudget& heapBudget : m_heapBudgets)
+    {
+        heapBudget.budget = heapBudget.size / 100 * s_estimatedBudgetPercent;
+        heapBudget.usage = heapBudget.allocatedBytes;
+    }
+}
+
+MemoryAllocator::Block* MemoryAllocator::CreateBlock(uint32_t memoryTypeIndex, vk::DeviceSize size, bool isLinear, bool isDedicated)
+{
+    vk::MemoryAllocateInfo memoryInfo;
+    memoryInfo.setMemoryTypeIndex(memoryTypeIndex);
+    memoryInfo.setAllocationSize(size);
+
+    vk::DeviceMemory memory;
+    vk::Result result = m_device.allocateMemory(&memoryInfo, nullptr, &memory);
+
+    if(result != vk::Result::eSuccess)
+    {
+        LOG_VULKAN->Warning("Can't allocate {} bytes of memory type {}!", size, memoryTypeIndex);
+        return nullptr;
+    }
+
+    vk::MemoryPropertyFlags const typeFlags = m_memoryProperties.memoryTypes[memoryTypeIndex].propertyFlags;
+
+    void* pMappedData = nullptr;
+
+    if(typeFlags & vk::MemoryPropertyFlagBits::eHostVisible)
+    {
+        result = m_device.mapMemory(memory, 0, VK_WHOLE_SIZE, vk::MemoryMapFlags(), &pMappedData);
+
+        if(result != vk::Result::eSuccess)
+        {
+            LOG_VULKAN->Error("Can't map device memory block!");
+            m_device.freeMemory(memory);
+            return nullptr;
+        }
+    }
+
+    Block* pBlock = new Block;
+    pBlock->memory = memory;
+    pBlock->size = size;
+    pBlock->memoryTypeIndex = memoryTypeIndex;
+    pBlock->isLinear = isLinear;
+    pBlock->isDedicated = isDedicated;
+    pBlock->isCoherent = IsCoherent(typeFlags);
+    pBlock->pMappedData = pMappedData;
+    pBlock->freeRanges[0] = size;
+    pBlock->allocationsCount = 0;
+
+    m_blocks.push_back(pBlock);
+
+    m_heapBudgets[m_memoryProperties.memoryTypes[memoryTypeIndex].heapIndex].allocatedBytes += size;
+
+    return pBlock;
+}
+
+void MemoryAllocator::DestroyBlock(Block* pBlock)
+{
+    if(pBlock->pMappedData)
+    {
+        m_device.unmapMemory(pBlock->memory);
+    }
+
+    m_device.freeMemory(pBlock->memory);
+
+    m_heapBudgets[m_memoryProperties.memoryTypes[pBlock->memoryTypeIndex].heapIndex].allocatedBytes -= pBlock->size;
+
+    delete pBlock;
+}
+
+bool MemoryAllocator::TakeRange(Block& block, vk::DeviceSize size, vk::DeviceSize alignment, vk::DeviceSize& offset)
+{
+    auto best = block.freeRanges.end();
+    vk::DeviceSize bestLeftover = std::numeric_limits<vk::DeviceSize>::max();
+
+    for(auto it = block.freeRanges.begin(); it != block.freeRanges.end(); ++it)
+    {
+        vk::DeviceSize const alignedOffset = utility::AlignUp(it->first, alignment);
+        vk::DeviceSize const padding = alignedOffset - it->first;
+
+        if(it->second < padding + size)
+        {
+            continue;
+        }
+
+        vk::DeviceSize const leftover = it->second - padding - size;
+
+        if(leftover < bestLeftover)
+        {
+            best = it;
+            bestLeftover = leftover;
+
+            if(leftover == 0)
+            {
+                break;
+            }
+        }
+    }
+
+    if(best == block.freeRanges.end())
+    {
+        return false;
+    }
+
+    vk::DeviceSize const rangeOffset = best->first;
+    vk::DeviceSize const rangeSize = best->second;
+
+    offset = utility::AlignUp(rangeOffset, alignment);
+
+    block.freeRanges.erase(best);
+
+    // Alignment padding and the tail stay free
+    if(offset > rangeOffset)
+    {
+        block.freeRanges[rangeOffset] = offset - rangeOffset;
+    }
+
+    if(bestLeftover > 0)
+    {
+        block.freeRanges[offset + size] = bestLeftover;
+    }
+
+    return true;
+}
+
+void MemoryAllocator::ReturnRange(Block& block, vk::DeviceSize offset, vk::DeviceSize size)
+{
+    auto next = block.freeRanges.lower_bound(offset);
+
+    if(next != block.freeRanges.end() && offset + size == next->first)
+    {
+        size += next->second;
+        next = block.freeRanges.erase(next);
+    }
+
+    if(next != block.freeRanges.begin())
+    {
+        auto previous = std::prev(next);
+
+        if(previous->first + previous->second == offset)
+        {
+            previous->second += size;
+            return;
+        }
+    }
+
+    block.freeRanges[offset] = size;
+}
+
+vk::MappedMemoryRange MemoryAllocator::GetMappedRange(Allocation const& allocation) const
+{
+    Block const* pBlock = static_cast<Block const*>(allocation.pBlock);
+
+    // Allocations of non-coherent memory are already aligned to nonCoherentAtomSize
+    vk::MappedMemoryRange range;
+    range.memory = allocation.memory;
+    range.offset = allocation.offset;
+    range.size = std::min(allocation.size, pBlock->size - allocation.offset);
+
+    return range;
+}
+
+vk::MappedMemoryRange MemoryAllocator::GetMappedRange(Allocation const& allocation, vk::DeviceSize offset, vk::DeviceSize size) const
+{
+    Block const* pBlock = static_cast<Block const*>(allocation.pBlock);
+
+    // Allocation starts at atom boundary, so aligning relative offsets keeps the range aligned
+    vk::DeviceSize const begin = offset / m_nonCoherentAtomSize * m_nonCoherentAtomSize;
+    vk::DeviceSize const end = std::min(utility::AlignUp(offset + size, m_nonCoherentAtomSize), allocation.size);
+
+    vk::MappedMemoryRange range;
+    range.memory = allocation.memory;
+    range.offset = allocation.offset + begin;
+    range.size = std::min(end - begin, pBlock->size - range.offset);
+
+    return range;
+}
+}
+}
+}
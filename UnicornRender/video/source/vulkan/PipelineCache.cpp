@@ -0,0 +1,236 @@
+/*
+* Copyright (C) 2017 by Godlike
+* This code is licensed under the MIT license (MIT)
+* (http://opensource.org/licenses/MIT)
+*/
+
+#include <unicorn/video/vulkan/PipelineCache.hpp>
+
+#include <unicorn/utility/Hash.hpp>
+#include <unicorn/utility/InternalLoggers.hpp>
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+
+namespace unicorn
+{
+namespace video
+{
+namespace vulkan
+{
+// "UPCF" in file byte order
+const uint32_t PipelineCache::s_magic = 0x46435055;
+const uint32_t PipelineCache::s_version = 1;
+
+PipelineCache::PipelineCache(vk::Device device, vk::PhysicalDeviceProperties const& properties)
+    : m_device(device)
+    , m_properties(properties)
+{
+}
+
+PipelineCache::~PipelineCache()
+{
+    Destroy();
+}
+
+bool PipelineCache::Create(std::string const& path)
+{
+    Destroy();
+
+    m_path = path;
+
+    std::vector<uint8_t> data;
+    Load(data);
+
+    vk::PipelineCacheCreateInfo pipelineCacheCreateInfo;
+    pipelineCacheCreateInfo.initialDataSize = data.size();
+    pipelineCacheCreateInfo.pInitialData = data.empty() ? nullptr : data.data();
+
+    if(m_device.createPipelineCache(&pipelineCacheCreateInfo, nullptr, &m_cache) != vk::Result::eSuccess)
+    {
+        LOG_VULKAN->Error("Can't create pipeline cache!");
+        m_cache = nullptr;
+        return false;
+    }
+
+    return true;
+}
+
+bool PipelineCache::Save() const
+{
+    if(!m_cache || m_path.empty())
+    {
+        return true;
+    }
+
+    size_t dataSize = 0;
+    if(m_device.getPipelineCacheData(m_cache, &dataSize, nullptr) != vk::Result::eSuccess)
+    {
+        LOG_VULKAN->Error("Can't get pipeline cache size!");
+        return false;
+    }
+
+    std::vector<uint8_t> data(dataSize);
+    if(dataSize > 0 && m_device.getPipelineCacheData(m_cache, &dataSize, data.data()) != vk::Result::eSuccess)
+    {
+        LOG_VULKAN->Error("Can't get pipeline cache data!");
+        return false;
+    }
+
+    data.resize(dataSize);
+
+    FileHeader const header = MakeHeader(data);
+    std::string const tempPath = m_path + ".tmp";
+
+    {
+        std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+
+        file.write(reinterpret_cast<char const*>(&header), sizeof(header));
+        file.write(reinterpret_cast<char const*>(data.data()), static_cast<std::streamsize>(data.size()));
+
+        if(!file)
+        {
+            LOG_VULKAN->Error("Can't write pipeline cache file {}!", tempPath);
+            file.close();
+            std::remove(tempPath.c_str());
+            return false;
+        }
+    }
+
+    // Rename doesn't replace existing files on every platform
+    std::remove(m_path.c_str());
+
+    if(std::rename(tempPath.c_str(), m_path.c_str()) != 0)
+    {
+        LOG_VULKAN->Error("Can't replace pipeline cache file {}!", m_path);
+        std::remove(tempPath.c_str());
+        return false;
+    }
+
+    LOG_VULKAN->Info("Saved pipeline cache of {} bytes to {}", static_cast<uint64_t>(data.size()), m_path);
+
+    return true;
+}
+
+void PipelineCache::Destroy()
+{
+    if(m_cache)
+    {
+        Save();
+
+        m_device.destroyPipelineCache(m_cache);
+        m_cache = nullptr;
+    }
+}
+
+PipelineCache::FileHeader PipelineCache::MakeHeader(std::vector<uint8_t> const& data) const
+{
+    FileHeader header;
+    std::memset(&header, 0, sizeof(header));
+
+    header.magic = s_magic;
+    header.version = s_version;
+    header.vendorId = m_properties.vendorID;
+    header.deviceId = m_properties.deviceID;
+    header.driverVersion = m_properties.driverVersion;
+    std::memcpy(header.uuid, &m_properties.pipelineCacheUUID[0], VK_UUID_SIZE);
+    header.dataSize = data.size();
+    header.dataHash = utility::HashBytes(data.data(), data.size());
+
+    return header;
+}
+
+void PipelineCache::Load(std::vector<uint8_t>& data) const
+{
+    data.clear();
+
+    if(m_path.empty())
+    {
+        return;
+    }
+
+    std::ifstream file(m_path, std::ios::binary | std::ios::ate);
+
+    if(!file)
+    {
+        LOG_VULKAN->Info("Pipeline cache file {} is not found, starting with empty cache", m_path);
+        return;
+    }
+
+    uint64_t const fileSize = static_cast<uint64_t>(file.tellg());
+    file.seekg(0);
+
+    FileHeader header;
+    if(fileSize < sizeof(header) || !file.read(reinterpret_cast<char*>(&header), sizeof(header)))
+    {
+        LOG_VULKAN->Warning("Pipeline cache file {} is truncated, starting with empty cache", m_path);
+        return;
+    }
+
+    FileHeader const expected = MakeHeader(data);
+
+    if(header.magic != expected.magic || header.version != expected.version)
+    {
+        LOG_VULKAN->Warning("Pipeline cache file {} has unknown format, starting with empty cache", m_path);
+        return;
+    }
+
+    if(header.vendorId != expected.vendorId ||
+        header.deviceId != expected.deviceId ||
+        header.driverVersion != expected.driverVersion ||
+        std::memcmp(header.uuid, expected.uuid, VK_UUID_SIZE) != 0)
+    {
+        LOG_VULKAN->Info("Pipeline cache file {} was written by another device or driver, starting with empty cache", m_path);
+        return;
+    }
+
+    if(header.dataSize != fileSize - sizeof(header))
+    {
+        LOG_VULKAN->Warning("Pipeline cache file {} is corrupted, starting with empty cache", m_path);
+        return;
+    }
+
+    data.resize(static_cast<size_t>(header.dataSize));
+
+    if(!file.read(reinterpret_cast<char*>(data.data()), static_cast<std::streamsize>(data.size())) ||
+        utility::HashBytes(data.data(), data.size()) != header.dataHash ||
+        !IsDeviceData(data))
+    {
+        LOG_VULKAN->Warning("Pipeline cache file {} is corrupted, starting with empty cache", m_path);
+        data.clear();
+        return;
+    }
+
+    LOG_VULKAN->Info("Loaded pipeline cache of {} bytes from {}", static_cast<uint64_t>(data.size()), m_path);
+}
+
+bool PipelineCache::IsDeviceData(std::vector<uint8_t> const& data) const
+{
+    // Header of VK_PIPELINE_CACHE_HEADER_VERSION_ONE
+    struct
+    {
+        uint32_t headerSize;
+        uint32_t headerVersion;
+        uint32_t vendorId;
+        uint32_t deviceId;
+        uint8_t uuid[VK_UUID_SIZE];
+    } header;
+
+    if(data.size() < sizeof(header))
+    {
+        return false;
+    }
+
+    std::memcpy(&header, data.data(), sizeof(header));
+
+    return header.headerSize >= sizeof(header) &&
+           header.headerSize <= data.size() &&
+           header.headerVersion == VK_PIPELINE_CACHE_HEADER_VERSION_ONE &&
+           header.vendorId == m_properties.vendorID &&
+           header.deviceId == m_properties.deviceID &&
+           std::memcmp(header.uuid, &m_properties.pipelineCacheUUID[0], VK_UUID_SIZE) == 0;
+}
+}
+}
+}
@@ -0,0 +1,243 @@
+/*
+* Copyright (C) 2017 by Godlike
+* This code is licensed under the MIT license (MIT)
+* (http://opensource.org/licenses/MIT)
+*/
+
+#include <unicorn/video/vulkan/PipelineRegistry.hpp>
+#include <unicorn/video/vulkan/ShaderProgram.hpp>
+
+#include <unicorn/utility/InternalLoggers.hpp>
+
+#include <functional>
+#include <tuple>
+
+namespace unicorn
+{
+namespace video
+{
+namespace vulkan
+{
+bool PipelineState::operator==(PipelineState const& other) const
+{
+    return shaderVariant == other.shaderVariant &&
+           shading == other.shading &&
+           topology == other.topology &&
+           polygonMode == other.polygonMode &&
+           cullMode == other.cullMode &&
+           isDepthTest == other.isDepthTest &&
+           isDepthWrite == other.isDepthWrite &&
+           isBlend == other.isBlend;
+}
+
+size_t PipelineState::Hash() const
+{
+    // Fields of core enums fit into a few bits, so they are packed into one value
+    uint64_t const packed = (static_cast<uint64_t>(shaderVariant) << 32) |
+                            (static_cast<uint64_t>(shading) << 24) |
+                            (static_cast<uint64_t>(topology) << 16) |
+                            (static_cast<uint64_t>(polygonMode) << 8) |
+                            (static_cast<uint64_t>(cullMode) << 4) |
+                            (static_cast<uint64_t>(isDepthTest) << 2) |
+                            (static_cast<uint64_t>(isDepthWrite) << 1) |
+                            static_cast<uint64_t>(isBlend);
+
+    return std::hash<uint64_t>()(packed);
+}
+
+PipelineRegistry::PipelineRegistry(vk::Device device, vk::PipelineCache pipelineCache, vk::PipelineLayout pipelineLayout,
+    std::vector<vk::DynamicState> const& dynamicStates)
+    : m_device(device)
+    , m_pipelineCache(pipelineCache)
+    , m_pipelineLayout(pipelineLayout)
+    , m_dynamicStates({vk::DynamicState::eViewport, vk::DynamicState::eScissor})
+    , m_colorFormat(vk::Format::eUndefined)
+    , m_depthFormat(vk::Format::eUndefined)
+{
+    m_dynamicStates.insert(m_dynamicStates.end(), dynamicStates.begin(), dynamicStates.end());
+}
+
+PipelineRegistry::~PipelineRegistry()
+{
+    Clear();
+
+    for(ShaderVariantEntry& variant : m_shaderVariants)
+    {
+        if(variant.pShaderProgram)
+        {
+            variant.pShaderProgram->DestroyShaderModules();
+            delete variant.pShaderProgram;
+        }
+    }
+
+    m_shaderVariants.clear();
+}
+
+void PipelineRegistry::AddShaderVariant(uint32_t variant, std::string const& vertShaderPath, std::string const& fragShaderPath)
+{
+    if(variant >= m_shaderVariants.size())
+    {
+        m_shaderVariants.resize(variant + 1);
+    }
+
+    m_shaderVariants[variant].vertShaderPath = vertShaderPath;
+    m_shaderVariants[variant].fragShaderPath = fragShaderPath;
+}
+
+void PipelineRegistry::SetRenderPass(vk::RenderPass renderPass, vk::Format colorFormat, vk::Format depthFormat)
+{
+    if(colorFormat != m_colorFormat || depthFormat != m_depthFormat)
+    {
+        Clear();
+    }
+
+    m_renderPass = renderPass;
+    m_colorFormat = colorFormat;
+    m_depthFormat = depthFormat;
+}
+
+vk::Pipeline PipelineRegistry::Get(PipelineState const& state)
+{
+    auto pipelineIt = m_pipelines.find(state);
+
+    if(pipelineIt != m_pipelines.end())
+    {
+        return pipelineIt->second;
+    }
+
+    ShaderProgram* pShaderProgram = GetShaderProgram(state.shaderVariant);
+
+    // Failed pipelines are remembered too, so they are not created again every frame
+    vk::Pipeline const pipeline = pShaderProgram ? CreatePipeline(state, *pShaderProgram) : vk::Pipeline();
+    m_pipelines.emplace(state, pipeline);
+
+    return pipeline;
+}
+
+void PipelineRegistry::Clear()
+{
+    for(auto const& pipeline : m_pipelines)
+    {
+        if(pipeline.second)
+        {
+            m_device.destroyPipeline(pipeline.second);
+        }
+    }
+
+    m_pipelines.clear();
+}
+
+ShaderProgram* PipelineRegistry::GetShaderProgram(uint32_t variant)
+{
+    if(variant >= m_shaderVariants.size() || m_shaderVariants[variant].vertShaderPath.empty())
+    {
+        LOG_VULKAN->Error("Shader variant {} is not registered!", variant);
+        return nullptr;
+    }
+
+    ShaderVariantEntry& shaderVariant = m_shaderVariants[variant];
+
+    if(!shaderVariant.pShaderProgram)
+    {
+        shaderVariant.pShaderProgram = new ShaderProgram(m_device, shaderVariant.vertShaderPath, shaderVariant.fragShaderPath);
+    }
+
+    if(!shaderVariant.pShaderProgram->IsCreated())
+    {
+        LOG_VULKAN->Error("Vulkan can't create shader program of variant {}!", variant);
+        return nullptr;
+    }
+
+    return shaderVariant.pShaderProgram;
+}
+
+vk::Pipeline PipelineRegistry::CreatePipeline(PipelineState const& state, ShaderProgram& shaderProgram) const
+{
+    vk::PipelineInputAssemblyStateCreateInfo inputAssembly;
+    inputAssembly.topology = state.topology;
+
+    // Viewport and scissor are dynamic, only their amount is set
+    vk::PipelineViewportStateCreateInfo viewportState;
+    viewportState.viewportCount = 1;
+    viewportState.scissorCount = 1;
+
+    vk::PipelineRasterizationStateCreateInfo rasterizer;
+    rasterizer.lineWidth = 1.0f;
+    rasterizer.cullMode = state.cullMode;
+    rasterizer.frontFace = vk::FrontFace::eClockwise;
+    rasterizer.polygonMode = state.polygonMode;
+
+    vk::PipelineMultisampleStateCreateInfo multisampling; // TODO: configure MSAA at global level.
+    multisampling.sampleShadingEnable = VK_FALSE;
+    multisampling.rasterizationSamples = vk::SampleCountFlagBits::e1;
+    multisampling.minSampleShading = 1.0f;
+    multisampling.pSampleMask = nullptr;
+    multisampling.alphaToCoverageEnable = VK_FALSE;
+    multisampling.alphaToOneEnable = VK_FALSE;
+
+    vk::PipelineDepthStencilStateCreateInfo depthStencil;
+    depthStencil.depthTestEnable = state.isDepthTest;
+    depthStencil.depthWriteEnable = state.isDepthWrite;
+    depthStencil.depthCompareOp = vk::CompareOp::eLessOrEqual;
+    depthStencil.stencilTestEnable = VK_FALSE;
+    depthStencil.back.failOp = vk::StencilOp::eKeep;
+    depthStencil.back.passOp = vk::StencilOp::eKeep;
+    depthStencil.back.compareOp = vk::CompareOp::eAlways;
+    depthStencil.back.compareMask = 0;
+    depthStencil.back.reference = 0;
+    depthStencil.back.depthFailOp = vk::StencilOp::eKeep;
+    depthStencil.back.writeMask = 0;
+    depthStencil.front = depthStencil.back;
+
+    vk::PipelineColorBlendAttachmentState colorBlendAttachment;
+    colorBlendAttachment.colorWriteMask = vk::ColorComponentFlagBits::eR | vk::ColorComponentFlagBits::eG | vk::ColorComponentFlagBits::eB | vk::ColorComponentFlagBits::eA;
+    colorBlendAttachment.blendEnable = state.isBlend;
+    colorBlendAttachment.colorBlendOp = vk::BlendOp::eAdd;
+    colorBlendAttachment.srcColorBlendFactor = vk::BlendFactor::eSrcAlpha;
+    colorBlendAttachment.dstColorBlendFactor = vk::BlendFactor::eOneMinusSrcAlpha;
+
+    vk::PipelineColorBlendStateCreateInfo colorBlending;
+    colorBlending.attachmentCount = 1;
+    colorBlending.pAttachments = &colorBlendAttachment;
+
+    vk::PipelineDynamicStateCreateInfo dynamicState;
+    dynamicState.dynamicStateCount = static_cast<uint32_t>(m_dynamicStates.size());
+    dynamicState.pDynamicStates = m_dynamicStates.data();
+
+    auto vertexInputInfo = shaderProgram.GetVertexInputInfo();
+
+    vk::GraphicsPipelineCreateInfo pipelineInfo;
+    pipelineInfo.stageCount = 2;
+    pipelineInfo.pStages = shaderProgram.GetShaderStageInfoData(state.shading);
+    pipelineInfo.pVertexInputState = &vertexInputInfo;
+    pipelineInfo.pInputAssemblyState = &inputAssembly;
+    pipelineInfo.pViewportState = &viewportState;
+    pipelineInfo.pRasterizationState = &rasterizer;
+    pipelineInfo.pMultisampleState = &multisampling;
+    pipelineInfo.pDepthStencilState = &depthStencil;
+    pipelineInfo.pColorBlendState = &colorBlending;
+    pipelineInfo.pDynamicState = &dynamicState;
+    pipelineInfo.layout = m_pipelineLayout;
+    pipelineInfo.renderPass = m_renderPass;
+    pipelineInfo.subpass = 0;
+    pipelineInfo.basePipelineHandle = nullptr;
+    pipelineInfo.basePipelineIndex = -1; // Optional
+
+    vk::Result result;
+    vk::Pipeline pipeline;
+
+    std::tie(result, pipeline) = m_device.createGraphicsPipeline(m_pipelineCache, pipelineInfo);
+    if(result != vk::Result::eSuccess)
+    {
+        LOG_VULKAN->Error("Can't create pipeline of shader variant {} with shading {}!", state.shaderVariant, static_cast<uint32_t>(state.shading));
+        return vk::Pipeline();
+    }
+
+    LOG_VULKAN->Debug("Created pipeline of shader variant {} with shading {}, {} pipelines in registry.",
+        state.shaderVariant, static_cast<uint32_t>(state.shading), m_pipelines.size() + 1);
+
+    return pipeline;
+}
+}
+}
+}
@@ -10,21 +10,27 @@
 #include <unicorn/system/Manager.hpp>
 #include <unicorn/system/Window.hpp>
 #include <unicorn/video/vulkan/Context.hpp>
+#include <unicorn/video/vulkan/DescriptorAllocator.hpp>
+#include <unicorn/video/vulkan/GeometryArena.hpp>
+#include <unicorn/video/vulkan/MemoryAllocator.hpp>
+#include <unicorn/video/vulkan/PipelineCache.hpp>
+#include <unicorn/video/vulkan/PipelineRegistry.hpp>
+#include <unicorn/video/vulkan/UploadService.hpp>
 #include <unicorn/video/vulkan/VkMesh.hpp>
 #include <unicorn/video/vulkan/VkTexture.hpp>
 #include <unicorn/video/Camera.hpp>
-#include <unicorn/utility/Memory.hpp>
+#include <unicorn/utility/WorkerPool.hpp>
 #include <unicorn/video/Texture.hpp>
 #include <unicorn/video/Material.hpp>
 
 #include <unicorn/utility/InternalLoggers.hpp>
 
-#include <glm/gtc/type_ptr.hpp>
-
 #include <set>
 #include <algorithm>
 #include <tuple>
 #include <chrono>
+#include <cmath>
+#include <cstring>
 
 namespace unicorn
 {
@@ -34,6 +40,24 @@ namespace vulkan
 {
 const uint32_t Renderer::s_swapChainAttachmentsAmount = 2;
 
+// Draw calls of a chunk, smaller chunks cost more in secondary command buffer overhead than they save
+const size_t Renderer::s_minDrawsPerWorker = 64;
+
+// Limits descriptor memory of bindless texture array on devices with huge limits
+const uint32_t Renderer::s_maxBindlessTextures = 16384;
+
+// Material sets of the first descriptor pool, chained pools grow from it
+const uint32_t Renderer::s_materialSetsPerPool = 256;
+
+// Every step re-records draws, so the scale doesn't follow small fluctuations
+const float Renderer::s_resolutionScaleStep = 0.05f;
+
+// GPU times averaged before resolution scale is changed
+const uint32_t Renderer::s_resolutionSamples = 8;
+
+// Part of target frame time scaled up frames are expected to take, keeps scale from oscillating
+const float Renderer::s_upscaleHeadroom = 0.9f;
+
 #ifdef NDEBUG
 const bool Renderer::s_enableValidationLayers = false;
 #else
@@ -45,14 +69,111 @@ bool QueueFamilyIndices::IsComplete() const
     return graphicsFamily >= 0 && presentFamily >= 0;
 }
 
+bool DrawBatch::operator==(DrawBatch const& other) const
+{
+    return pipeline == other.pipeline &&
+           vertexBuffer == other.vertexBuffer &&
+           indexBuffer == other.indexBuffer &&
+           materialDescriptorSet == other.materialDescriptorSet &&
+           firstCommand == other.firstCommand &&
+           commandCount == other.commandCount;
+}
+
+DrawCounters& DrawCounters::operator+=(DrawCounters const& other)
+{
+    pipelineBinds += other.pipelineBinds;
+    vertexBufferBinds += other.vertexBufferBinds;
+    descriptorSetBinds += other.descriptorSetBinds;
+    drawCalls += other.drawCalls;
+    skippedBinds += other.skippedBinds;
+
+    return *this;
+}
+
 Renderer::Renderer(system::Manager& manager, system::Window* window, Camera const& camera)
     : video::Renderer(manager, window, camera)
+    , m_pDescriptorAllocator(nullptr)
+    , m_pPipelineCache(nullptr)
+    , m_pPipelineRegistry(nullptr)
+    , m_pDepthImage(nullptr)
+    , m_upscaleFilter(vk::Filter::eLinear)
+    , m_timestampPeriod(0.0f)
+    , m_timestampMask(0)
+    , m_bindlessCapacity(0)
+    , m_bindlessTextureCount(0)
+    , m_currentFrame(0)
+    , m_pWorkerPool(nullptr)
+    , m_pMemoryAllocator(nullptr)
+    , m_pUploadService(nullptr)
+    , m_pGeometryArena(nullptr)
+    , m_pFrustumCuller(nullptr)
+    , m_contextInstance(Context::Instance().GetVkInstance())
+    , m_hasDirtyMeshes(false)
+    , m_isHeadless(false)
+    , m_frameCounter(0)
+    , m_hasMultiDrawIndirect(false)
+    , m_hasIndirectFirstInstance(false)
+    , m_isBindless(false)
+    , m_isShaderSpecialization(true)
+    , m_hasExtendedDynamicState(false)
+    , m_isDynamicResolution(false)
+    , m_averageGpuTime(0.0)
+    , m_gpuTimeSamples(0)
+    , m_resolutionFrame(0)
+#ifdef VK_EXT_extended_dynamic_state
+    , m_cmdSetDepthTestEnable(nullptr)
+    , m_cmdSetCullMode(nullptr)
+#endif
+    , m_destroyedPagesCount(0)
+{
+    if(m_pWindow)
+    {
+        m_pWindow->Destroyed.connect(this, &Renderer::OnWindowDestroyed);
+        m_pWindow->SizeChanged.connect(this, &Renderer::OnWindowSizeChanged);
+    }
+    else
+    {
+        LOG_VULKAN->Error("Window pointer in nullptr!");
+    }
+}
+
+Renderer::Renderer(system::Manager& manager, uint32_t width, uint32_t height, Camera const& camera)
+    : video::Renderer(manager, nullptr, camera)
+    , m_swapChainExtent(width, height)
+    , m_pDescriptorAllocator(nullptr)
+    , m_pPipelineCache(nullptr)
+    , m_pPipelineRegistry(nullptr)
     , m_pDepthImage(nullptr)
+    , m_upscaleFilter(vk::Filter::eLinear)
+    , m_timestampPeriod(0.0f)
+    , m_timestampMask(0)
+    , m_bindlessCapacity(0)
+    , m_bindlessTextureCount(0)
+    , m_currentFrame(0)
+    , m_pWorkerPool(nullptr)
+    , m_pMemoryAllocator(nullptr)
+    , m_pUploadService(nullptr)
+    , m_pGeometryArena(nullptr)
+    , m_pFrustumCuller(nullptr)
     , m_contextInstance(Context::Instance().GetVkInstance())
     , m_hasDirtyMeshes(false)
+    , m_isHeadless(true)
+    , m_frameCounter(0)
+    , m_hasMultiDrawIndirect(false)
+    , m_hasIndirectFirstInstance(false)
+    , m_isBindless(false)
+    , m_isShaderSpecialization(true)
+    , m_hasExtendedDynamicState(false)
+    , m_isDynamicResolution(false)
+    , m_averageGpuTime(0.0)
+    , m_gpuTimeSamples(0)
+    , m_resolutionFrame(0)
+#ifdef VK_EXT_extended_dynamic_state
+    , m_cmdSetDepthTestEnable(nullptr)
+    , m_cmdSetCullMode(nullptr)
+#endif
+    , m_destroyedPagesCount(0)
 {
-    m_pWindow->Destroyed.connect(this, &Renderer::OnWindowDestroyed);
-    m_pWindow->SizeChanged.connect(this, &Renderer::OnWindowSizeChanged);
 }
 
 Renderer::~Renderer()
@@ -78,27 +199,35 @@ bool Renderer::Init()
 
     LOG_VULKAN->Info("Renderer initialization started.");
 
-    if(!CreateSurface() ||
+    if((!m_isHeadless && !CreateSurface()) ||
         !PickPhysicalDevice() ||
         !CreateLogicalDevice() ||
-        !CreateSwapChain() ||
+        !CreateUploadService() ||
+        !CreatePipelineCache() ||
+        !CreateTimestampQueries() ||
+        !(m_isHeadless ? CreateOffscreenImages() : CreateSwapChain()) ||
         !CreateImageViews() ||
         !FindDepthFormat(m_depthImageFormat) ||
         !CreateDepthBuffer() ||
-        !CreateRenderPass() ||
         !PrepareUniformBuffers() ||
+        !CreateSceneImages() ||
+        !CreateRenderPass() ||
+        (m_isHeadless && !CreateReadbackBuffers()) ||
         !CreateDescriptionSetLayout() ||
         !CreateGraphicsPipeline() ||
+        !CreateFrustumCuller() ||
         !CreateFramebuffers() ||
         !CreateCommandPool() ||
-        !CreateSemaphores() ||
-        !CreateCommandBuffers() ||
+        !CreateSyncObjects() ||
         !LoadEngineHelpData())
     {
         return false;
     }
 
-    UpdateViewProjectionDescriptorSet();
+    for(auto& frame : m_frames)
+    {
+        UpdateFrameDescriptorSet(frame);
+    }
 
     m_isInitialized = true;
 
@@ -111,32 +240,59 @@ void Renderer::Deinit()
 {
     if(m_isInitialized)
     {
+        // GPU may still process frames in flight
+        m_vkLogicalDevice.waitIdle();
+
+        // Last frames are not followed by any frame which would emit them, oldest frame goes first
+        for(size_t i = 0; i < m_frames.size(); ++i)
+        {
+            EmitReadback(m_frames[(m_currentFrame + i) % m_frames.size()]);
+        }
+
+        for(auto& frame : m_frames)
+        {
+            ReleaseFrameResources(frame);
+        }
+
+        m_drawList.clear();
+
         {
-            if(!m_vkMeshes.empty())
+            if(!m_vkMeshes.IsEmpty())
             {
                 for(auto& pVkMesh : m_vkMeshes)
                 {
                     DeleteVkMesh(pVkMesh);
                 }
 
-                LOG_VULKAN->Debug("Deleted {} stray vk meshes", static_cast<uint32_t>(m_vkMeshes.size()));
+                LOG_VULKAN->Debug("Deleted {} stray vk meshes", static_cast<uint32_t>(m_vkMeshes.Size()));
 
-                m_vkMeshes.clear();
+                m_vkMeshes.Clear();
             }
+
+            m_meshHandles.clear();
+
+            m_instanceSlots.clear();
+            m_freeInstanceSlots.clear();
         }
 
         FreeEngineHelpData();
-        FreeSemaphores();
-        FreeCommandBuffers();
+        FreeSyncObjects();
+        FreeRecordingWorkers();
         FreeCommandPool();
+        FreeUploadService();
         FreeFrameBuffers();
+        FreeFrustumCuller();
         FreeGraphicsPipeline();
         FreeDescriptorPoolAndLayouts();
+        FreePipelineCache();
+        FreeTimestampQueries();
         FreeUniforms();
         FreeRenderPass();
+        FreeSceneImages();
         FreeDepthBuffer();
         FreeImageViews();
         FreeSwapChain();
+        FreeOffscreenImages();
         FreeSurface();
         FreeLogicalDevice();
 
@@ -156,22 +312,53 @@ QueueFamilyIndices Renderer::FindQueueFamilies(const vk::PhysicalDevice& device)
     vk::Result result;
     for(const auto& queueFamily : queueFamilies)
     {
-        if(queueFamily.queueCount > 0 && queueFamily.queueFlags & vk::QueueFlagBits::eGraphics)
+        // Frustum culling is dispatched on the graphics queue
+        if(queueFamily.queueCount > 0 && (queueFamily.queueFlags & vk::QueueFlagBits::eGraphics)
+            && (queueFamily.queueFlags & vk::QueueFlagBits::eCompute))
         {
             indices.graphicsFamily = index;
         }
 
-        std::tie(result, presentSupport) = device.getSurfaceSupportKHR(static_cast<uint32_t>(index), m_vkWindowSurface);
-
-        if(queueFamily.queueCount > 0 && presentSupport)
+        if(m_isHeadless)
         {
-            indices.presentFamily = index++;
+            // Nothing is presented, graphics queue does all the work
+            indices.presentFamily = indices.graphicsFamily;
+        }
+        else
+        {
+            std::tie(result, presentSupport) = device.getSurfaceSupportKHR(static_cast<uint32_t>(index), m_vkWindowSurface);
+
+            if(queueFamily.queueCount > 0 && presentSupport)
+            {
+                indices.presentFamily = index;
+            }
         }
 
         if(indices.IsComplete())
         {
             break;
         }
+
+        ++index;
+    }
+
+    // Queue family supporting only transfers is usually backed by DMA engines,
+    // compute capable one is the next best choice
+    indices.transferFamily = indices.graphicsFamily;
+    bool isComputeFamily = true;
+
+    for(size_t i = 0; i < queueFamilies.size(); ++i)
+    {
+        vk::QueueFlags const flags = queueFamilies[i].queueFlags;
+
+        if(queueFamilies[i].queueCount > 0
+            && (flags & vk::QueueFlagBits::eTransfer)
+            && !(flags & vk::QueueFlagBits::eGraphics)
+            && (isComputeFamily || !(flags & vk::QueueFlagBits::eCompute)))
+        {
+            indices.transferFamily = static_cast<int32_t>(i);
+            isComputeFamily = static_cast<bool>(flags & vk::QueueFlagBits::eCompute);
+        }
     }
 
     return indices;
@@ -279,23 +466,15 @@ vk::Extent2D Renderer::ChooseSwapExtent(const vk::SurfaceCapabilitiesKHR& capabi
 
 bool Renderer::Render()
 {
-    if(m_isInitialized && m_pWindow)
+    if(m_isInitialized && (m_pWindow || m_isHeadless))
     {
         if(m_hasDirtyMeshes)
         {
-            // Update all related data
-            ResizeUnifromModelBuffer(nullptr);
-            CreateCommandBuffers();
-
-            m_materials.remove_if([](const std::weak_ptr<VkMaterial>& pVkMaterial) { return pVkMaterial.expired(); });
+            RemoveExpiredMaterials();
             m_hasDirtyMeshes = false;
         }
 
-        Frame();
-
-        m_vkLogicalDevice.waitIdle();
-
-        return true;
+        return Frame();
     }
 
     return false;
@@ -327,66 +506,74 @@ bool Renderer::RecreateSwapChain()
 {
     m_vkLogicalDevice.waitIdle();
 
-    return CreateSwapChain() &&
+    return (m_isHeadless ? CreateOffscreenImages() : CreateSwapChain()) &&
            CreateImageViews() &&
            CreateDepthBuffer() &&
+           CreateSceneImages() &&
            CreateRenderPass() &&
            CreateGraphicsPipeline() &&
-           CreateFramebuffers() &&
-           CreateCommandBuffers();
+           CreateFramebuffers();
 }
 
-
-void Renderer::ResizeUnifromModelBuffer(VkMesh* /*vkmesh*/)
+void Renderer::OnMeshMaterialUpdated(Mesh* mesh, VkMesh* vkMesh)
 {
-    m_uniformModel.Destroy();
-    auto const nMeshes = m_vkMeshes.size();
-
-    size_t const bufferSize = (nMeshes == 0) ? m_dynamicAlignment : (nMeshes * m_dynamicAlignment);
-
-    m_uniformModel.Create(m_vkPhysicalDevice, m_vkLogicalDevice, vk::BufferUsageFlagBits::eUniformBuffer, vk::MemoryPropertyFlagBits::eHostVisible, bufferSize);
-
-    if(m_uniformModelsData.model)
+    // Previous material may still be used by frames in flight
+    if(vkMesh->pMaterial && !m_frames.empty())
     {
-        utility::AlignedFree(m_uniformModelsData.model);
+        GetLastSubmittedFrame().releasedMaterials.push_back(vkMesh->pMaterial);
     }
 
-    m_uniformModelsData.model = static_cast<glm::mat4*>(utility::AlignedAlloc(bufferSize, m_dynamicAlignment));
-
-    UpdateVkMeshMatrices();
-
-    m_uniformModel.Map();
-    m_uniformModel.Write(m_uniformModelsData.model);
+    AllocateMaterial(*mesh, *vkMesh);
 
-    UpdateModelDescriptorSet();
+    UpdateInstanceData(*vkMesh);
+}
 
-    CreateCommandBuffers();
+void Renderer::OnMeshTransformUpdated(VkMesh* vkMesh)
+{
+    UpdateInstanceData(*vkMesh);
 }
 
-void Renderer::OnMeshMaterialUpdated(Mesh* mesh, VkMesh* vkMesh)
+void Renderer::OnMeshGeometryRetired(GeometryArena::Allocation const& geometry)
 {
-    AllocateMaterial(*mesh, *vkMesh);
-    CreateCommandBuffers();
+    // Previous geometry may still be drawn by frames in flight
+    if(m_frames.empty())
+    {
+        GeometryArena::Allocation allocation = geometry;
+        m_pGeometryArena->Free(allocation);
+    }
+    else
+    {
+        GetLastSubmittedFrame().releasedGeometry.push_back(geometry);
+    }
 }
 
 bool Renderer::AddMesh(Mesh* mesh)
 {
     assert(nullptr != mesh);
 
-    auto vkmesh = new VkMesh(m_vkLogicalDevice, m_vkPhysicalDevice, m_commandPool, m_graphicsQueue, *mesh);
+    if(m_meshHandles.find(mesh) != m_meshHandles.end())
+    {
+        LOG_VULKAN->Warning("Mesh is already added to the renderer!");
+        return false;
+    }
+
+    auto vkmesh = new VkMesh(*m_pUploadService, *m_pGeometryArena, *mesh);
     if (!AllocateMaterial(*mesh, *vkmesh))
     {
         LOG_VULKAN->Error("Can't allocate material!");
+        delete vkmesh;
         return false;
     }
-    vkmesh->ReallocatedOnGpu.connect(this, &vulkan::Renderer::ResizeUnifromModelBuffer);
     vkmesh->MaterialUpdated.connect(this, &vulkan::Renderer::OnMeshMaterialUpdated);
+    vkmesh->TransformUpdated.connect(this, &vulkan::Renderer::OnMeshTransformUpdated);
+    vkmesh->GeometryRetired.connect(this, &vulkan::Renderer::OnMeshGeometryRetired);
 
     vkmesh->AllocateOnGPU();
 
-    m_vkMeshes.push_back(vkmesh);
+    AcquireInstanceSlot(*vkmesh);
 
-    ResizeUnifromModelBuffer(vkmesh);
+    // Mesh is recorded starting from the next frame
+    m_meshHandles[mesh] = m_vkMeshes.Insert(vkmesh);
 
     return true;
 }
@@ -395,13 +582,28 @@ bool Renderer::DeleteMesh(const Mesh* pMesh)
 {
     assert(nullptr != pMesh);
 
-    auto vkMeshIt = std::find_if(m_vkMeshes.begin(), m_vkMeshes.end(), [=](VkMesh* p) ->bool { return *p == *pMesh; });
+    auto meshHandleIt = m_meshHandles.find(pMesh);
 
-    if (vkMeshIt != m_vkMeshes.end())
+    if (meshHandleIt != m_meshHandles.end())
     {
-        DeleteVkMesh(*vkMeshIt);
+        VkMesh* pVkMesh = *m_vkMeshes.Get(meshHandleIt->second);
 
-        m_vkMeshes.erase(vkMeshIt);
+        m_vkMeshes.Erase(meshHandleIt->second);
+        m_meshHandles.erase(meshHandleIt);
+
+        ReleaseInstanceSlot(*pVkMesh);
+
+        if(m_frames.empty())
+        {
+            DeleteVkMesh(pVkMesh);
+        }
+        else
+        {
+            // Mesh buffers may still be used by frames in flight, so they are
+            // released when slot of the last submitted frame is reused
+            pVkMesh->Detach();
+            GetLastSubmittedFrame().deletedMeshes.push_back(pVkMesh);
+        }
 
         m_hasDirtyMeshes = true;
 
@@ -411,10 +613,58 @@ bool Renderer::DeleteMesh(const Mesh* pMesh)
     return false;
 }
 
+bool Renderer::AddMeshes(std::vector<Mesh*> const& meshes)
+{
+    // Containers grow once for the whole batch instead of reallocating while meshes are added
+    size_t const newSlotsCount = meshes.size() > m_freeInstanceSlots.size() ? meshes.size() - m_freeInstanceSlots.size() : 0;
+
+    m_vkMeshes.Reserve(m_vkMeshes.Size() + meshes.size());
+    m_meshHandles.reserve(m_meshHandles.size() + meshes.size());
+    m_instanceSlots.reserve(m_instanceSlots.size() + newSlotsCount);
+    m_instanceData.reserve(m_instanceData.size() + newSlotsCount);
+
+    for(auto& frame : m_frames)
+    {
+        frame.isInstanceSlotDirty.reserve(m_instanceSlots.size() + newSlotsCount);
+        frame.dirtyInstanceSlots.reserve(frame.dirtyInstanceSlots.size() + meshes.size());
+    }
+
+    // Geometry is staged into the current upload batch and instance buffers
+    // are resized when the next frame is prepared, so both happen once
+    bool areAdded = true;
+
+    for(Mesh* pMesh : meshes)
+    {
+        areAdded = AddMesh(pMesh) && areAdded;
+    }
+
+    return areAdded;
+}
+
+bool Renderer::DeleteMeshes(std::vector<Mesh*> const& meshes)
+{
+    if(!m_frames.empty())
+    {
+        std::vector<VkMesh*>& deletedMeshes = GetLastSubmittedFrame().deletedMeshes;
+        deletedMeshes.reserve(deletedMeshes.size() + meshes.size());
+    }
+
+    bool areDeleted = true;
+
+    for(Mesh const* pMesh : meshes)
+    {
+        areDeleted = DeleteMesh(pMesh) && areDeleted;
+    }
+
+    return areDeleted;
+}
+
 void Renderer::SetDepthTest(bool enabled)
 {
     m_depthTestEnabled = enabled;
-    CreateGraphicsPipeline();
+
+    // Draws either set depth test dynamically or bind pipeline variants of the new state
+    InvalidateRecordedDraws();
 }
 
 void Renderer::DeleteVkMesh(VkMesh* pVkMesh)
@@ -434,6 +684,27 @@ void Renderer::FreeSurface()
 
 void Renderer::FreeLogicalDevice()
 {
+    if(m_pMemoryAllocator)
+    {
+        MemoryAllocator::Stats const stats = m_pMemoryAllocator->GetStats();
+
+        LOG_VULKAN->Info("Device memory: {} blocks ({} dedicated), {} of {} bytes used by {} allocations, {} free ranges, fragmentation {}.",
+            stats.blocksCount, stats.dedicatedBlocksCount, stats.usedBytes, stats.allocatedBytes, stats.allocationsCount,
+            stats.freeRangesCount, stats.GetFragmentation());
+
+        std::vector<MemoryAllocator::HeapBudget> const heapBudgets = m_pMemoryAllocator->GetHeapBudgets();
+
+        for(size_t i = 0; i < heapBudgets.size(); ++i)
+        {
+            LOG_VULKAN->Info("Memory heap {} ({}): {} of {} bytes allocated, usage {}, budget {}.", i,
+                heapBudgets[i].isDeviceLocal ? "device local" : "host", heapBudgets[i].allocatedBytes,
+                heapBudgets[i].size, heapBudgets[i].usage, heapBudgets[i].budget);
+        }
+
+        delete m_pMemoryAllocator;
+        m_pMemoryAllocator = nullptr;
+    }
+
     if(m_vkLogicalDevice)
     {
         m_vkLogicalDevice.destroy();
@@ -441,6 +712,27 @@ void Renderer::FreeLogicalDevice()
     }
 }
 
+void Renderer::FreeUploadService()
+{
+    if(m_pGeometryArena)
+    {
+        GeometryArena::Stats const stats = m_pGeometryArena->GetStats();
+
+        LOG_VULKAN->Info("Geometry arena: {} pages, {} of {} vertices and {} of {} indices used, {} free vertex ranges, {} shared allocations.",
+            stats.pagesCount, stats.usedVertices, stats.vertexCapacity, stats.usedIndices, stats.indexCapacity,
+            stats.freeVertexRangesCount, stats.sharedAllocationsCount);
+
+        delete m_pGeometryArena;
+        m_pGeometryArena = nullptr;
+    }
+
+    if(m_pUploadService)
+    {
+        delete m_pUploadService;
+        m_pUploadService = nullptr;
+    }
+}
+
 void Renderer::FreeSwapChain()
 {
     if(m_vkLogicalDevice && m_vkSwapChain)
@@ -450,6 +742,30 @@ void Renderer::FreeSwapChain()
     }
 }
 
+void Renderer::FreeOffscreenImages()
+{
+    if(!m_offscreenImages.empty())
+    {
+        for(Image* pImage : m_offscreenImages)
+        {
+            delete pImage;
+        }
+
+        m_offscreenImages.clear();
+        m_swapChainImages.clear();
+    }
+}
+
+void Renderer::FreeSceneImages()
+{
+    for(Image* pImage : m_sceneImages)
+    {
+        delete pImage;
+    }
+
+    m_sceneImages.clear();
+}
+
 void Renderer::FreeImageViews()
 {
     if(m_vkLogicalDevice)
@@ -482,18 +798,16 @@ void Renderer::FreeRenderPass()
 
 void Renderer::FreeGraphicsPipeline()
 {
-    if(m_vkLogicalDevice)
+    delete m_pPipelineRegistry;
+    m_pPipelineRegistry = nullptr;
+}
+
+void Renderer::FreeFrustumCuller()
+{
+    if(m_pFrustumCuller)
     {
-        if(m_pipelines.solid)
-        {
-            m_vkLogicalDevice.destroyPipeline(m_pipelines.solid);
-            m_pipelines.solid = nullptr;
-        }
-        if(m_pipelines.wired)
-        {
-            m_vkLogicalDevice.destroyPipeline(m_pipelines.wired);
-            m_pipelines.wired = nullptr;
-        }
+        delete m_pFrustumCuller;
+        m_pFrustumCuller = nullptr;
     }
 }
 
@@ -511,47 +825,96 @@ void Renderer::FreeFrameBuffers()
 
 void Renderer::FreeCommandPool()
 {
-    if(m_commandPool && m_vkLogicalDevice)
+    if(m_vkLogicalDevice)
+    {
+        // Destroying the pool also frees command buffers allocated from it
+        for(auto& frame : m_frames)
+        {
+            FreeWorkerCommandPools(frame);
+
+            if(frame.commandPool)
+            {
+                m_vkLogicalDevice.destroyCommandPool(frame.commandPool);
+                frame.commandPool = nullptr;
+                frame.commandBuffer = nullptr;
+            }
+        }
+    }
+}
+
+void Renderer::FreeWorkerCommandPools(FrameData& frame)
+{
+    for(auto& pool : frame.workerCommandPools)
     {
-        m_vkLogicalDevice.destroyCommandPool(m_commandPool);
-        m_commandPool = nullptr;
+        m_vkLogicalDevice.destroyCommandPool(pool);
     }
+
+    frame.workerCommandPools.clear();
+    frame.secondaryCommandBuffers.clear();
+    frame.recordedChunksCount = 0;
+    frame.hasRecordedDraws = false;
 }
 
-void Renderer::FreeCommandBuffers()
+void Renderer::FreeRecordingWorkers()
 {
-    if(m_vkLogicalDevice && !m_commandBuffers.empty())
+    if(m_pWorkerPool)
     {
-        m_vkLogicalDevice.freeCommandBuffers(m_commandPool, static_cast<uint32_t>(m_commandBuffers.size()), m_commandBuffers.data());
+        delete m_pWorkerPool;
+        m_pWorkerPool = nullptr;
     }
 }
 
-void Renderer::FreeSemaphores()
+void Renderer::FreeSyncObjects()
 {
     if(m_vkLogicalDevice)
     {
-        if(m_imageAvailableSemaphore)
+        for(auto& frame : m_frames)
         {
-            m_vkLogicalDevice.destroySemaphore(m_imageAvailableSemaphore);
-            m_imageAvailableSemaphore = nullptr;
-        }
+            if(frame.imageAvailableSemaphore)
+            {
+                m_vkLogicalDevice.destroySemaphore(frame.imageAvailableSemaphore);
+                frame.imageAvailableSemaphore = nullptr;
+            }
 
-        if(m_renderFinishedSemaphore)
-        {
-            m_vkLogicalDevice.destroySemaphore(m_renderFinishedSemaphore);
-            m_renderFinishedSemaphore = nullptr;
+            if(frame.renderFinishedSemaphore)
+            {
+                m_vkLogicalDevice.destroySemaphore(frame.renderFinishedSemaphore);
+                frame.renderFinishedSemaphore = nullptr;
+            }
+
+            if(frame.inFlightFence)
+            {
+                m_vkLogicalDevice.destroyFence(frame.inFlightFence);
+                frame.inFlightFence = nullptr;
+            }
         }
     }
 }
 
 void Renderer::FreeUniforms()
 {
-    m_uniformViewProjection.Destroy();
-    m_uniformModel.Destroy();
+    // Frames are created in PrepareUniformBuffers() and are released together with their buffers
+    m_frames.clear();
+    m_currentFrame = 0;
+
+    m_instanceData.clear();
+    m_cullingData.clear();
+    m_cullingGroups.clear();
 }
 
-void Renderer::FreeDescriptorPoolAndLayouts() const
+void Renderer::FreeDescriptorPoolAndLayouts()
 {
+    if(m_pDescriptorAllocator)
+    {
+        DescriptorAllocator::Stats const stats = m_pDescriptorAllocator->GetStats();
+
+        LOG_VULKAN->Info("Descriptor sets: {} pools, {} of {} sets allocated, {} recycled.",
+            stats.poolsCount, stats.allocatedSetsCount, stats.setsCapacity, stats.recycledSetsCount);
+
+        delete m_pDescriptorAllocator;
+        m_pDescriptorAllocator = nullptr;
+    }
+
     if(m_vkLogicalDevice)
     {
         if(m_pipelineLayout)
@@ -567,18 +930,31 @@ void Renderer::FreeDescriptorPoolAndLayouts() const
             }
         }
 
-        if(m_descriptorPool)
+        if(m_bindlessDescriptorPool)
         {
-            m_vkLogicalDevice.destroyDescriptorPool(m_descriptorPool);
+            m_vkLogicalDevice.destroyDescriptorPool(m_bindlessDescriptorPool);
         }
     }
 }
 
 void Renderer::FreePipelineCache()
 {
-    if(m_vkLogicalDevice && pipelineCache)
+    // Cache is written back into its file when destroyed
+    delete m_pPipelineCache;
+    m_pPipelineCache = nullptr;
+}
+
+void Renderer::FreeTimestampQueries()
+{
+    if(m_vkLogicalDevice && m_timestampQueryPool)
+    {
+        m_vkLogicalDevice.destroyQueryPool(m_timestampQueryPool);
+        m_timestampQueryPool = nullptr;
+    }
+
+    for(auto& frame : m_frames)
     {
-        m_vkLogicalDevice.destroyPipelineCache(pipelineCache);
+        frame.isTimestampPending = false;
     }
 }
 
@@ -586,137 +962,860 @@ void Renderer::FreeEngineHelpData()
 {
     m_pReplaceMeMaterial.reset();
     m_materials.clear();
+    m_materialIndices.clear();
+    m_freeTextureIndices.clear();
+    m_bindlessTextureCount = 0;
 }
 
 bool Renderer::PrepareUniformBuffers()
 {
-    auto uboAlignment = static_cast<size_t>(m_physicalDeviceProperties.limits.minUniformBufferOffsetAlignment);
-    m_dynamicAlignment = (sizeof(glm::mat4) / uboAlignment) * uboAlignment + ((sizeof(glm::mat4) % uboAlignment) > 0 ? uboAlignment : 0);
-
     m_uniformCameraData.projection = camera->projection;
     m_uniformCameraData.view = camera->view;
 
-    m_uniformViewProjection.Create(m_vkPhysicalDevice, m_vkLogicalDevice, vk::BufferUsageFlagBits::eUniformBuffer, vk::MemoryPropertyFlagBits::eHostVisible
-        | vk::MemoryPropertyFlagBits::eHostCoherent, sizeof(UniformCameraData));
-    m_uniformViewProjection.Map();
-    m_uniformViewProjection.Write(&m_uniformCameraData);
+    uint32_t const framesInFlight = std::max(utility::Settings::Instance().GetFramesInFlight(), 1u);
+
+    m_frames.resize(framesInFlight);
+    m_currentFrame = 0;
+
+    for(auto& frame : m_frames)
+    {
+        if(!frame.uniformViewProjection.Create(m_vkPhysicalDevice, m_vkLogicalDevice, vk::BufferUsageFlagBits::eUniformBuffer,
+            MemoryUsage::Dynamic, sizeof(UniformCameraData)))
+        {
+            LOG_VULKAN->Error("Can't create view projection uniform buffer!");
+            return false;
+        }
+        frame.uniformViewProjection.Map();
+        frame.uniformViewProjection.Write(&m_uniformCameraData);
+        frame.uniformViewProjection.Flush();
+
+        if(!ReserveInstanceBuffer(frame, 1) || !ReserveIndirectBuffer(frame, 1))
+        {
+            return false;
+        }
+
+        if(!frame.cullingCountersBuffer.Create(m_vkPhysicalDevice, m_vkLogicalDevice, vk::BufferUsageFlagBits::eStorageBuffer,
+            MemoryUsage::Readback, sizeof(CullingCounters)))
+        {
+            LOG_VULKAN->Error("Can't create culling counters buffer!");
+            return false;
+        }
+        frame.cullingCountersBuffer.Map();
+    }
+
+    LOG_VULKAN->Info("Renderer uses {} frames in flight.", framesInFlight);
 
-    m_uniformModel.Create(m_vkPhysicalDevice, m_vkLogicalDevice, vk::BufferUsageFlagBits::eUniformBuffer, vk::MemoryPropertyFlagBits::eHostVisible, m_dynamicAlignment);
     return true;
 }
 
-void Renderer::UpdateViewProjectionDescriptorSet()
+void Renderer::UpdateFrameDescriptorSet(FrameData& frame) const
 {
-    vk::WriteDescriptorSet viewProjectionWriteSet;
-    viewProjectionWriteSet.dstSet = m_mvpDescriptorSet;
-    viewProjectionWriteSet.descriptorType = vk::DescriptorType::eUniformBuffer;
-    viewProjectionWriteSet.dstBinding = 0;
-    viewProjectionWriteSet.pBufferInfo = &m_uniformViewProjection.GetDescriptorInfo();
-    viewProjectionWriteSet.descriptorCount = 1;
+    std::array<vk::WriteDescriptorSet, 2> writeSets;
 
-    m_vkLogicalDevice.updateDescriptorSets(1, &viewProjectionWriteSet, 0, nullptr);
-}
+    writeSets[0].dstSet = frame.mvpDescriptorSet;
+    writeSets[0].descriptorType = vk::DescriptorType::eUniformBuffer;
+    writeSets[0].dstBinding = 0;
+    writeSets[0].pBufferInfo = &frame.uniformViewProjection.GetDescriptorInfo();
+    writeSets[0].descriptorCount = 1;
 
-void Renderer::UpdateModelDescriptorSet() const
-{
-    vk::WriteDescriptorSet modelWriteSet;
-    modelWriteSet.dstSet = m_mvpDescriptorSet;
-    modelWriteSet.descriptorType = vk::DescriptorType::eUniformBufferDynamic;
-    modelWriteSet.dstBinding = 1;
-    modelWriteSet.pBufferInfo = &m_uniformModel.GetDescriptorInfo();
-    modelWriteSet.descriptorCount = 1;
+    writeSets[1].dstSet = frame.mvpDescriptorSet;
+    writeSets[1].descriptorType = vk::DescriptorType::eStorageBuffer;
+    writeSets[1].dstBinding = 1;
+    writeSets[1].pBufferInfo = &frame.visibleInstanceBuffer.GetDescriptorInfo();
+    writeSets[1].descriptorCount = 1;
 
-    m_vkLogicalDevice.updateDescriptorSets(1, &modelWriteSet, 0, nullptr);
+    m_vkLogicalDevice.updateDescriptorSets(static_cast<uint32_t>(writeSets.size()), writeSets.data(), 0, nullptr);
 }
 
-void Renderer::UpdateUniformBuffer()
+void Renderer::UpdateUniformBuffer(FrameData& frame)
 {
     m_uniformCameraData.projection = camera->projection;
     m_uniformCameraData.view = camera->view;
-    m_uniformViewProjection.Write(&m_uniformCameraData);
+    frame.uniformViewProjection.Write(&m_uniformCameraData);
+    frame.uniformViewProjection.Flush();
 }
 
-void Renderer::UpdateDynamicUniformBuffer()
+bool Renderer::UpdateInstanceBuffer(FrameData& frame)
 {
-    UpdateVkMeshMatrices();
-
-    m_uniformModel.Write(m_uniformModelsData.model);
+    if(!ReserveInstanceBuffer(frame, m_instanceSlots.size()))
+    {
+        return false;
+    }
 
-    vk::MappedMemoryRange mappedMemoryRange;
-    mappedMemoryRange.memory = m_uniformModel.GetMemory();
-    mappedMemoryRange.size = m_uniformModel.GetSize();
-    m_vkLogicalDevice.flushMappedMemoryRanges(1, &mappedMemoryRange);
-}
+    // Culling shader counts from zero
+    CullingCounters const counters = {0, 0};
+    frame.cullingCountersBuffer.Write(&counters);
+    frame.cullingCountersBuffer.Flush();
 
-void Renderer::UpdateVkMeshMatrices()
-{
-    glm::mat4* pModelMat = nullptr;
-    uint32_t i = 0;
-    for(auto pVkMesh : m_vkMeshes)
-    {
-        // Get model matrix location
-        pModelMat = reinterpret_cast<glm::mat4*>(
-            (reinterpret_cast<uint64_t>(m_uniformModelsData.model) + (i * m_dynamicAlignment))
-        );
+    UploadDirtyInstances(frame);
 
-        // Fill model matrix
-        *pModelMat = pVkMesh->GetModelMatrix();
+    bool const isCpuCulling = utility::Settings::Instance().IsCpuCulling();
 
-        ++i;
-    }
-}
+    m_frameStats.culledInstanceCount = 0;
+    m_frameStats.cullingTime = std::chrono::nanoseconds::zero();
 
-bool Renderer::PickPhysicalDevice()
-{
-    vk::Result result;
-    std::vector<vk::PhysicalDevice> devices;
-    std::tie(result, devices) = m_contextInstance.enumeratePhysicalDevices();
-    if(result != vk::Result::eSuccess)
+    if(m_drawList.empty())
     {
-        LOG_VULKAN->Error("Failed to enumerate physical devices.");
-        return false;
+        return true;
     }
-    for(const auto& device : devices)
+
+    if(isCpuCulling)
     {
-        if(IsDeviceSuitable(device))
+        auto const cullingStart = std::chrono::steady_clock::now();
+
+        m_cullingSpheres.Clear();
+        m_cullingSpheres.Reserve(m_drawList.size());
+
+        for(VkMesh const* pVkMesh : m_drawList)
         {
-            m_vkPhysicalDevice = device;
-            break;
+            m_cullingSpheres.Push(pVkMesh->GetMesh().GetWorldBoundingSphere());
         }
+
+        Frustum const frustum(m_uniformCameraData.projection * m_uniformCameraData.view);
+        uint32_t const visibleCount = frustum.Cull(m_cullingSpheres, m_cullingVisibility);
+
+        m_frameStats.culledInstanceCount = static_cast<uint32_t>(m_drawList.size()) - visibleCount;
+        m_frameStats.cullingTime = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - cullingStart);
+
+        // Compute pass still compacts visible instances, so it gets frustum which passes everything
+        m_cullingFrustum = Frustum();
+    }
+    else
+    {
+        m_cullingFrustum = Frustum(m_uniformCameraData.projection * m_uniformCameraData.view);
     }
 
-    if(!m_vkPhysicalDevice)
+    // Culling data follows the draw list, so culling shader compacts instances in sorted order
+    m_cullingData.resize(m_drawList.size());
+
+    for(size_t i = 0; i < m_drawList.size(); ++i)
     {
-        LOG_VULKAN->Error("Failed to find a suitable GPU!");
-        return false;
+        auto const& material = m_drawList[i]->GetMesh().GetMaterial();
+
+        CullingData& culling = m_cullingData[i];
+        culling.boundingSphere = m_drawList[i]->GetBoundingSphere();
+        culling.instanceSlot = m_drawList[i]->GetInstanceSlot();
+        culling.isVisible = (material->IsVisible() && (!isCpuCulling || m_cullingVisibility[i])) ? 1 : 0;
+        culling.padding0 = 0;
+        culling.padding1 = 0;
     }
-    m_physicalDeviceProperties = m_vkPhysicalDevice.getProperties();
+
+    frame.cullingBuffer.Write(m_cullingData.data(), m_cullingData.size() * sizeof(CullingData), 0);
+    frame.cullingBuffer.Flush(0, m_cullingData.size() * sizeof(CullingData));
+
     return true;
 }
 
-bool Renderer::CreateLogicalDevice()
+void Renderer::UploadDirtyInstances(FrameData& frame)
 {
-    QueueFamilyIndices const indices = FindQueueFamilies(m_vkPhysicalDevice);
+    std::vector<uint32_t>& slots = frame.dirtyInstanceSlots;
 
-    std::vector<vk::DeviceQueueCreateInfo> queueCreateInfos;
-    std::set<int> uniqueQueueFamilies = {indices.graphicsFamily, indices.presentFamily};
-    float queuePriority = 1.0f;
+    m_frameStats.uploadedInstanceCount = static_cast<uint32_t>(slots.size());
+    m_frameStats.instanceUploadRangeCount = 0;
 
-    for(uint32_t queueFamily : uniqueQueueFamilies)
+    if(slots.empty())
     {
-        vk::DeviceQueueCreateInfo const queueCreateInfo({}, queueFamily, 1, &queuePriority);
-        queueCreateInfos.push_back(queueCreateInfo);
+        return;
     }
 
-    m_deviceFeatures.setSamplerAnisotropy(VK_TRUE);
+    std::sort(slots.begin(), slots.end());
+
+    // Slots separated by a small gap are uploaded with one range, since the
+    // gap holds up to date data as well and one flush is cheaper than two
+    uint32_t const maxGap = 4;
+
+    for(size_t i = 0; i < slots.size();)
+    {
+        uint32_t const first = slots[i];
+        uint32_t last = first;
+
+        for(; i < slots.size() && slots[i] <= last + maxGap; ++i)
+        {
+            last = slots[i];
+            frame.isInstanceSlotDirty[last] = 0;
+        }
+
+        size_t const offset = first * sizeof(InstanceData);
+        size_t const size = (last - first + 1) * sizeof(InstanceData);
+
+        frame.instanceBuffer.Write(&m_instanceData[first], size, offset);
+        frame.instanceBuffer.Flush(offset, size);
+
+        ++m_frameStats.instanceUploadRangeCount;
+    }
+
+    slots.clear();
+}
+
+void Renderer::UpdateInstanceData(VkMesh const& vkMesh)
+{
+    uint32_t const slot = vkMesh.GetInstanceSlot();
+    auto const& material = vkMesh.GetMesh().GetMaterial();
+
+    InstanceData& instance = m_instanceData[slot];
+    instance.model = vkMesh.GetModelMatrix();
+    instance.color = glm::vec4(material->GetColor(), material->IsColored()); // w - 1 if color is enabled
+    instance.spriteCoord = material->GetNormalizedSpriteArea();
+    instance.textureIndex = vkMesh.pMaterial->textureIndex;
+
+    // Every frame in flight has its own copy of instance data
+    for(auto& frame : m_frames)
+    {
+        MarkInstanceSlotDirty(frame, slot);
+    }
+}
+
+void Renderer::MarkInstanceSlotDirty(FrameData& frame, uint32_t slot)
+{
+    if(slot >= frame.isInstanceSlotDirty.size())
+    {
+        frame.isInstanceSlotDirty.resize(slot + 1, 0);
+    }
+
+    if(!frame.isInstanceSlotDirty[slot])
+    {
+        frame.isInstanceSlotDirty[slot] = 1;
+        frame.dirtyInstanceSlots.push_back(slot);
+    }
+}
+
+void Renderer::AcquireInstanceSlot(VkMesh& vkMesh)
+{
+    uint32_t slot = 0;
+
+    if(m_freeInstanceSlots.empty())
+    {
+        slot = static_cast<uint32_t>(m_instanceSlots.size());
+        m_instanceSlots.push_back(&vkMesh);
+        m_instanceData.emplace_back();
+    }
+    else
+    {
+        // Frames which still draw previous mesh of the slot use their own instance buffers
+        slot = m_freeInstanceSlots.back();
+        m_freeInstanceSlots.pop_back();
+        m_instanceSlots[slot] = &vkMesh;
+    }
+
+    vkMesh.SetInstanceSlot(slot);
+
+    UpdateInstanceData(vkMesh);
+}
+
+void Renderer::ReleaseInstanceSlot(VkMesh const& vkMesh)
+{
+    m_instanceSlots[vkMesh.GetInstanceSlot()] = nullptr;
+    m_freeInstanceSlots.push_back(vkMesh.GetInstanceSlot());
+}
+
+void Renderer::ReadCullingCounters(FrameData& frame)
+{
+    if(!frame.isCullingPending)
+    {
+        return;
+    }
+
+    frame.isCullingPending = false;
+
+    frame.cullingCountersBuffer.Invalidate();
+
+    CullingCounters const* pCounters = static_cast<CullingCounters const*>(frame.cullingCountersBuffer.GetMappedMemory());
+
+    m_frameStats.visibleDrawCount = pCounters->drawCount;
+    m_frameStats.visibleInstanceCount = pCounters->instanceCount;
+}
+
+void Renderer::ReadGpuTime(FrameData& frame)
+{
+    if(!frame.isTimestampPending)
+    {
+        return;
+    }
+
+    frame.isTimestampPending = false;
+
+    // Frame fence is signaled, so results are available
+    std::array<uint64_t, 2> timestamps;
+
+    vk::Result const result = m_vkLogicalDevice.getQueryPoolResults(m_timestampQueryPool, 2 * m_currentFrame, 2,
+        sizeof(timestamps), timestamps.data(), sizeof(uint64_t), vk::QueryResultFlagBits::e64);
+
+    if(result != vk::Result::eSuccess)
+    {
+        return;
+    }
+
+    uint64_t const ticks = (timestamps[1] - timestamps[0]) & m_timestampMask;
+    double const gpuTime = static_cast<double>(ticks) * m_timestampPeriod;
+
+    m_frameStats.gpuTime = std::chrono::nanoseconds(static_cast<int64_t>(gpuTime));
+
+    // Frames submitted before the scale changed don't describe current resolution
+    if(!m_isDynamicResolution || frame.frameIndex < m_resolutionFrame)
+    {
+        return;
+    }
+
+    m_averageGpuTime = m_gpuTimeSamples == 0 ? gpuTime : m_averageGpuTime + (gpuTime - m_averageGpuTime) * 0.25;
+    ++m_gpuTimeSamples;
+
+    UpdateResolutionScale();
+}
+
+void Renderer::UpdateResolutionScale()
+{
+    if(m_gpuTimeSamples < s_resolutionSamples || m_averageGpuTime <= 0.0)
+    {
+        return;
+    }
+
+    utility::Settings const& settings = utility::Settings::Instance();
+
+    double const targetTime = static_cast<double>(settings.GetTargetFrameTime().count());
+    float const minScale = std::min(std::max(settings.GetMinResolutionScale(), s_resolutionScaleStep), 1.0f);
+
+    float scale = m_resolutionScale * static_cast<float>(std::sqrt(targetTime / m_averageGpuTime));
+
+    // Scale goes up only when frames fit into target time with headroom
+    if(scale > m_resolutionScale && m_averageGpuTime > targetTime * s_upscaleHeadroom)
+    {
+        return;
+    }
+
+    scale = std::floor(scale / s_resolutionScaleStep) * s_resolutionScaleStep;
+    scale = std::min(std::max(scale, minScale), 1.0f);
+
+    if(std::abs(scale - m_resolutionScale) < s_resolutionScaleStep * 0.5f)
+    {
+        return;
+    }
+
+    LOG_VULKAN->Debug("Resolution scale changed from {} to {}, GPU frame time {} ns.", m_resolutionScale, scale,
+        static_cast<uint64_t>(m_averageGpuTime));
+
+    SetRenderExtent(scale);
+}
+
+void Renderer::SetRenderExtent(float scale)
+{
+    m_resolutionScale = scale;
+
+    vk::Extent2D const extent(
+        std::max(static_cast<uint32_t>(std::lround(m_swapChainExtent.width * scale)), 1u),
+        std::max(static_cast<uint32_t>(std::lround(m_swapChainExtent.height * scale)), 1u));
+
+    // Measurements start anew at the new scale
+    m_averageGpuTime = 0.0;
+    m_gpuTimeSamples = 0;
+    m_resolutionFrame = m_frameCounter;
+
+    if(extent != m_renderExtent)
+    {
+        m_renderExtent = extent;
+
+        // Recorded draws set viewport and scissor of the render area
+        InvalidateRecordedDraws();
+    }
+}
+
+bool Renderer::ReserveInstanceBuffer(FrameData& frame, size_t count)
+{
+    // Capacity grows geometrically, so adding meshes one by one doesn't
+    // reallocate buffers on every frame
+    if(count > frame.instanceCapacity)
+    {
+        size_t capacity = std::max<size_t>(frame.instanceCapacity, 1);
+        while(capacity < count)
+        {
+            capacity *= 2;
+        }
+
+        // Frame fence is already signaled, so GPU doesn't use the buffers anymore
+        frame.instanceBuffer.Destroy();
+        frame.cullingBuffer.Destroy();
+        frame.visibleInstanceBuffer.Destroy();
+        frame.instanceCapacity = 0;
+
+        // Recorded draws bind the destroyed buffer
+        frame.hasRecordedDraws = false;
+
+        if(!frame.instanceBuffer.Create(m_vkPhysicalDevice, m_vkLogicalDevice, vk::BufferUsageFlagBits::eStorageBuffer, MemoryUsage::Dynamic, capacity * sizeof(InstanceData)) ||
+           !frame.cullingBuffer.Create(m_vkPhysicalDevice, m_vkLogicalDevice, vk::BufferUsageFlagBits::eStorageBuffer, MemoryUsage::Dynamic, capacity * sizeof(CullingData)) ||
+           !frame.visibleInstanceBuffer.Create(m_vkPhysicalDevice, m_vkLogicalDevice, vk::BufferUsageFlagBits::eStorageBuffer, MemoryUsage::GpuOnly, capacity * sizeof(InstanceData)))
+        {
+            LOG_VULKAN->Error("Can't create instance buffers for {} meshes!", static_cast<uint32_t>(capacity));
+            return false;
+        }
+        frame.instanceBuffer.Map();
+        frame.cullingBuffer.Map();
+        frame.instanceCapacity = capacity;
+
+        // Descriptor set is allocated after the first buffers are created, Init() points it to them
+        if(frame.mvpDescriptorSet)
+        {
+            UpdateFrameDescriptorSet(frame);
+        }
+
+        // New buffer holds no data, so all meshes are uploaded anew
+        for(uint32_t slot = 0; slot < m_instanceSlots.size(); ++slot)
+        {
+            if(m_instanceSlots[slot])
+            {
+                MarkInstanceSlotDirty(frame, slot);
+            }
+        }
+    }
+
+    return true;
+}
+
+bool Renderer::UpdateIndirectBuffer(FrameData& frame)
+{
+    if(!ReserveIndirectBuffer(frame, m_indirectCommands.size()))
+    {
+        return false;
+    }
+
+    if(m_indirectCommands.empty())
+    {
+        return true;
+    }
+
+    frame.indirectBuffer.Write(m_indirectCommands.data(), m_indirectCommands.size() * sizeof(vk::DrawIndexedIndirectCommand), 0);
+
+    frame.indirectBuffer.Flush();
+
+    frame.cullingGroupBuffer.Write(m_cullingGroups.data(), m_cullingGroups.size() * sizeof(CullingGroup), 0);
+    frame.cullingGroupBuffer.Flush(0, m_cullingGroups.size() * sizeof(CullingGroup));
+
+    return true;
+}
+
+bool Renderer::ReserveIndirectBuffer(FrameData& frame, size_t count)
+{
+    if(count > frame.indirectCapacity)
+    {
+        size_t capacity = std::max<size_t>(frame.indirectCapacity, 1);
+        while(capacity < count)
+        {
+            capacity *= 2;
+        }
+
+        // Frame fence is already signaled, so GPU doesn't use the buffer anymore
+        frame.indirectBuffer.Destroy();
+        frame.cullingGroupBuffer.Destroy();
+        frame.indirectCapacity = 0;
+
+        if(!frame.indirectBuffer.Create(m_vkPhysicalDevice, m_vkLogicalDevice, vk::BufferUsageFlagBits::eIndirectBuffer | vk::BufferUsageFlagBits::eStorageBuffer, MemoryUsage::Dynamic, capacity * sizeof(vk::DrawIndexedIndirectCommand)) ||
+           !frame.cullingGroupBuffer.Create(m_vkPhysicalDevice, m_vkLogicalDevice, vk::BufferUsageFlagBits::eStorageBuffer, MemoryUsage::Dynamic, capacity * sizeof(CullingGroup)))
+        {
+            LOG_VULKAN->Error("Can't create indirect buffer for {} draws!", static_cast<uint32_t>(capacity));
+            return false;
+        }
+        frame.indirectBuffer.Map();
+        frame.cullingGroupBuffer.Map();
+        frame.indirectCapacity = capacity;
+
+        frame.hasRecordedDraws = false;
+    }
+
+    return true;
+}
+
+void Renderer::InvalidateRecordedDraws()
+{
+    for(auto& frame : m_frames)
+    {
+        frame.hasRecordedDraws = false;
+    }
+}
+
+bool Renderer::AreRecordedDrawsValid(FrameData const& frame) const
+{
+    if(!frame.hasRecordedDraws || frame.recordedBatches != m_drawBatches ||
+        !utility::Settings::Instance().IsRecordedDrawsReuse())
+    {
+        return false;
+    }
+
+    if(m_hasIndirectFirstInstance)
+    {
+        return true;
+    }
+
+    // Instance offsets are pushed as constants into command buffers
+    if(frame.recordedFirstInstances.size() != m_drawGroups.size())
+    {
+        return false;
+    }
+
+    for(size_t i = 0; i < m_drawGroups.size(); ++i)
+    {
+        if(frame.recordedFirstInstances[i] != m_drawGroups[i].firstInstance)
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void Renderer::BuildDrawList()
+{
+    m_drawList.clear();
+    m_unsortedDrawList.clear();
+    m_drawSortItems.clear();
+    m_drawGroups.clear();
+    m_drawBatches.clear();
+    m_indirectCommands.clear();
+
+    m_isShaderSpecialization = utility::Settings::Instance().IsShaderSpecialization();
+
+    // Hidden meshes stay in the draw list, so hiding a mesh doesn't change recorded draws
+    for(auto pVkMesh : m_vkMeshes)
+    {
+        if(pVkMesh->IsValid() && m_pUploadService->IsReadyForFrame(pVkMesh->GetUploadToken())
+            && m_pUploadService->IsReadyForFrame(pVkMesh->pMaterial->texture->GetUploadToken()))
+        {
+            utility::SortItem item;
+            item.key = MakeDrawSortKey(*pVkMesh);
+            item.index = static_cast<uint32_t>(m_unsortedDrawList.size());
+
+            m_drawSortItems.push_back(item);
+            m_unsortedDrawList.push_back(pVkMesh);
+        }
+    }
+
+    utility::RadixSort(m_drawSortItems, m_drawSortBuffer);
+
+    m_drawList.reserve(m_drawSortItems.size());
+
+    for(auto const& item : m_drawSortItems)
+    {
+        m_drawList.push_back(m_unsortedDrawList[item.index]);
+    }
+
+    // Meshes sharing pipeline, arena page and material are drawn from one batch,
+    // meshes which also share geometry become instances of one draw. Sort keys hold
+    // truncated identifiers, so group boundaries are found by comparing full ones.
+    // Bindless materials are read per instance and don't split draws
+    auto const drawKey = [this](VkMesh const* pVkMesh)
+    {
+        return std::make_tuple(MakePipelineState(*pVkMesh->GetMesh().GetMaterial()),
+                               m_isBindless ? nullptr : pVkMesh->pMaterial.get(),
+                               pVkMesh->GetGeometry().pageIndex,
+                               pVkMesh->GetGeometry().geometryId);
+    };
+
+    for(size_t i = 0; i < m_drawList.size(); ++i)
+    {
+        VkMesh const* pVkMesh = m_drawList[i];
+
+        if(m_drawGroups.empty() || drawKey(m_drawList[i - 1]) != drawKey(pVkMesh))
+        {
+            DrawGroup group;
+            group.firstInstance = static_cast<uint32_t>(i);
+            m_drawGroups.push_back(group);
+
+            DrawBatch batch;
+            batch.pipeline = m_pPipelineRegistry->Get(MakePipelineState(*pVkMesh->GetMesh().GetMaterial()));
+            batch.vertexBuffer = pVkMesh->GetVertexBuffer();
+            batch.indexBuffer = pVkMesh->GetIndexBuffer();
+            batch.materialDescriptorSet = pVkMesh->pMaterial->descriptorSet;
+
+            if(m_drawBatches.empty() || m_drawBatches.back().pipeline != batch.pipeline
+                || m_drawBatches.back().vertexBuffer != batch.vertexBuffer
+                || m_drawBatches.back().materialDescriptorSet != batch.materialDescriptorSet)
+            {
+                batch.firstCommand = static_cast<uint32_t>(m_drawGroups.size() - 1);
+                m_drawBatches.push_back(batch);
+            }
+
+            ++m_drawBatches.back().commandCount;
+        }
+
+        if(pVkMesh->GetMesh().GetMaterial()->IsVisible())
+        {
+            ++m_drawGroups.back().instanceCount;
+        }
+    }
+
+    m_indirectCommands.resize(m_drawGroups.size());
+    m_cullingGroups.resize(m_drawGroups.size());
+
+    for(size_t i = 0; i < m_drawGroups.size(); ++i)
+    {
+        DrawGroup const& group = m_drawGroups[i];
+        GeometryArena::Allocation const& geometry = m_drawList[group.firstInstance]->GetGeometry();
+
+        size_t const lastInstance = (i + 1 < m_drawGroups.size()) ? m_drawGroups[i + 1].firstInstance : m_drawList.size();
+
+        m_cullingGroups[i].firstInstance = group.firstInstance;
+        m_cullingGroups[i].instanceCount = static_cast<uint32_t>(lastInstance - group.firstInstance);
+
+        vk::DrawIndexedIndirectCommand& command = m_indirectCommands[i];
+        command.indexCount = geometry.indexCount;
+        // Frustum culling writes amount of instances which pass
+        command.instanceCount = 0;
+        command.firstIndex = geometry.firstIndex;
+        command.vertexOffset = static_cast<int32_t>(geometry.vertexOffset);
+        // Without drawIndirectFirstInstance offset of the group is pushed as constant instead
+        command.firstInstance = m_hasIndirectFirstInstance ? group.firstInstance : 0;
+    }
+
+    // Recorded draws can't be reused once buffers they bind are destroyed
+    if(m_pGeometryArena->GetDestroyedPagesCount() != m_destroyedPagesCount)
+    {
+        m_destroyedPagesCount = m_pGeometryArena->GetDestroyedPagesCount();
+        InvalidateRecordedDraws();
+    }
+}
+
+uint64_t Renderer::MakeDrawSortKey(VkMesh const& vkMesh) const
+{
+    // Key layout from the most significant bit, opaque pass is grouped by bound state:
+    // pass (1) | pipeline (3) | material (16) | arena page (8) | geometry (18) | depth (18)
+    // blended pass is drawn back to front across all bound states:
+    // pass (1) | depth (18) | pipeline (3) | material (16) | arena page (8) | geometry (18)
+    Material const& material = *vkMesh.GetMesh().GetMaterial();
+    GeometryArena::Allocation const& geometry = vkMesh.GetGeometry();
+
+    // Only transparent materials are blended, the rest is drawn first as opaque pass
+    PipelineState const pipelineState = MakePipelineState(material);
+    bool const isBlended = pipelineState.isBlend;
+    uint64_t const pipeline = (material.IsWired() ? 4 : 0) | static_cast<uint64_t>(pipelineState.shading);
+
+    // View space depth, camera looks along negative Z axis
+    glm::vec4 const viewPosition = camera->view * glm::vec4(vkMesh.GetMesh().GetWorldBoundingSphere().center, 1.0f);
+    float const viewDepth = std::max(-viewPosition.z, 0.0f);
+
+    // Bits of non negative floats are ordered the same way as floats
+    uint32_t depthBits = 0;
+    std::memcpy(&depthBits, &viewDepth, sizeof(depthBits));
+
+    uint64_t depth = depthBits >> 13;
+
+    // Bindless materials don't change bound state, so geometry is the next key
+    uint64_t const materialHandle = m_isBindless ? 0 : vkMesh.pMaterial->handle & 0xFFFF;
+
+    uint64_t const state = (pipeline << 42) |
+                           (materialHandle << 26) |
+                           (static_cast<uint64_t>(geometry.pageIndex & 0xFF) << 18) |
+                           static_cast<uint64_t>(geometry.geometryId & 0x3FFFF);
+
+    if(isBlended)
+    {
+        // Far meshes go first, culling keeps draw list order of instances
+        depth = 0x3FFFF - depth;
+
+        return (1ull << 63) | (depth << 45) | state;
+    }
+
+    return (state << 18) | depth;
+}
+
+PipelineState Renderer::MakePipelineState(Material const& material) const
+{
+    PipelineState state;
+    state.shaderVariant = static_cast<uint32_t>(m_isBindless ? ShaderVariant::UberBindless : ShaderVariant::Uber);
+    state.shading = m_isShaderSpecialization ? ShaderProgram::SelectShading(material) : MaterialShading::Dynamic;
+
+    // Wired pipeline doesn't blend, it's drawn as opaque pass
+    bool const isWired = material.IsWired() && m_deviceFeatures.fillModeNonSolid;
+    state.polygonMode = isWired ? vk::PolygonMode::eLine : vk::PolygonMode::eFill;
+    state.isBlend = material.IsTransparent() && !isWired;
+
+    // Dynamic depth test is set by command buffers, so all values share one pipeline
+    state.isDepthTest = m_hasExtendedDynamicState || m_depthTestEnabled;
+
+    return state;
+}
+
+void Renderer::CompactGeometry()
+{
+    if(!m_pGeometryArena->MarkPagesForEvacuation())
+    {
+        return;
+    }
+
+    // Moved meshes retire their ranges, evacuated pages are destroyed once frames in flight are finished
+    uint32_t movedMeshesCount = 0;
+
+    for(auto pVkMesh : m_vkMeshes)
+    {
+        if(m_pGeometryArena->IsEvacuated(pVkMesh->GetGeometry().pageIndex))
+        {
+            pVkMesh->AllocateOnGPU();
+            ++movedMeshesCount;
+        }
+    }
+
+    LOG_VULKAN->Debug("Compacted geometry arena, moved {} meshes.", movedMeshesCount);
+}
+
+FrameData& Renderer::GetLastSubmittedFrame()
+{
+    uint32_t const framesCount = static_cast<uint32_t>(m_frames.size());
+
+    return m_frames[(m_currentFrame + framesCount - 1) % framesCount];
+}
+
+void Renderer::ReleaseFrameResources(FrameData& frame)
+{
+    if(frame.uploadToken != UploadService::s_completeToken)
+    {
+        m_pUploadService->Release(frame.uploadToken);
+        frame.uploadToken = UploadService::s_completeToken;
+    }
+
+    bool const hasReleasedResources = !frame.deletedMeshes.empty() || !frame.releasedMaterials.empty();
+
+    for(auto pVkMesh : frame.deletedMeshes)
+    {
+        DeleteVkMesh(pVkMesh);
+    }
+    frame.deletedMeshes.clear();
+
+    for(auto& geometry : frame.releasedGeometry)
+    {
+        m_pGeometryArena->Free(geometry);
+    }
+    frame.releasedGeometry.clear();
+
+    if(!frame.releasedMaterials.empty())
+    {
+        frame.releasedMaterials.clear();
+
+        // Some of materials might be expired
+        m_hasDirtyMeshes = true;
+    }
+
+    // Recorded draws can't be reused once descriptor sets they bind are freed
+    if(hasReleasedResources && std::any_of(m_materials.begin(), m_materials.end(),
+        [](MaterialEntry const& entry) { return entry.pMaterial.expired(); }))
+    {
+        InvalidateRecordedDraws();
+        m_hasDirtyMeshes = true;
+    }
+}
+
+bool Renderer::PickPhysicalDevice()
+{
+    vk::Result result;
+    std::vector<vk::PhysicalDevice> devices;
+    std::tie(result, devices) = m_contextInstance.enumeratePhysicalDevices();
+    if(result != vk::Result::eSuccess)
+    {
+        LOG_VULKAN->Error("Failed to enumerate physical devices.");
+        return false;
+    }
+    for(const auto& device : devices)
+    {
+        if(IsDeviceSuitable(device))
+        {
+            m_vkPhysicalDevice = device;
+            break;
+        }
+    }
+
+    if(!m_vkPhysicalDevice)
+    {
+        LOG_VULKAN->Error("Failed to find a suitable GPU!");
+        return false;
+    }
+    m_physicalDeviceProperties = m_vkPhysicalDevice.getProperties();
+    return true;
+}
+
+bool Renderer::CreateLogicalDevice()
+{
+    QueueFamilyIndices const indices = FindQueueFamilies(m_vkPhysicalDevice);
+
+    std::vector<vk::DeviceQueueCreateInfo> queueCreateInfos;
+    std::set<int> uniqueQueueFamilies = {indices.graphicsFamily, indices.presentFamily, indices.transferFamily};
+    float queuePriority = 1.0f;
+
+    for(uint32_t queueFamily : uniqueQueueFamilies)
+    {
+        vk::DeviceQueueCreateInfo const queueCreateInfo({}, queueFamily, 1, &queuePriority);
+        queueCreateInfos.push_back(queueCreateInfo);
+    }
+
+    vk::PhysicalDeviceFeatures supportedFeatures;
+    m_vkPhysicalDevice.getFeatures(&supportedFeatures);
+
+    // Without these features indirect commands are issued one by one
+    // and instance offset is pushed for every command
+    m_hasMultiDrawIndirect = supportedFeatures.multiDrawIndirect == VK_TRUE;
+    m_hasIndirectFirstInstance = supportedFeatures.drawIndirectFirstInstance == VK_TRUE;
+
+    m_deviceFeatures.setSamplerAnisotropy(VK_TRUE);
     m_deviceFeatures.setFillModeNonSolid(VK_TRUE);
+    m_deviceFeatures.setMultiDrawIndirect(supportedFeatures.multiDrawIndirect);
+    m_deviceFeatures.setDrawIndirectFirstInstance(supportedFeatures.drawIndirectFirstInstance);
 
     vk::DeviceCreateInfo createInfo;
     createInfo.setPQueueCreateInfos(queueCreateInfos.data());
     createInfo.setQueueCreateInfoCount(static_cast<uint32_t>(queueCreateInfos.size()));
     createInfo.setPEnabledFeatures(&m_deviceFeatures);
-    createInfo.setEnabledExtensionCount(static_cast<uint32_t>(Context::Instance().GetDeviceExtensions().size()));
-    createInfo.setPpEnabledExtensionNames(Context::Instance().GetDeviceExtensions().data());
+    std::vector<char const*> deviceExtensions = Context::Instance().GetDeviceExtensions();
+
+    bool const hasMemoryBudget = IsMemoryBudgetSupported();
+    if(hasMemoryBudget)
+    {
+        deviceExtensions.push_back(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+    }
+
+    m_isBindless = false;
+
+    if(utility::Settings::Instance().IsBindlessTextures())
+    {
+        m_isBindless = IsDescriptorIndexingSupported(m_bindlessCapacity);
+
+        LOG_VULKAN->Info("Bindless textures are {}.", m_isBindless ? "enabled" : "not supported, materials use own descriptor sets");
+    }
+
+    // Feature structures of enabled extensions are chained into device create info
+    void* pFeatures = nullptr;
+
+#ifdef VK_EXT_descriptor_indexing
+    vk::PhysicalDeviceDescriptorIndexingFeaturesEXT descriptorIndexingFeatures;
+
+    if(m_isBindless)
+    {
+        descriptorIndexingFeatures.setShaderSampledImageArrayNonUniformIndexing(VK_TRUE);
+        descriptorIndexingFeatures.setRuntimeDescriptorArray(VK_TRUE);
+        descriptorIndexingFeatures.setDescriptorBindingPartiallyBound(VK_TRUE);
+        descriptorIndexingFeatures.setDescriptorBindingSampledImageUpdateAfterBind(VK_TRUE);
+
+        descriptorIndexingFeatures.setPNext(pFeatures);
+        pFeatures = &descriptorIndexingFeatures;
+
+        deviceExtensions.push_back(VK_KHR_MAINTENANCE3_EXTENSION_NAME);
+        deviceExtensions.push_back(VK_EXT_DESCRIPTOR_INDEXING_EXTENSION_NAME);
+    }
+#endif
+
+    m_hasExtendedDynamicState = IsExtendedDynamicStateSupported();
+
+#ifdef VK_EXT_extended_dynamic_state
+    vk::PhysicalDeviceExtendedDynamicStateFeaturesEXT extendedDynamicStateFeatures;
+
+    if(m_hasExtendedDynamicState)
+    {
+        extendedDynamicStateFeatures.setExtendedDynamicState(VK_TRUE);
+
+        extendedDynamicStateFeatures.setPNext(pFeatures);
+        pFeatures = &extendedDynamicStateFeatures;
+
+        deviceExtensions.push_back(VK_EXT_EXTENDED_DYNAMIC_STATE_EXTENSION_NAME);
+    }
+#endif
+
+    createInfo.setPNext(pFeatures);
+
+    createInfo.setEnabledExtensionCount(static_cast<uint32_t>(deviceExtensions.size()));
+    createInfo.setPpEnabledExtensionNames(deviceExtensions.data());
 
     if(s_enableValidationLayers)
     {
@@ -737,6 +1836,173 @@ bool Renderer::CreateLogicalDevice()
     }
     m_graphicsQueue = m_vkLogicalDevice.getQueue(static_cast<uint32_t>(indices.graphicsFamily), 0);
     m_presentQueue = m_vkLogicalDevice.getQueue(static_cast<uint32_t>(indices.presentFamily), 0);
+    m_transferQueue = m_vkLogicalDevice.getQueue(static_cast<uint32_t>(indices.transferFamily), 0);
+
+#ifdef VK_EXT_extended_dynamic_state
+    if(m_hasExtendedDynamicState)
+    {
+        m_cmdSetDepthTestEnable = reinterpret_cast<PFN_vkCmdSetDepthTestEnableEXT>(
+            m_vkLogicalDevice.getProcAddr("vkCmdSetDepthTestEnableEXT"));
+        m_cmdSetCullMode = reinterpret_cast<PFN_vkCmdSetCullModeEXT>(
+            m_vkLogicalDevice.getProcAddr("vkCmdSetCullModeEXT"));
+
+        m_hasExtendedDynamicState = m_cmdSetDepthTestEnable && m_cmdSetCullMode;
+    }
+#endif
+
+    LOG_VULKAN->Info("Depth test and cull mode are {}.", m_hasExtendedDynamicState ? "dynamic" : "baked into pipeline variants");
+
+    m_pMemoryAllocator = new MemoryAllocator(m_contextInstance, m_vkPhysicalDevice, m_vkLogicalDevice, hasMemoryBudget);
+
+    return true;
+}
+
+bool Renderer::HasProperties2() const
+{
+    std::vector<char const*> const& instanceExtensions = Context::Instance().GetInstanceExtensions();
+
+    return std::any_of(instanceExtensions.begin(), instanceExtensions.end(), [](char const* name)
+    {
+        return strcmp(name, VK_KHR_GET_PHYSICAL_DEVICE_PROPERTIES_2_EXTENSION_NAME) == 0;
+    });
+}
+
+bool Renderer::HasDeviceExtension(char const* name) const
+{
+    vk::Result result;
+    std::vector<vk::ExtensionProperties> availableExtensions;
+    std::tie(result, availableExtensions) = m_vkPhysicalDevice.enumerateDeviceExtensionProperties();
+
+    if(result != vk::Result::eSuccess)
+    {
+        return false;
+    }
+
+    return std::any_of(availableExtensions.begin(), availableExtensions.end(), [=](vk::ExtensionProperties const& extension)
+    {
+        return strcmp(extension.extensionName, name) == 0;
+    });
+}
+
+bool Renderer::IsMemoryBudgetSupported() const
+{
+#ifdef VK_EXT_memory_budget
+    return HasProperties2() && HasDeviceExtension(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+#else
+    return false;
+#endif
+}
+
+bool Renderer::IsDescriptorIndexingSupported(uint32_t& capacity) const
+{
+#ifdef VK_EXT_descriptor_indexing
+    if(!HasProperties2() ||
+       !HasDeviceExtension(VK_KHR_MAINTENANCE3_EXTENSION_NAME) ||
+       !HasDeviceExtension(VK_EXT_DESCRIPTOR_INDEXING_EXTENSION_NAME))
+    {
+        return false;
+    }
+
+    auto const getFeatures2 = reinterpret_cast<PFN_vkGetPhysicalDeviceFeatures2KHR>(
+        m_contextInstance.getProcAddr("vkGetPhysicalDeviceFeatures2KHR"));
+    auto const getProperties2 = reinterpret_cast<PFN_vkGetPhysicalDeviceProperties2KHR>(
+        m_contextInstance.getProcAddr("vkGetPhysicalDeviceProperties2KHR"));
+
+    if(!getFeatures2 || !getProperties2)
+    {
+        return false;
+    }
+
+    VkPhysicalDeviceDescriptorIndexingFeaturesEXT indexingFeatures = {};
+    indexingFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES_EXT;
+
+    VkPhysicalDeviceFeatures2KHR features = {};
+    features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2_KHR;
+    features.pNext = &indexingFeatures;
+
+    getFeatures2(static_cast<VkPhysicalDevice>(m_vkPhysicalDevice), &features);
+
+    // Texture index varies between instances of one draw and textures are added while frames are in flight
+    if(indexingFeatures.shaderSampledImageArrayNonUniformIndexing != VK_TRUE ||
+       indexingFeatures.runtimeDescriptorArray != VK_TRUE ||
+       indexingFeatures.descriptorBindingPartiallyBound != VK_TRUE ||
+       indexingFeatures.descriptorBindingSampledImageUpdateAfterBind != VK_TRUE)
+    {
+        return false;
+    }
+
+    VkPhysicalDeviceDescriptorIndexingPropertiesEXT indexingProperties = {};
+    indexingProperties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_PROPERTIES_EXT;
+
+    VkPhysicalDeviceProperties2KHR properties = {};
+    properties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2_KHR;
+    properties.pNext = &indexingProperties;
+
+    getProperties2(static_cast<VkPhysicalDevice>(m_vkPhysicalDevice), &properties);
+
+    // Combined image samplers count against both sampler and sampled image limits
+    capacity = std::min({indexingProperties.maxPerStageDescriptorUpdateAfterBindSamplers,
+                         indexingProperties.maxPerStageDescriptorUpdateAfterBindSampledImages,
+                         indexingProperties.maxDescriptorSetUpdateAfterBindSamplers,
+                         indexingProperties.maxDescriptorSetUpdateAfterBindSampledImages,
+                         s_maxBindlessTextures});
+
+    return capacity > 0;
+#else
+    capacity = 0;
+    return false;
+#endif
+}
+
+bool Renderer::IsExtendedDynamicStateSupported() const
+{
+#ifdef VK_EXT_extended_dynamic_state
+    if(!HasProperties2() || !HasDeviceExtension(VK_EXT_EXTENDED_DYNAMIC_STATE_EXTENSION_NAME))
+    {
+        return false;
+    }
+
+    auto const getFeatures2 = reinterpret_cast<PFN_vkGetPhysicalDeviceFeatures2KHR>(
+        m_contextInstance.getProcAddr("vkGetPhysicalDeviceFeatures2KHR"));
+
+    if(!getFeatures2)
+    {
+        return false;
+    }
+
+    VkPhysicalDeviceExtendedDynamicStateFeaturesEXT extendedDynamicStateFeatures = {};
+    extendedDynamicStateFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_EXTENDED_DYNAMIC_STATE_FEATURES_EXT;
+
+    VkPhysicalDeviceFeatures2KHR features = {};
+    features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2_KHR;
+    features.pNext = &extendedDynamicStateFeatures;
+
+    getFeatures2(static_cast<VkPhysicalDevice>(m_vkPhysicalDevice), &features);
+
+    return extendedDynamicStateFeatures.extendedDynamicState == VK_TRUE;
+#else
+    return false;
+#endif
+}
+
+bool Renderer::CreateUploadService()
+{
+    QueueFamilyIndices indices = FindQueueFamilies(m_vkPhysicalDevice);
+
+    m_pUploadService = new UploadService(m_vkPhysicalDevice,
+                                         m_vkLogicalDevice,
+                                         static_cast<uint32_t>(indices.graphicsFamily),
+                                         static_cast<uint32_t>(indices.transferFamily),
+                                         m_transferQueue,
+                                         utility::Settings::Instance().GetStagingBufferSize());
+
+    if(!m_pUploadService->Init())
+    {
+        LOG_VULKAN->Error("Failed to initialize upload service!");
+        return false;
+    }
+
+    m_pGeometryArena = new GeometryArena(m_vkPhysicalDevice, m_vkLogicalDevice, *m_pUploadService);
 
     return true;
 }
@@ -780,6 +2046,20 @@ bool Renderer::CreateSwapChain()
     createInfo.imageArrayLayers = 1;
     createInfo.imageUsage = vk::ImageUsageFlagBits::eColorAttachment;
 
+    // Upscaled scene is blitted into swapchain images
+    if(m_isDynamicResolution)
+    {
+        if(swapChainSupport.capabilities.supportedUsageFlags & vk::ImageUsageFlagBits::eTransferDst)
+        {
+            createInfo.imageUsage |= vk::ImageUsageFlagBits::eTransferDst;
+        }
+        else
+        {
+            LOG_VULKAN->Warning("Swapchain images can't be blitted into, dynamic resolution is turned off.");
+            m_isDynamicResolution = false;
+        }
+    }
+
     QueueFamilyIndices indices = FindQueueFamilies(m_vkPhysicalDevice);
     uint32_t queueFamilyIndices[] = {static_cast<uint32_t>(indices.graphicsFamily), static_cast<uint32_t>(indices.presentFamily)};
 
@@ -807,29 +2087,308 @@ bool Renderer::CreateSwapChain()
         createInfo.oldSwapchain = oldSwapChain;
     }
 
-    vk::SwapchainKHR newSwapChain;
-    vk::Result result = m_vkLogicalDevice.createSwapchainKHR(&createInfo, {}, &newSwapChain);
-    if(result != vk::Result::eSuccess)
+    vk::SwapchainKHR newSwapChain;
+    vk::Result result = m_vkLogicalDevice.createSwapchainKHR(&createInfo, {}, &newSwapChain);
+    if(result != vk::Result::eSuccess)
+    {
+        LOG_VULKAN->Error("Failed to create Vulkan swap chain!");
+        return false;
+    }
+
+    m_vkSwapChain = newSwapChain;
+
+    if(oldSwapChain)
+    {
+        m_vkLogicalDevice.destroySwapchainKHR(oldSwapChain);
+    }
+    std::tie(result, m_swapChainImages) = m_vkLogicalDevice.getSwapchainImagesKHR(m_vkSwapChain);
+    if(imageCount != m_swapChainImages.size() || result != vk::Result::eSuccess)
+    {
+        LOG_VULKAN->Error("SwapChain images not equal!");
+    }
+    m_swapChainImageFormat = surfaceFormat.format;
+    m_swapChainExtent = extent;
+
+    return true;
+}
+
+bool Renderer::CreateOffscreenImages()
+{
+    FreeOffscreenImages();
+
+    if(m_swapChainExtent.width == 0 || m_swapChainExtent.height == 0)
+    {
+        LOG_VULKAN->Error("Can't create offscreen images of {}x{} size!", m_swapChainExtent.width, m_swapChainExtent.height);
+        return false;
+    }
+
+    // Format is guaranteed to support color attachment and transfer usage
+    m_swapChainImageFormat = vk::Format::eR8G8B8A8Unorm;
+
+    // Every frame in flight renders into its own image, so readback of
+    // one frame doesn't race with rendering of the next one
+    uint32_t const imagesCount = std::max(utility::Settings::Instance().GetFramesInFlight(), 1u);
+
+    vk::ImageUsageFlags usage = vk::ImageUsageFlagBits::eColorAttachment | vk::ImageUsageFlagBits::eTransferSrc;
+
+    // Upscaled scene is blitted into offscreen images
+    if(m_isDynamicResolution)
+    {
+        usage |= vk::ImageUsageFlagBits::eTransferDst;
+    }
+
+    for(uint32_t i = 0; i < imagesCount; ++i)
+    {
+        Image* pImage = new Image(m_vkPhysicalDevice,
+                                  m_vkLogicalDevice,
+                                  m_swapChainImageFormat,
+                                  usage,
+                                  m_swapChainExtent.width,
+                                  m_swapChainExtent.height);
+
+        m_offscreenImages.push_back(pImage);
+
+        if(!pImage->IsInitialized())
+        {
+            LOG_VULKAN->Error("Failed to create offscreen image!");
+            return false;
+        }
+
+        m_swapChainImages.push_back(pImage->GetVkImage());
+    }
+
+    return true;
+}
+
+bool Renderer::CreateSceneImages()
+{
+    FreeSceneImages();
+
+    if(!m_isDynamicResolution)
+    {
+        SetRenderExtent(1.0f);
+        return true;
+    }
+
+    vk::FormatProperties properties;
+    m_vkPhysicalDevice.getFormatProperties(m_swapChainImageFormat, &properties);
+
+    vk::FormatFeatureFlags const blitFeatures = vk::FormatFeatureFlagBits::eBlitSrc | vk::FormatFeatureFlagBits::eBlitDst;
+
+    if((properties.optimalTilingFeatures & blitFeatures) != blitFeatures)
+    {
+        LOG_VULKAN->Warning("Format of output images doesn't support blits, dynamic resolution is turned off.");
+        m_isDynamicResolution = false;
+        SetRenderExtent(1.0f);
+        return true;
+    }
+
+    m_upscaleFilter = (properties.optimalTilingFeatures & vk::FormatFeatureFlagBits::eSampledImageFilterLinear) ?
+        vk::Filter::eLinear : vk::Filter::eNearest;
+
+    for(size_t i = 0; i < m_frames.size(); ++i)
+    {
+        Image* pImage = new Image(m_vkPhysicalDevice,
+                                  m_vkLogicalDevice,
+                                  m_swapChainImageFormat,
+                                  vk::ImageUsageFlagBits::eColorAttachment | vk::ImageUsageFlagBits::eTransferSrc,
+                                  m_swapChainExtent.width,
+                                  m_swapChainExtent.height);
+
+        m_sceneImages.push_back(pImage);
+
+        if(!pImage->IsInitialized())
+        {
+            LOG_VULKAN->Error("Failed to create scene image!");
+            return false;
+        }
+    }
+
+    // Output size might change, current scale is kept
+    SetRenderExtent(m_resolutionScale);
+
+    return true;
+}
+
+bool Renderer::CreateTimestampQueries()
+{
+    FreeTimestampQueries();
+
+    QueueFamilyIndices const indices = FindQueueFamilies(m_vkPhysicalDevice);
+    uint32_t const validBits = m_vkPhysicalDevice.getQueueFamilyProperties()[indices.graphicsFamily].timestampValidBits;
+
+    m_timestampPeriod = m_physicalDeviceProperties.limits.timestampPeriod;
+    m_timestampMask = validBits >= 64 ? ~0ull : ((1ull << validBits) - 1);
+
+    m_isDynamicResolution = utility::Settings::Instance().IsDynamicResolution();
+
+    if(validBits == 0)
+    {
+        if(m_isDynamicResolution)
+        {
+            LOG_VULKAN->Warning("Graphics queue has no timestamps, dynamic resolution is turned off.");
+            m_isDynamicResolution = false;
+        }
+
+        return true;
+    }
+
+    uint32_t const framesInFlight = std::max(utility::Settings::Instance().GetFramesInFlight(), 1u);
+
+    vk::QueryPoolCreateInfo poolInfo;
+    poolInfo.queryType = vk::QueryType::eTimestamp;
+    poolInfo.queryCount = 2 * framesInFlight;
+
+    if(m_vkLogicalDevice.createQueryPool(&poolInfo, {}, &m_timestampQueryPool) != vk::Result::eSuccess)
+    {
+        LOG_VULKAN->Error("Can't create timestamp query pool!");
+        m_timestampQueryPool = nullptr;
+        return false;
+    }
+
+    if(m_isDynamicResolution)
+    {
+        LOG_VULKAN->Info("Dynamic resolution is enabled, target GPU frame time is {} ns.",
+            static_cast<uint64_t>(utility::Settings::Instance().GetTargetFrameTime().count()));
+    }
+
+    return true;
+}
+
+void Renderer::RecordUpscale(FrameData& frame, uint32_t imageIndex) const
+{
+    vk::Image const outputImage = m_swapChainImages[imageIndex];
+
+    vk::ImageMemoryBarrier barrier;
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.image = outputImage;
+    barrier.subresourceRange.aspectMask = vk::ImageAspectFlagBits::eColor;
+    barrier.subresourceRange.baseMipLevel = 0;
+    barrier.subresourceRange.levelCount = 1;
+    barrier.subresourceRange.baseArrayLayer = 0;
+    barrier.subresourceRange.layerCount = 1;
+
+    // Previous contents of output image are overwritten
+    barrier.srcAccessMask = {};
+    barrier.dstAccessMask = vk::AccessFlagBits::eTransferWrite;
+    barrier.oldLayout = vk::ImageLayout::eUndefined;
+    barrier.newLayout = vk::ImageLayout::eTransferDstOptimal;
+
+    frame.commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer,
+                                        vk::PipelineStageFlagBits::eTransfer,
+                                        {}, 0,
+                                        nullptr, 0,
+                                        nullptr, 1,
+                                        &barrier);
+
+    vk::ImageBlit region;
+    region.srcSubresource.aspectMask = vk::ImageAspectFlagBits::eColor;
+    region.srcSubresource.mipLevel = 0;
+    region.srcSubresource.baseArrayLayer = 0;
+    region.srcSubresource.layerCount = 1;
+    region.srcOffsets[1] = vk::Offset3D(static_cast<int32_t>(m_renderExtent.width), static_cast<int32_t>(m_renderExtent.height), 1);
+    region.dstSubresource = region.srcSubresource;
+    region.dstOffsets[1] = vk::Offset3D(static_cast<int32_t>(m_swapChainExtent.width), static_cast<int32_t>(m_swapChainExtent.height), 1);
+
+    // Render pass leaves scene image in transfer source layout
+    frame.commandBuffer.blitImage(m_sceneImages[m_currentFrame]->GetVkImage(), vk::ImageLayout::eTransferSrcOptimal,
+        outputImage, vk::ImageLayout::eTransferDstOptimal, 1, &region, m_upscaleFilter);
+
+    // Output image ends in the layout it would get from the render pass
+    barrier.srcAccessMask = vk::AccessFlagBits::eTransferWrite;
+    barrier.oldLayout = vk::ImageLayout::eTransferDstOptimal;
+
+    if(m_isHeadless)
+    {
+        barrier.dstAccessMask = vk::AccessFlagBits::eTransferRead;
+        barrier.newLayout = vk::ImageLayout::eTransferSrcOptimal;
+    }
+    else
+    {
+        barrier.dstAccessMask = {};
+        barrier.newLayout = vk::ImageLayout::ePresentSrcKHR;
+    }
+
+    frame.commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer,
+                                        m_isHeadless ? vk::PipelineStageFlagBits::eTransfer : vk::PipelineStageFlagBits::eBottomOfPipe,
+                                        {}, 0,
+                                        nullptr, 0,
+                                        nullptr, 1,
+                                        &barrier);
+}
+
+bool Renderer::CreateReadbackBuffers()
+{
+    size_t const imageSize = static_cast<size_t>(m_swapChainExtent.width) * m_swapChainExtent.height * 4;
+
+    for(auto& frame : m_frames)
+    {
+        if(!frame.readbackBuffer.Create(m_vkPhysicalDevice, m_vkLogicalDevice, vk::BufferUsageFlagBits::eTransferDst,
+            MemoryUsage::Readback, imageSize))
+        {
+            LOG_VULKAN->Error("Can't create readback buffer!");
+            return false;
+        }
+
+        frame.readbackBuffer.Map();
+    }
+
+    return true;
+}
+
+void Renderer::RecordReadback(FrameData& frame, uint32_t imageIndex) const
+{
+    vk::BufferImageCopy region;
+    region.bufferOffset = 0;
+    region.bufferRowLength = 0;
+    region.bufferImageHeight = 0;
+    region.imageSubresource.aspectMask = vk::ImageAspectFlagBits::eColor;
+    region.imageSubresource.mipLevel = 0;
+    region.imageSubresource.baseArrayLayer = 0;
+    region.imageSubresource.layerCount = 1;
+    region.imageExtent = vk::Extent3D(m_swapChainExtent.width, m_swapChainExtent.height, 1);
+
+    // Render pass leaves color attachment in transfer source layout
+    frame.commandBuffer.copyImageToBuffer(m_swapChainImages[imageIndex], vk::ImageLayout::eTransferSrcOptimal,
+        frame.readbackBuffer.GetVkBuffer(), 1, &region);
+
+    vk::BufferMemoryBarrier barrier;
+    barrier.srcAccessMask = vk::AccessFlagBits::eTransferWrite;
+    barrier.dstAccessMask = vk::AccessFlagBits::eHostRead;
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.buffer = frame.readbackBuffer.GetVkBuffer();
+    barrier.offset = 0;
+    barrier.size = VK_WHOLE_SIZE;
+
+    frame.commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer,
+                                        vk::PipelineStageFlagBits::eHost,
+                                        {}, 0,
+                                        nullptr, 1,
+                                        &barrier, 0,
+                                        nullptr);
+}
+
+void Renderer::EmitReadback(FrameData& frame)
+{
+    if(!frame.isReadbackPending)
     {
-        LOG_VULKAN->Error("Failed to create Vulkan swap chain!");
-        return false;
+        return;
     }
 
-    m_vkSwapChain = newSwapChain;
+    frame.isReadbackPending = false;
 
-    if(oldSwapChain)
-    {
-        m_vkLogicalDevice.destroySwapchainKHR(oldSwapChain);
-    }
-    std::tie(result, m_swapChainImages) = m_vkLogicalDevice.getSwapchainImagesKHR(m_vkSwapChain);
-    if(imageCount != m_swapChainImages.size() || result != vk::Result::eSuccess)
-    {
-        LOG_VULKAN->Error("SwapChain images not equal!");
-    }
-    m_swapChainImageFormat = surfaceFormat.format;
-    m_swapChainExtent = extent;
+    frame.readbackBuffer.Invalidate();
 
-    return true;
+    ReadbackImage image;
+    image.frameIndex = frame.frameIndex;
+    image.width = m_swapChainExtent.width;
+    image.height = m_swapChainExtent.height;
+    image.rowPitch = m_swapChainExtent.width * 4;
+    image.pPixels = static_cast<uint8_t const*>(frame.readbackBuffer.GetMappedMemory());
+
+    FrameReadback.emit(this, image);
 }
 
 bool Renderer::CreateImageViews()
@@ -877,7 +2436,7 @@ bool Renderer::CreateRenderPass()
     attachments[0].stencilLoadOp = vk::AttachmentLoadOp::eDontCare;
     attachments[0].stencilStoreOp = vk::AttachmentStoreOp::eDontCare;
     attachments[0].initialLayout = vk::ImageLayout::eUndefined;
-    attachments[0].finalLayout = vk::ImageLayout::ePresentSrcKHR;
+    attachments[0].finalLayout = m_isHeadless || m_isDynamicResolution ? vk::ImageLayout::eTransferSrcOptimal : vk::ImageLayout::ePresentSrcKHR;
 
     attachments[1].format = m_depthImageFormat;
     attachments[1].samples = vk::SampleCountFlagBits::e1;
@@ -907,6 +2466,35 @@ bool Renderer::CreateRenderPass()
     renderPassInfo.subpassCount = 1;
     renderPassInfo.pSubpasses = &subpass;
 
+    std::array<vk::SubpassDependency, 2> dependencies;
+
+    // Frames in flight share depth image, so clear of the next frame waits for depth tests
+    // of the previous one. Color attachment transition waits for the acquired swapchain image
+    vk::PipelineStageFlags const attachmentStages = vk::PipelineStageFlagBits::eEarlyFragmentTests
+        | vk::PipelineStageFlagBits::eLateFragmentTests
+        | vk::PipelineStageFlagBits::eColorAttachmentOutput;
+
+    dependencies[0].srcSubpass = VK_SUBPASS_EXTERNAL;
+    dependencies[0].dstSubpass = 0;
+    dependencies[0].srcStageMask = attachmentStages;
+    dependencies[0].dstStageMask = attachmentStages;
+    dependencies[0].srcAccessMask = vk::AccessFlagBits::eDepthStencilAttachmentWrite | vk::AccessFlagBits::eColorAttachmentWrite;
+    dependencies[0].dstAccessMask = vk::AccessFlagBits::eDepthStencilAttachmentRead
+        | vk::AccessFlagBits::eDepthStencilAttachmentWrite
+        | vk::AccessFlagBits::eColorAttachmentWrite;
+
+    // Headless frames are copied to readback buffer and scaled scene is
+    // blitted to output image right after the render pass
+    dependencies[1].srcSubpass = 0;
+    dependencies[1].dstSubpass = VK_SUBPASS_EXTERNAL;
+    dependencies[1].srcStageMask = vk::PipelineStageFlagBits::eColorAttachmentOutput;
+    dependencies[1].dstStageMask = vk::PipelineStageFlagBits::eTransfer;
+    dependencies[1].srcAccessMask = vk::AccessFlagBits::eColorAttachmentWrite;
+    dependencies[1].dstAccessMask = vk::AccessFlagBits::eTransferRead;
+
+    renderPassInfo.dependencyCount = m_isHeadless || m_isDynamicResolution ? 2 : 1;
+    renderPassInfo.pDependencies = dependencies.data();
+
     vk::Result result = m_vkLogicalDevice.createRenderPass(&renderPassInfo, {}, &m_renderPass);
     if(result != vk::Result::eSuccess)
     {
@@ -921,34 +2509,29 @@ bool Renderer::CreateDescriptionSetLayout()
 {
     std::vector<vk::DescriptorPoolSize> descriptorPoolSizes;
 
+    uint32_t const framesCount = static_cast<uint32_t>(m_frames.size());
+
     vk::DescriptorPoolSize descriptorViewProjectionPoolSize;
     descriptorViewProjectionPoolSize.type = vk::DescriptorType::eUniformBuffer;
-    descriptorViewProjectionPoolSize.descriptorCount = 1;
+    descriptorViewProjectionPoolSize.descriptorCount = framesCount;
 
-    vk::DescriptorPoolSize descriptorModelPoolSize;
-    descriptorModelPoolSize.type = vk::DescriptorType::eUniformBufferDynamic;
-    descriptorModelPoolSize.descriptorCount = 1;
+    vk::DescriptorPoolSize descriptorInstancesPoolSize;
+    descriptorInstancesPoolSize.type = vk::DescriptorType::eStorageBuffer;
+    descriptorInstancesPoolSize.descriptorCount = framesCount;
 
     vk::DescriptorPoolSize descriptorSamplerPoolSize;
     descriptorSamplerPoolSize.type = vk::DescriptorType::eCombinedImageSampler;
-    descriptorSamplerPoolSize.descriptorCount = 3000; //TODO: task [#101] Custom vulkan allocator must enhance this
+    descriptorSamplerPoolSize.descriptorCount = m_isBindless ? 1 : s_materialSetsPerPool;
 
     descriptorPoolSizes.push_back(descriptorViewProjectionPoolSize);
-    descriptorPoolSizes.push_back(descriptorModelPoolSize);
+    descriptorPoolSizes.push_back(descriptorInstancesPoolSize);
     descriptorPoolSizes.push_back(descriptorSamplerPoolSize);
 
-    vk::DescriptorPoolCreateInfo poolCreateInfo;
-    poolCreateInfo.poolSizeCount = static_cast<uint32_t>(descriptorPoolSizes.size());
-    poolCreateInfo.pPoolSizes = descriptorPoolSizes.data();
-    poolCreateInfo.maxSets = 3000; //TODO: task [#101] Custom vulkan allocator must enhance this
-    poolCreateInfo.flags = vk::DescriptorPoolCreateFlagBits::eFreeDescriptorSet;
+    // Pools are chained when material sets don't fit anymore
+    m_pDescriptorAllocator = new DescriptorAllocator(m_vkLogicalDevice, descriptorPoolSizes,
+        framesCount + (m_isBindless ? 0 : s_materialSetsPerPool));
 
-    vk::Result result = m_vkLogicalDevice.createDescriptorPool(&poolCreateInfo, nullptr, &m_descriptorPool);
-    if(result != vk::Result::eSuccess)
-    {
-        LOG_VULKAN->Error("Can't create descriptor pool!");
-        return false;
-    }
+    vk::Result result;
 
     std::vector<vk::DescriptorSetLayoutBinding> mvpSetLayoutBindings;
 
@@ -958,11 +2541,11 @@ bool Renderer::CreateDescriptionSetLayout()
     setViewProjection.binding = 0;
     setViewProjection.descriptorCount = 1;
 
-    vk::DescriptorSetLayoutBinding setModel;
-    setModel.descriptorType = vk::DescriptorType::eUniformBufferDynamic;
-    setModel.stageFlags = vk::ShaderStageFlagBits::eVertex;
-    setModel.binding = 1;
-    setModel.descriptorCount = 1;
+    vk::DescriptorSetLayoutBinding setInstances;
+    setInstances.descriptorType = vk::DescriptorType::eStorageBuffer;
+    setInstances.stageFlags = vk::ShaderStageFlagBits::eVertex;
+    setInstances.binding = 1;
+    setInstances.descriptorCount = 1;
 
     vk::DescriptorSetLayoutBinding textureSampler;
     textureSampler.descriptorType = vk::DescriptorType::eCombinedImageSampler;
@@ -971,7 +2554,7 @@ bool Renderer::CreateDescriptionSetLayout()
     textureSampler.descriptorCount = 1;
 
     mvpSetLayoutBindings.push_back(setViewProjection);
-    mvpSetLayoutBindings.push_back(setModel);
+    mvpSetLayoutBindings.push_back(setInstances);
 
     vk::DescriptorSetLayoutCreateInfo mvpLayoutInfo;
     mvpLayoutInfo.pBindings = mvpSetLayoutBindings.data();
@@ -989,6 +2572,24 @@ bool Renderer::CreateDescriptionSetLayout()
     albedoLayoutInfo.pBindings = &textureSampler;
     albedoLayoutInfo.bindingCount = 1;
 
+#ifdef VK_EXT_descriptor_indexing
+    // Bindless array is written while recorded draws use it, unused elements are never read
+    vk::DescriptorBindingFlagsEXT const bindlessBindingFlags =
+        vk::DescriptorBindingFlagBitsEXT::ePartiallyBound | vk::DescriptorBindingFlagBitsEXT::eUpdateAfterBind;
+
+    vk::DescriptorSetLayoutBindingFlagsCreateInfoEXT bindlessFlagsInfo;
+    bindlessFlagsInfo.bindingCount = 1;
+    bindlessFlagsInfo.pBindingFlags = &bindlessBindingFlags;
+
+    if(m_isBindless)
+    {
+        textureSampler.descriptorCount = m_bindlessCapacity;
+
+        albedoLayoutInfo.flags = vk::DescriptorSetLayoutCreateFlagBits::eUpdateAfterBindPoolEXT;
+        albedoLayoutInfo.pNext = &bindlessFlagsInfo;
+    }
+#endif
+
     result = m_vkLogicalDevice.createDescriptorSetLayout(&albedoLayoutInfo, nullptr, &m_descriptorSetLayouts[1]);
 
     if(result != vk::Result::eSuccess)
@@ -997,29 +2598,61 @@ bool Renderer::CreateDescriptionSetLayout()
         return false;
     }
 
-    vk::DescriptorSetAllocateInfo allocInfo;
-    allocInfo.descriptorPool = m_descriptorPool;
-    allocInfo.descriptorSetCount = 1;
-    allocInfo.pSetLayouts = &m_descriptorSetLayouts[0];
+#ifdef VK_EXT_descriptor_indexing
+    if(m_isBindless)
+    {
+        vk::DescriptorPoolSize bindlessPoolSize;
+        bindlessPoolSize.type = vk::DescriptorType::eCombinedImageSampler;
+        bindlessPoolSize.descriptorCount = m_bindlessCapacity;
+
+        vk::DescriptorPoolCreateInfo bindlessPoolInfo;
+        bindlessPoolInfo.poolSizeCount = 1;
+        bindlessPoolInfo.pPoolSizes = &bindlessPoolSize;
+        bindlessPoolInfo.maxSets = 1;
+        bindlessPoolInfo.flags = vk::DescriptorPoolCreateFlagBits::eUpdateAfterBindEXT;
 
-    result = m_vkLogicalDevice.allocateDescriptorSets(&allocInfo, &m_mvpDescriptorSet);
+        result = m_vkLogicalDevice.createDescriptorPool(&bindlessPoolInfo, nullptr, &m_bindlessDescriptorPool);
 
-    if(result != vk::Result::eSuccess)
+        if(result != vk::Result::eSuccess)
+        {
+            LOG_VULKAN->Error("Can't create bindless descriptor pool!");
+            return false;
+        }
+
+        vk::DescriptorSetAllocateInfo bindlessAllocInfo;
+        bindlessAllocInfo.descriptorPool = m_bindlessDescriptorPool;
+        bindlessAllocInfo.descriptorSetCount = 1;
+        bindlessAllocInfo.pSetLayouts = &m_descriptorSetLayouts[1];
+
+        result = m_vkLogicalDevice.allocateDescriptorSets(&bindlessAllocInfo, &m_bindlessDescriptorSet);
+
+        if(result != vk::Result::eSuccess)
+        {
+            LOG_VULKAN->Error("Can't allocate bindless descriptor set!");
+            return false;
+        }
+    }
+#endif
+
+    for(auto& frame : m_frames)
     {
-        LOG_VULKAN->Error("Can't allocate descriptor sets!");
-        return false;
+        if(!m_pDescriptorAllocator->Allocate(m_descriptorSetLayouts[0], frame.mvpDescriptorSet))
+        {
+            LOG_VULKAN->Error("Can't allocate descriptor sets!");
+            return false;
+        }
     }
 
+    vk::PushConstantRange pushConstantRange;
+    pushConstantRange.stageFlags = vk::ShaderStageFlagBits::eVertex;
+    pushConstantRange.offset = 0;
+    pushConstantRange.size = sizeof(DrawParameters);
+
     vk::PipelineLayoutCreateInfo pipelineLayoutInfo;
     pipelineLayoutInfo.setLayoutCount = static_cast<uint32_t>(m_descriptorSetLayouts.size());
     pipelineLayoutInfo.pSetLayouts = m_descriptorSetLayouts.data();
-
-    vk::PushConstantRange pushConstanRange;
-    pushConstanRange.setSize(sizeof(glm::vec4) * 2); // color and texture coordinates
-    pushConstanRange.setStageFlags(vk::ShaderStageFlagBits::eVertex);
-
     pipelineLayoutInfo.pushConstantRangeCount = 1;
-    pipelineLayoutInfo.pPushConstantRanges = &pushConstanRange;
+    pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
 
     result = m_vkLogicalDevice.createPipelineLayout(&pipelineLayoutInfo, nullptr, &m_pipelineLayout);
     if(result != vk::Result::eSuccess)
@@ -1033,324 +2666,607 @@ bool Renderer::CreateDescriptionSetLayout()
 
 bool Renderer::CreateGraphicsPipeline()
 {
+    // Recorded draws inherit destroyed render pass and set viewport of the old extent
+    InvalidateRecordedDraws();
+
+    if(!m_pPipelineRegistry)
+    {
+        std::vector<vk::DynamicState> dynamicStates;
+
+#ifdef VK_EXT_extended_dynamic_state
+        if(m_hasExtendedDynamicState)
+        {
+            dynamicStates.push_back(vk::DynamicState::eDepthTestEnableEXT);
+            dynamicStates.push_back(vk::DynamicState::eCullModeEXT);
+        }
+#endif
+
+        m_pPipelineRegistry = new PipelineRegistry(m_vkLogicalDevice, m_pPipelineCache->GetCache(), m_pipelineLayout, dynamicStates);
+        m_pPipelineRegistry->AddShaderVariant(static_cast<uint32_t>(ShaderVariant::Uber),
+            "data/shaders/UberShader.vert.spv", "data/shaders/UberShader.frag.spv");
+        m_pPipelineRegistry->AddShaderVariant(static_cast<uint32_t>(ShaderVariant::UberBindless),
+            "data/shaders/UberShader.vert.spv", "data/shaders/UberShaderBindless.frag.spv");
+    }
+
+    m_pPipelineRegistry->SetRenderPass(m_renderPass, m_swapChainImageFormat, m_depthImageFormat);
+
+    m_isShaderSpecialization = utility::Settings::Instance().IsShaderSpecialization();
+
+    Material solid;
+    Material wired;
+    wired.SetIsWired(true);
+
+    if(!m_pPipelineRegistry->Get(MakePipelineState(solid)))
+    {
+        LOG_VULKAN->Error("Can't create solid pipeline.");
+        return false;
+    }
+
+    if(!m_pPipelineRegistry->Get(MakePipelineState(wired)))
+    {
+        LOG_VULKAN->Error("Can't create wired pipeline.");
+        return false;
+    }
+
+    return true;
+}
+
+bool Renderer::CreateFrustumCuller()
+{
+    FreeFrustumCuller();
+
+    m_pFrustumCuller = new FrustumCuller(m_vkLogicalDevice);
+
+    if(!m_pFrustumCuller->Create(static_cast<uint32_t>(m_frames.size()), m_pPipelineCache->GetCache()))
+    {
+        LOG_VULKAN->Error("Vulkan can't create frustum culler!");
+        return false;
+    }
+
+    return true;
+}
+
+bool Renderer::CreateFramebuffers()
+{
+    FreeFrameBuffers();
+
+    // With dynamic resolution every frame in flight renders into its scene image
+    size_t const framebuffersCount = m_isDynamicResolution ? m_sceneImages.size() : m_swapChainImageViews.size();
+
+    m_swapChainFramebuffers.resize(framebuffersCount);
+
+    vk::ImageView attachments[s_swapChainAttachmentsAmount];
+    attachments[1] = m_pDepthImage->GetVkImageView();
+
+    vk::FramebufferCreateInfo framebufferInfo;
+    framebufferInfo.renderPass = m_renderPass;
+    framebufferInfo.attachmentCount = s_swapChainAttachmentsAmount;
+    framebufferInfo.pAttachments = attachments;
+    framebufferInfo.width = m_swapChainExtent.width;
+    framebufferInfo.height = m_swapChainExtent.height;
+    framebufferInfo.layers = 1;
+
+    for(size_t i = 0; i < framebuffersCount; ++i)
+    {
+        attachments[0] = m_isDynamicResolution ? m_sceneImages[i]->GetVkImageView() : m_swapChainImageViews[i];
+        vk::Result result = m_vkLogicalDevice.createFramebuffer(&framebufferInfo, nullptr, &m_swapChainFramebuffers[i]);
+
+        if(result != vk::Result::eSuccess)
+        {
+            LOG_VULKAN->Error("Failed to create framebuffer!");
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool Renderer::CreateCommandPool()
+{
+    QueueFamilyIndices queueFamilyIndices = FindQueueFamilies(m_vkPhysicalDevice);
+
     vk::Result result;
-    FreeGraphicsPipeline();
 
-    m_shaderProgram = new ShaderProgram(m_vkLogicalDevice, "data/shaders/UberShader.vert.spv", "data/shaders/UberShader.frag.spv");
+    // Frame command buffers are short-lived and are reset together with their pool
+    vk::CommandPoolCreateInfo framePoolInfo;
+    framePoolInfo.flags = vk::CommandPoolCreateFlagBits::eTransient;
+    framePoolInfo.queueFamilyIndex = queueFamilyIndices.graphicsFamily;
+
+    for(auto& frame : m_frames)
+    {
+        result = m_vkLogicalDevice.createCommandPool(&framePoolInfo, {}, &frame.commandPool);
+        if(result != vk::Result::eSuccess)
+        {
+            LOG_VULKAN->Error("Failed to create frame command pool!");
+            return false;
+        }
+
+        vk::CommandBufferAllocateInfo allocInfo;
+        allocInfo.commandPool = frame.commandPool;
+        allocInfo.level = vk::CommandBufferLevel::ePrimary;
+        allocInfo.commandBufferCount = 1;
+
+        result = m_vkLogicalDevice.allocateCommandBuffers(&allocInfo, &frame.commandBuffer);
+        if(result != vk::Result::eSuccess)
+        {
+            LOG_VULKAN->Error("Failed to allocate frame command buffer!");
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool Renderer::CreateDepthBuffer()
+{
+    FreeDepthBuffer();
 
-    if(!m_shaderProgram->IsCreated())
+    if(!FindDepthFormat(m_depthImageFormat))
     {
-        LOG_VULKAN->Error("Vulkan can't create shader program!");
+        LOG_VULKAN->Error("Not one of desired depth formats are not compatible!");
         return false;
     }
+    m_pDepthImage = new Image(m_vkPhysicalDevice,
+                              m_vkLogicalDevice,
+                              m_depthImageFormat,
+                              vk::ImageUsageFlagBits::eDepthStencilAttachment,
+                              m_swapChainExtent.width,
+                              m_swapChainExtent.height);
+    return m_pDepthImage->IsInitialized();
+}
+
+bool Renderer::PrepareRecordingWorkers(FrameData& frame)
+{
+    uint32_t const workersCount = std::max(utility::Settings::Instance().GetRecordingWorkers(), 1u);
+
+    if(!m_pWorkerPool || m_pWorkerPool->GetWorkersCount() != workersCount)
+    {
+        FreeRecordingWorkers();
+
+        m_pWorkerPool = new utility::WorkerPool(workersCount);
+
+        LOG_VULKAN->Info("Renderer records commands with {} workers.", workersCount);
+    }
 
-    vk::PipelineInputAssemblyStateCreateInfo inputAssembly;
-    inputAssembly.topology = vk::PrimitiveTopology::eTriangleList;
+    // Draws are always recorded into secondary command buffers, so they can be reused
+    size_t const poolsCount = workersCount;
 
-    vk::Viewport viewport;
-    viewport.width = static_cast<float>(m_swapChainExtent.width);
-    viewport.height = static_cast<float>(m_swapChainExtent.height);
-    viewport.maxDepth = 1.0f;
+    if(frame.workerCommandPools.size() == poolsCount)
+    {
+        return true;
+    }
+
+    // Frame fence is signaled, so worker command buffers are not pending anymore
+    FreeWorkerCommandPools(frame);
+
+    QueueFamilyIndices const queueFamilyIndices = FindQueueFamilies(m_vkPhysicalDevice);
+
+    vk::CommandPoolCreateInfo poolInfo;
+    poolInfo.flags = vk::CommandPoolCreateFlagBits::eTransient;
+    poolInfo.queueFamilyIndex = queueFamilyIndices.graphicsFamily;
+
+    frame.workerCommandPools.resize(poolsCount);
+    frame.secondaryCommandBuffers.resize(poolsCount);
+
+    for(size_t i = 0; i < poolsCount; ++i)
+    {
+        vk::Result result = m_vkLogicalDevice.createCommandPool(&poolInfo, {}, &frame.workerCommandPools[i]);
+        if(result != vk::Result::eSuccess)
+        {
+            LOG_VULKAN->Error("Failed to create worker command pool!");
+            frame.workerCommandPools.resize(i);
+            FreeWorkerCommandPools(frame);
+            return false;
+        }
+
+        vk::CommandBufferAllocateInfo allocInfo;
+        allocInfo.commandPool = frame.workerCommandPools[i];
+        allocInfo.level = vk::CommandBufferLevel::eSecondary;
+        allocInfo.commandBufferCount = 1;
+
+        result = m_vkLogicalDevice.allocateCommandBuffers(&allocInfo, &frame.secondaryCommandBuffers[i]);
+        if(result != vk::Result::eSuccess)
+        {
+            LOG_VULKAN->Error("Failed to allocate secondary command buffer!");
+            frame.workerCommandPools.resize(i + 1);
+            FreeWorkerCommandPools(frame);
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool Renderer::RecordCommandBuffer(FrameData& frame, uint32_t imageIndex)
+{
+    auto const recordingStart = std::chrono::steady_clock::now();
+
+    if(!PrepareRecordingWorkers(frame))
+    {
+        return false;
+    }
+
+    // Draw parameters are read from the indirect buffer, so draws are recorded
+    // only when bound state changes
+    bool const areDrawsRecorded = !AreRecordedDrawsValid(frame);
+
+    if(areDrawsRecorded && !RecordDrawCommands(frame))
+    {
+        return false;
+    }
+
+    // Frame fence is signaled, so previous commands of this frame are completed
+    vk::Result result = m_vkLogicalDevice.resetCommandPool(frame.commandPool, {});
+    if(result != vk::Result::eSuccess)
+    {
+        LOG_VULKAN->Error("Failed to reset frame command pool!");
+        return false;
+    }
+
+    // Instance buffers might be reallocated, descriptor set is not used by GPU since frame fence is signaled
+    m_pFrustumCuller->UpdateDescriptorSet(m_currentFrame, frame.instanceBuffer, frame.cullingBuffer,
+        frame.indirectBuffer, frame.visibleInstanceBuffer, frame.cullingCountersBuffer, frame.cullingGroupBuffer);
+
+    vk::CommandBuffer& commandBuffer = frame.commandBuffer;
+
+    vk::CommandBufferBeginInfo beginInfo;
+    beginInfo.flags = vk::CommandBufferUsageFlagBits::eOneTimeSubmit;
+
+    commandBuffer.begin(beginInfo);
+
+    if(m_timestampQueryPool)
+    {
+        commandBuffer.resetQueryPool(m_timestampQueryPool, 2 * m_currentFrame, 2);
+    }
+
+    m_pUploadService->RecordAcquireBarriers(commandBuffer);
+
+    m_pFrustumCuller->Record(commandBuffer, m_currentFrame, m_cullingFrustum, static_cast<uint32_t>(m_drawGroups.size()));
+
+    // Only scene render pass is timed: culling has waited for uploads, scaled scene doesn't wait for swapchain image
+    if(m_timestampQueryPool)
+    {
+        commandBuffer.writeTimestamp(vk::PipelineStageFlagBits::eComputeShader, m_timestampQueryPool, 2 * m_currentFrame);
+    }
+
+    vk::RenderPassBeginInfo renderPassInfo;
+    renderPassInfo.renderPass = m_renderPass;
+    renderPassInfo.framebuffer = m_swapChainFramebuffers[m_isDynamicResolution ? m_currentFrame : imageIndex];
+    renderPassInfo.renderArea.setOffset({0, 0});
+    renderPassInfo.renderArea.extent = m_renderExtent;
+
+    vk::ClearColorValue clearColor(m_backgroundColor);
+
+    std::array<vk::ClearValue, 2> clearValues = {};
+    clearValues[0].color = clearColor;
+    clearValues[1].depthStencil.setDepth(1.0f);
+
+    renderPassInfo.clearValueCount = static_cast<uint32_t>(clearValues.size());
+    renderPassInfo.pClearValues = clearValues.data();
+
+    commandBuffer.beginRenderPass(&renderPassInfo, vk::SubpassContents::eSecondaryCommandBuffers);
+
+    if(frame.recordedChunksCount > 0)
+    {
+        commandBuffer.executeCommands(static_cast<uint32_t>(frame.recordedChunksCount), frame.secondaryCommandBuffers.data());
+    }
+
+    commandBuffer.endRenderPass();
+
+    if(m_timestampQueryPool)
+    {
+        commandBuffer.writeTimestamp(vk::PipelineStageFlagBits::eColorAttachmentOutput, m_timestampQueryPool, 2 * m_currentFrame + 1);
+    }
+
+    if(m_isDynamicResolution)
+    {
+        RecordUpscale(frame, imageIndex);
+    }
+
+    if(m_isHeadless)
+    {
+        RecordReadback(frame, imageIndex);
+    }
+
+    result = commandBuffer.end();
+    if(result != vk::Result::eSuccess)
+    {
+        LOG_VULKAN->Error("Failed to record frame command buffer!");
+        return false;
+    }
+
+    uint32_t drawCount = 0;
+    uint32_t instanceCount = 0;
+
+    for(auto const& group : m_drawGroups)
+    {
+        if(group.instanceCount > 0)
+        {
+            ++drawCount;
+            instanceCount += group.instanceCount;
+        }
+    }
+
+    m_frameStats.drawCount = drawCount;
+    m_frameStats.instanceCount = instanceCount;
+    m_frameStats.pipelineBindCount = frame.recordedCounters.pipelineBinds;
+    m_frameStats.vertexBufferBindCount = frame.recordedCounters.vertexBufferBinds;
+    m_frameStats.descriptorSetBindCount = frame.recordedCounters.descriptorSetBinds;
+    m_frameStats.drawCallCount = frame.recordedCounters.drawCalls;
+    m_frameStats.skippedBindCount = frame.recordedCounters.skippedBinds;
+
+    DescriptorAllocator::Stats const descriptorStats = m_pDescriptorAllocator->GetStats();
+    m_frameStats.descriptorPoolCount = descriptorStats.poolsCount;
+    m_frameStats.descriptorSetCount = descriptorStats.allocatedSetsCount - descriptorStats.recycledSetsCount;
+    m_frameStats.descriptorSetCapacity = descriptorStats.setsCapacity;
+    m_frameStats.pipelineCount = static_cast<uint32_t>(m_pPipelineRegistry->GetPipelinesCount());
+    m_frameStats.recordingWorkers = static_cast<uint32_t>(frame.recordedChunksCount);
+    m_frameStats.areDrawsRecorded = areDrawsRecorded;
+    m_frameStats.resolutionScale = m_resolutionScale;
+    m_frameStats.recordingTime = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - recordingStart);
+
+    return true;
+}
+
+bool Renderer::RecordDrawCommands(FrameData& frame)
+{
+    frame.hasRecordedDraws = false;
+    frame.recordedChunksCount = 0;
+
+    // Multi draw records one call per batch, otherwise every command is a draw call of its own
+    bool const isMultiDraw = m_hasMultiDrawIndirect && m_hasIndirectFirstInstance;
+    size_t const commandsCount = m_drawGroups.size();
+    size_t const drawCallsCount = isMultiDraw ? m_drawBatches.size() : commandsCount;
 
-    vk::Rect2D scissor;
-    scissor.offset.setX(0);
-    scissor.offset.setY(0);
-    scissor.extent = m_swapChainExtent;
-
-    vk::PipelineViewportStateCreateInfo viewportState;
-    viewportState.viewportCount = 1;
-    viewportState.pViewports = &viewport;
-    viewportState.scissorCount = 1;
-    viewportState.pScissors = &scissor;
-
-    vk::PipelineRasterizationStateCreateInfo rasterizer;
-    rasterizer.lineWidth = 1.0f;
-    rasterizer.cullMode = vk::CullModeFlagBits::eNone;
-    rasterizer.frontFace = vk::FrontFace::eClockwise;
-    rasterizer.polygonMode = vk::PolygonMode::eFill;
-
-    vk::PipelineMultisampleStateCreateInfo multisampling; // TODO: configure MSAA at global level.
-    multisampling.sampleShadingEnable = VK_FALSE;
-    multisampling.rasterizationSamples = vk::SampleCountFlagBits::e1;
-    multisampling.minSampleShading = 1.0f;
-    multisampling.pSampleMask = nullptr;
-    multisampling.alphaToCoverageEnable = VK_FALSE;
-    multisampling.alphaToOneEnable = VK_FALSE;
-
-    vk::PipelineDepthStencilStateCreateInfo depthStencil;
-    depthStencil.depthTestEnable = m_depthTestEnabled;
-    depthStencil.depthWriteEnable = VK_TRUE;
-    depthStencil.depthCompareOp = vk::CompareOp::eLessOrEqual;
-    depthStencil.stencilTestEnable = VK_FALSE;
-    depthStencil.back.failOp = vk::StencilOp::eKeep;
-    depthStencil.back.passOp = vk::StencilOp::eKeep;
-    depthStencil.back.compareOp = vk::CompareOp::eAlways;
-    depthStencil.back.compareMask = 0;
-    depthStencil.back.reference = 0;
-    depthStencil.back.depthFailOp = vk::StencilOp::eKeep;
-    depthStencil.back.writeMask = 0;
-    depthStencil.front = depthStencil.back;
-
-    vk::PipelineColorBlendAttachmentState colorBlendAttachment;
-    colorBlendAttachment.colorWriteMask = vk::ColorComponentFlagBits::eR | vk::ColorComponentFlagBits::eG | vk::ColorComponentFlagBits::eB | vk::ColorComponentFlagBits::eA;
-    colorBlendAttachment.blendEnable = VK_TRUE;
-    colorBlendAttachment.colorBlendOp = vk::BlendOp::eAdd;
-    colorBlendAttachment.srcColorBlendFactor = vk::BlendFactor::eSrcAlpha;
-    colorBlendAttachment.dstColorBlendFactor = vk::BlendFactor::eOneMinusSrcAlpha;
-
-    vk::PipelineColorBlendStateCreateInfo colorBlending;
-    colorBlending.attachmentCount = 1;
-    colorBlending.pAttachments = &colorBlendAttachment;
-
-    if(!m_shaderProgram->IsCreated())
-    {
-        LOG_VULKAN->Error("Can't create shader module!");
-        return false;
-    }
+    // Commands are split into chunks of equal amount of draw calls, each chunk is recorded by its own worker
+    size_t const maxChunks = (drawCallsCount + s_minDrawsPerWorker - 1) / s_minDrawsPerWorker;
+    size_t const chunksCount = std::min(frame.workerCommandPools.size(), maxChunks);
+    size_t const chunkDrawCalls = chunksCount > 0 ? (drawCallsCount + chunksCount - 1) / chunksCount : 0;
 
-    auto vertexInputInfo = m_shaderProgram->GetVertexInputInfo();
-
-    vk::GraphicsPipelineCreateInfo pipelineInfo;
-    pipelineInfo.stageCount = 2;
-    pipelineInfo.pStages = m_shaderProgram->GetShaderStageInfoData();
-    pipelineInfo.pVertexInputState = &vertexInputInfo;
-    pipelineInfo.pInputAssemblyState = &inputAssembly;
-    pipelineInfo.pViewportState = &viewportState;
-    pipelineInfo.pRasterizationState = &rasterizer;
-    pipelineInfo.pMultisampleState = &multisampling;
-    pipelineInfo.pDepthStencilState = &depthStencil;
-    pipelineInfo.pColorBlendState = &colorBlending;
-    pipelineInfo.pDynamicState = nullptr;
-    pipelineInfo.layout = m_pipelineLayout;
-    pipelineInfo.renderPass = m_renderPass;
-    pipelineInfo.subpass = 0;
-    pipelineInfo.basePipelineHandle = nullptr;
-    pipelineInfo.basePipelineIndex = -1; // Optional
-
-    //Solid pipeline
-    std::tie(result, m_pipelines.solid) = m_vkLogicalDevice.createGraphicsPipeline({}, pipelineInfo);
-    if(result != vk::Result::eSuccess)
-    {
-        LOG_VULKAN->Error("Can't create solid pipeline.");
-        return false;
-    }
+    // First command of every chunk followed by the end of the last one, multi draw chunks start with batches
+    std::vector<size_t> chunkCommands(chunksCount + 1, commandsCount);
 
-    // Wire frame rendering pipeline
-    if(m_deviceFeatures.fillModeNonSolid)
+    for(size_t chunk = 0; chunk < chunksCount; ++chunk)
     {
-        colorBlendAttachment.blendEnable = VK_FALSE;
-        rasterizer.polygonMode = vk::PolygonMode::eLine;
+        size_t const firstDrawCall = chunk * chunkDrawCalls;
 
-        std::tie(result, m_pipelines.wired) = m_vkLogicalDevice.createGraphicsPipeline({}, pipelineInfo);
-        if(result != vk::Result::eSuccess)
+        if(firstDrawCall < drawCallsCount)
         {
-            LOG_VULKAN->Error("Can't create blend pipeline.");
-            return false;
+            chunkCommands[chunk] = isMultiDraw ? m_drawBatches[firstDrawCall].firstCommand : firstDrawCall;
         }
     }
 
-    m_shaderProgram->DestroyShaderModules();
+    // Framebuffer is not inherited, so recorded draws are valid for any swapchain image
+    vk::CommandBufferInheritanceInfo inheritanceInfo;
+    inheritanceInfo.renderPass = m_renderPass;
+    inheritanceInfo.subpass = 0;
 
-    return true;
-}
+    std::vector<vk::Result> results(chunksCount, vk::Result::eSuccess);
+    std::vector<DrawCounters> counters(chunksCount);
 
-bool Renderer::CreateFramebuffers()
-{
-    FreeFrameBuffers();
+    auto recordChunk = [&](uint32_t chunk, uint32_t /*worker*/)
+    {
+        // Each chunk owns a command pool, so pools are never shared between threads
+        results[chunk] = m_vkLogicalDevice.resetCommandPool(frame.workerCommandPools[chunk], {});
+        if(results[chunk] != vk::Result::eSuccess)
+        {
+            return;
+        }
 
-    m_swapChainFramebuffers.resize(m_swapChainImageViews.size());
+        vk::CommandBuffer secondaryCommandBuffer = frame.secondaryCommandBuffers[chunk];
 
-    vk::ImageView attachments[s_swapChainAttachmentsAmount];
-    attachments[1] = m_pDepthImage->GetVkImageView();
+        // Buffers are resubmitted while batches don't change, so they are not one time submit
+        vk::CommandBufferBeginInfo secondaryBeginInfo;
+        secondaryBeginInfo.flags = vk::CommandBufferUsageFlagBits::eRenderPassContinue;
+        secondaryBeginInfo.pInheritanceInfo = &inheritanceInfo;
 
-    vk::FramebufferCreateInfo framebufferInfo;
-    framebufferInfo.renderPass = m_renderPass;
-    framebufferInfo.attachmentCount = s_swapChainAttachmentsAmount;
-    framebufferInfo.pAttachments = attachments;
-    framebufferInfo.width = m_swapChainExtent.width;
-    framebufferInfo.height = m_swapChainExtent.height;
-    framebufferInfo.layers = 1;
+        secondaryCommandBuffer.begin(secondaryBeginInfo);
+
+        RecordDraws(secondaryCommandBuffer, frame, chunkCommands[chunk], chunkCommands[chunk + 1], counters[chunk]);
 
-    for(size_t i = 0; i < m_swapChainImageViews.size(); ++i)
+        results[chunk] = secondaryCommandBuffer.end();
+    };
+
+    if(chunksCount > 1)
     {
-        attachments[0] = m_swapChainImageViews[i];
-        vk::Result result = m_vkLogicalDevice.createFramebuffer(&framebufferInfo, nullptr, &m_swapChainFramebuffers[i]);
+        m_pWorkerPool->Execute(static_cast<uint32_t>(chunksCount), recordChunk);
+    }
+    else if(chunksCount == 1)
+    {
+        recordChunk(0, 0);
+    }
 
-        if(result != vk::Result::eSuccess)
+    for(auto chunkResult : results)
+    {
+        if(chunkResult != vk::Result::eSuccess)
         {
-            LOG_VULKAN->Error("Failed to create framebuffer!");
+            LOG_VULKAN->Error("Failed to record secondary command buffer!");
             return false;
         }
     }
 
-    return true;
-}
+    frame.recordedChunksCount = chunksCount;
+    frame.recordedBatches = m_drawBatches;
+    frame.recordedCounters = DrawCounters();
 
-bool Renderer::CreateCommandPool()
-{
-    QueueFamilyIndices queueFamilyIndices = FindQueueFamilies(m_vkPhysicalDevice);
+    for(auto const& chunkCounters : counters)
+    {
+        frame.recordedCounters += chunkCounters;
+    }
+    frame.recordedFirstInstances.clear();
 
-    vk::CommandPoolCreateInfo poolInfo = {};
-    poolInfo.queueFamilyIndex = queueFamilyIndices.graphicsFamily;
-    vk::Result result = m_vkLogicalDevice.createCommandPool(&poolInfo, {}, &m_commandPool);
-    if(result != vk::Result::eSuccess)
+    if(!m_hasIndirectFirstInstance)
     {
-        LOG_VULKAN->Error("Failed to create command pool!");
-        return false;
+        for(auto const& group : m_drawGroups)
+        {
+            frame.recordedFirstInstances.push_back(group.firstInstance);
+        }
     }
 
+    frame.hasRecordedDraws = true;
+
     return true;
 }
 
-bool Renderer::CreateDepthBuffer()
+void Renderer::RecordDraws(vk::CommandBuffer commandBuffer, FrameData const& frame, size_t firstCommand, size_t lastCommand, DrawCounters& counters) const
 {
-    FreeDepthBuffer();
-
-    if(!FindDepthFormat(m_depthImageFormat))
+    if(firstCommand >= lastCommand)
     {
-        LOG_VULKAN->Error("Not one of desired depth formats are not compatible!");
-        return false;
+        return;
     }
-    m_pDepthImage = new Image(m_vkPhysicalDevice,
-                              m_vkLogicalDevice,
-                              m_depthImageFormat,
-                              vk::ImageUsageFlagBits::eDepthStencilAttachment,
-                              m_swapChainExtent.width,
-                              m_swapChainExtent.height);
-    return m_pDepthImage->IsInitialized();
-}
 
-bool Renderer::CreateCommandBuffers()
-{
-    FreeCommandBuffers();
+    vk::DeviceSize offsets[] = {0};
+    vk::Buffer boundVertexBuffer;
+    vk::DescriptorSet boundMaterialDescriptorSet;
+    vk::Pipeline boundPipeline;
+    vk::Buffer const indirectBuffer = frame.indirectBuffer.GetVkBuffer();
+    uint32_t const commandStride = sizeof(vk::DrawIndexedIndirectCommand);
 
-    m_commandBuffers.resize(m_swapChainFramebuffers.size());
+    // Instances are indexed by firstInstance of commands, offset is pushed per draw only without it
+    DrawParameters drawParameters;
+    drawParameters.instanceOffset = 0;
+    commandBuffer.pushConstants(m_pipelineLayout, vk::ShaderStageFlagBits::eVertex, 0, sizeof(DrawParameters), &drawParameters);
 
-    vk::CommandBufferAllocateInfo allocInfo;
-    allocInfo.commandPool = m_commandPool;
-    allocInfo.level = vk::CommandBufferLevel::ePrimary;
-    allocInfo.commandBufferCount = static_cast<uint32_t>(m_commandBuffers.size());
+    // Set 0: Scene descriptor set containing global matrices and visible instances
+    commandBuffer.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, m_pipelineLayout,
+        0, 1, &frame.mvpDescriptorSet, 0, nullptr);
+    ++counters.descriptorSetBinds;
 
-    vk::Result result = m_vkLogicalDevice.allocateCommandBuffers(&allocInfo, m_commandBuffers.data());
+    // Secondary command buffers don't inherit dynamic state, every chunk sets it
+    vk::Viewport viewport;
+    viewport.width = static_cast<float>(m_renderExtent.width);
+    viewport.height = static_cast<float>(m_renderExtent.height);
+    viewport.maxDepth = 1.0f;
 
-    if(result != vk::Result::eSuccess)
-    {
-        LOG_VULKAN->Error("Failed to allocate command buffers!");
-        return false;
-    }
+    vk::Rect2D scissor;
+    scissor.extent = m_renderExtent;
 
-    for(size_t i = 0; i < m_commandBuffers.size(); ++i)
+    commandBuffer.setViewport(0, 1, &viewport);
+    commandBuffer.setScissor(0, 1, &scissor);
+
+#ifdef VK_EXT_extended_dynamic_state
+    if(m_hasExtendedDynamicState)
     {
-        vk::CommandBufferBeginInfo beginInfo;
-        beginInfo.flags = vk::CommandBufferUsageFlagBits::eSimultaneousUse;
+        VkCommandBuffer const vkCommandBuffer = static_cast<VkCommandBuffer>(commandBuffer);
+
+        m_cmdSetDepthTestEnable(vkCommandBuffer, m_depthTestEnabled ? VK_TRUE : VK_FALSE);
+        m_cmdSetCullMode(vkCommandBuffer, VK_CULL_MODE_NONE);
+    }
+#endif
 
-        m_commandBuffers[i].begin(beginInfo);
+    // Chunk may start and end in the middle of a batch
+    auto batchIt = std::upper_bound(m_drawBatches.begin(), m_drawBatches.end(), firstCommand,
+        [](size_t command, DrawBatch const& batch) { return command < batch.firstCommand; });
+    --batchIt;
 
-        vk::RenderPassBeginInfo renderPassInfo;
-        renderPassInfo.renderPass = m_renderPass;
-        renderPassInfo.framebuffer = m_swapChainFramebuffers[i];
-        renderPassInfo.renderArea.setOffset({0, 0});
-        renderPassInfo.renderArea.extent = m_swapChainExtent;
+    for(; batchIt != m_drawBatches.end() && batchIt->firstCommand < lastCommand; ++batchIt)
+    {
+        DrawBatch const& batch = *batchIt;
 
-        vk::ClearColorValue clearColor(m_backgroundColor);
+        uint32_t const begin = static_cast<uint32_t>(std::max<size_t>(batch.firstCommand, firstCommand));
+        uint32_t const end = static_cast<uint32_t>(std::min<size_t>(batch.firstCommand + batch.commandCount, lastCommand));
 
-        std::array<vk::ClearValue, 2> clearValues = {};
-        clearValues[0].color = clearColor;
-        clearValues[1].depthStencil.setDepth(1.0f);
+        // Pipeline failed to be created, error is already reported by registry
+        if(!batch.pipeline)
+        {
+            continue;
+        }
 
-        renderPassInfo.clearValueCount = static_cast<uint32_t>(clearValues.size());
-        renderPassInfo.pClearValues = clearValues.data();
+        if(batch.pipeline != boundPipeline)
+        {
+            commandBuffer.bindPipeline(vk::PipelineBindPoint::eGraphics, batch.pipeline);
+            boundPipeline = batch.pipeline;
+            ++counters.pipelineBinds;
+        }
+        else
+        {
+            ++counters.skippedBinds;
+        }
 
-        m_commandBuffers[i].beginRenderPass(&renderPassInfo, vk::SubpassContents::eInline);
+        if(batch.vertexBuffer != boundVertexBuffer)
+        {
+            commandBuffer.bindVertexBuffers(0, 1, &batch.vertexBuffer, offsets);
+            commandBuffer.bindIndexBuffer(batch.indexBuffer, 0, vk::IndexType::eUint32);
+            boundVertexBuffer = batch.vertexBuffer;
+            counters.vertexBufferBinds += 2;
+        }
+        else
+        {
+            counters.skippedBinds += 2;
+        }
 
-        vk::DeviceSize offsets[] = {0};
+        if(batch.materialDescriptorSet != boundMaterialDescriptorSet)
+        {
+            // Set 1: Per-Material descriptor set containing bound images or bindless texture array
+            commandBuffer.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, m_pipelineLayout,
+                1, 1, &batch.materialDescriptorSet, 0, nullptr);
+            boundMaterialDescriptorSet = batch.materialDescriptorSet;
+            ++counters.descriptorSetBinds;
+        }
+        else
+        {
+            ++counters.skippedBinds;
+        }
 
+        if(m_hasMultiDrawIndirect && m_hasIndirectFirstInstance)
         {
-            uint32_t j = 0;
+            // Single call draws all commands of the batch, split only by device limit
+            uint32_t const maxDrawCount = std::max(m_physicalDeviceProperties.limits.maxDrawIndirectCount, 1u);
 
-            for(auto pVkMesh : m_vkMeshes)
+            for(uint32_t first = begin; first < end; first += maxDrawCount)
             {
-                auto vkMeshMaterial = pVkMesh->GetMesh().GetMaterial();
-
-                if (!vkMeshMaterial->IsVisible())
+                commandBuffer.drawIndexedIndirect(indirectBuffer, first * static_cast<vk::DeviceSize>(commandStride),
+                    std::min(end - first, maxDrawCount), commandStride);
+                ++counters.drawCalls;
+            }
+        }
+        else
+        {
+            for(uint32_t command = begin; command < end; ++command)
+            {
+                if(!m_hasIndirectFirstInstance)
                 {
-                    ++j;
-                    continue;
+                    drawParameters.instanceOffset = m_drawGroups[command].firstInstance;
+                    commandBuffer.pushConstants(m_pipelineLayout, vk::ShaderStageFlagBits::eVertex, 0, sizeof(DrawParameters), &drawParameters);
                 }
 
-                if(pVkMesh->IsValid())
-                {
-                    glm::vec4 colorPush(
-                        vkMeshMaterial->GetColor(), // xyz - color
-                        vkMeshMaterial->IsColored() // w - boolean flag for 1 enabled color or 0 disabled color
-                    );
-
-                    if(vkMeshMaterial->IsWired())
-                    {
-                        m_commandBuffers[i].bindPipeline(vk::PipelineBindPoint::eGraphics, m_pipelines.wired);
-                    }
-                    else
-                    {
-                        m_commandBuffers[i].bindPipeline(vk::PipelineBindPoint::eGraphics, m_pipelines.solid);
-                    }
-
-                    m_commandBuffers[i].pushConstants(m_pipelineLayout, vk::ShaderStageFlagBits::eVertex, 0, sizeof(glm::vec4), glm::value_ptr(colorPush));
-
-                    m_commandBuffers[i].pushConstants(m_pipelineLayout, vk::ShaderStageFlagBits::eVertex, sizeof(glm::vec4), sizeof(glm::vec4),
-                        glm::value_ptr(vkMeshMaterial->GetNormalizedSpriteArea()));
-
-                    vk::Buffer vertexBuffer[] = {pVkMesh->GetVertexBuffer()};
-                    uint32_t dynamicOffset = j * static_cast<uint32_t>(m_dynamicAlignment);
-                    m_commandBuffers[i].bindVertexBuffers(0, 1, vertexBuffer, offsets);
-                    m_commandBuffers[i].bindIndexBuffer(pVkMesh->GetIndexBuffer(), 0, vk::IndexType::eUint32);
-
-                    std::array<vk::DescriptorSet, 2> descriptorSets;
-                    // Set 0: Scene descriptor set containing global matrices
-                    descriptorSets[0] = m_mvpDescriptorSet;
-                    // Set 1: Per-Material descriptor set containing bound images
-                    descriptorSets[1] = pVkMesh->pMaterial->descriptorSet;
-
-                    m_commandBuffers[i].bindDescriptorSets(vk::PipelineBindPoint::eGraphics, m_pipelineLayout,
-                        0, static_cast<uint32_t>(descriptorSets.size()),
-                        descriptorSets.data(), 1, &dynamicOffset);
-
-                    m_commandBuffers[i].drawIndexed(static_cast<uint32_t>(pVkMesh->GetMesh().GetIndices().size()), 1, 0, 0, 0);
-
-                    ++j;
-                }
+                commandBuffer.drawIndexedIndirect(indirectBuffer, command * static_cast<vk::DeviceSize>(commandStride),
+                    1, commandStride);
+                ++counters.drawCalls;
             }
         }
-
-        m_commandBuffers[i].endRenderPass();
-
-        m_commandBuffers[i].end();
     }
-
-    return true;
 }
 
-bool Renderer::CreateSemaphores()
+bool Renderer::CreateSyncObjects()
 {
     vk::SemaphoreCreateInfo semaphoreInfo;
-    if(m_vkLogicalDevice.createSemaphore(&semaphoreInfo, {}, &m_imageAvailableSemaphore) == vk::Result::eSuccess &&
-        m_vkLogicalDevice.createSemaphore(&semaphoreInfo, {}, &m_renderFinishedSemaphore) == vk::Result::eSuccess)
+
+    // Fences are created signaled so the first wait for every frame returns immediately
+    vk::FenceCreateInfo fenceInfo;
+    fenceInfo.flags = vk::FenceCreateFlagBits::eSignaled;
+
+    for(auto& frame : m_frames)
     {
-        return true;
+        if(m_vkLogicalDevice.createSemaphore(&semaphoreInfo, {}, &frame.imageAvailableSemaphore) != vk::Result::eSuccess ||
+            m_vkLogicalDevice.createSemaphore(&semaphoreInfo, {}, &frame.renderFinishedSemaphore) != vk::Result::eSuccess ||
+            m_vkLogicalDevice.createFence(&fenceInfo, {}, &frame.inFlightFence) != vk::Result::eSuccess)
+        {
+            LOG_VULKAN->Error("Failed to create frame synchronization objects!");
+            return false;
+        }
     }
 
-    LOG_VULKAN->Error("Failed to create semaphores!");
-    return false;
+    return true;
 }
 
 bool Renderer::CreatePipelineCache()
 {
-    vk::PipelineCacheCreateInfo pipelineCacheCreateInfo;
-    if(m_vkLogicalDevice.createPipelineCache(&pipelineCacheCreateInfo, nullptr, &pipelineCache) != vk::Result::eSuccess)
-    {
-        LOG_VULKAN->Error( "Can't create pipeline cache!" );
-        return false;
-    }
-    return true;
+    FreePipelineCache();
+
+    m_pPipelineCache = new PipelineCache(m_vkLogicalDevice, m_physicalDeviceProperties);
+
+    return m_pPipelineCache->Create(utility::Settings::Instance().GetPipelineCachePath());
 }
 
 bool Renderer::LoadEngineHelpData()
@@ -1364,7 +3280,7 @@ bool Renderer::LoadEngineHelpData()
     }
     VkTexture* replaceMeTexture = new VkTexture(m_vkLogicalDevice);
 
-    if(!replaceMeTexture->Create(m_vkPhysicalDevice, m_vkLogicalDevice, m_commandPool, m_graphicsQueue, texture))
+    if(!replaceMeTexture->Create(m_vkPhysicalDevice, m_vkLogicalDevice, *m_pUploadService, texture))
     {
         LOG_VULKAN->Error("Can't create 'replace me' texture - {}", path.c_str());
 
@@ -1373,47 +3289,19 @@ bool Renderer::LoadEngineHelpData()
         return false;
     }
 
-    vk::DescriptorSetAllocateInfo allocInfo;
-    allocInfo.descriptorPool = m_descriptorPool;
-    allocInfo.descriptorSetCount = 1;
-    allocInfo.pSetLayouts = &m_descriptorSetLayouts[1];
+    m_pReplaceMeMaterial = CreateVkMaterial(replaceMeTexture, texture.GetId());
 
-    vk::DescriptorSet descriptorSet;
-
-    auto result = m_vkLogicalDevice.allocateDescriptorSets(&allocInfo, &descriptorSet);
-
-    if(result != vk::Result::eSuccess)
+    if(!m_pReplaceMeMaterial)
     {
-        LOG_VULKAN->Error("Can't allocate descriptor sets!");
-
-        replaceMeTexture->Delete();
-        delete replaceMeTexture;
-
         return false;
     }
 
-    vk::WriteDescriptorSet imageDescriptorSet;
-    imageDescriptorSet.setDstSet(descriptorSet);
-    imageDescriptorSet.setDescriptorType(vk::DescriptorType::eCombinedImageSampler);
-    imageDescriptorSet.setDescriptorCount(1);
-    imageDescriptorSet.setPImageInfo(&replaceMeTexture->GetDescriptorImageInfo());
-
-    m_vkLogicalDevice.updateDescriptorSets(1, &imageDescriptorSet, 0, nullptr);
-
-    m_pReplaceMeMaterial = std::shared_ptr<VkMaterial>(new VkMaterial, [](VkMaterial* p)
-    {
-        p->texture->Delete();
-        p->device.freeDescriptorSets(p->pool, p->descriptorSet);
-        delete p;
-    });
-
-    m_pReplaceMeMaterial->texture = replaceMeTexture;
-    m_pReplaceMeMaterial->descriptorSet = descriptorSet;
-    m_pReplaceMeMaterial->handle = texture.GetId();
-    m_pReplaceMeMaterial->device = m_vkLogicalDevice;
-    m_pReplaceMeMaterial->pool = m_descriptorPool;
+    MaterialEntry entry;
+    entry.handle = texture.GetId();
+    entry.pMaterial = m_pReplaceMeMaterial;
 
-    m_materials.push_back(m_pReplaceMeMaterial);
+    m_materialIndices[entry.handle] = m_materials.size();
+    m_materials.push_back(entry);
 
     return true;
 }
@@ -1425,12 +3313,12 @@ bool Renderer::IsDeviceSuitable(const vk::PhysicalDevice& device)
     LOG_VULKAN->Info("Found GPU : {}", deviceProperties.deviceName);
     QueueFamilyIndices indices = FindQueueFamilies(device);
     bool extensionsSupported = CheckDeviceExtensionSupport(device);
-    bool swapChainAcceptable = false;
+    bool swapChainAcceptable = m_isHeadless;
 
     vk::PhysicalDeviceFeatures deviceFeatures;
     device.getFeatures(&deviceFeatures);
 
-    if(extensionsSupported)
+    if(extensionsSupported && !m_isHeadless)
     {
         SwapChainSupportDetails swapChainSupport;
         if(!QuerySwapChainSupport(swapChainSupport, device))
@@ -1457,12 +3345,19 @@ bool Renderer::AllocateMaterial(const Mesh& mesh, VkMesh& vkmesh)
     {
         uint32_t meshAlbedoHandle = meshMaterial->GetAlbedo()->GetId();
 
-        auto meshMaterialIt = std::find_if(m_materials.begin(), m_materials.end(), [=](std::weak_ptr<VkMaterial> material) ->bool { return material.lock()->handle == meshAlbedoHandle; });
+        auto materialIndexIt = m_materialIndices.find(meshAlbedoHandle);
+
+        std::shared_ptr<VkMaterial> pMaterial;
 
-        if(meshMaterialIt == m_materials.end())
+        if(materialIndexIt != m_materialIndices.end())
+        {
+            pMaterial = m_materials[materialIndexIt->second].pMaterial.lock();
+        }
+
+        if(!pMaterial)
         {
             VkTexture* vkTexture = new VkTexture(m_vkLogicalDevice);
-            vkTexture->Create(m_vkPhysicalDevice, m_vkLogicalDevice, m_commandPool, m_graphicsQueue, *meshMaterial->GetAlbedo().get());
+            vkTexture->Create(m_vkPhysicalDevice, m_vkLogicalDevice, *m_pUploadService, *meshMaterial->GetAlbedo().get());
 
             if(!vkTexture->IsInitialized())
             {
@@ -1473,56 +3368,139 @@ bool Renderer::AllocateMaterial(const Mesh& mesh, VkMesh& vkmesh)
                 return false;
             }
 
-            vk::DescriptorSetAllocateInfo allocInfo;
-            allocInfo.descriptorPool = m_descriptorPool;
-            allocInfo.descriptorSetCount = 1;
-            allocInfo.pSetLayouts = &m_descriptorSetLayouts[1];
-
-            vk::DescriptorSet descriptorSet;
+            pMaterial = CreateVkMaterial(vkTexture, meshAlbedoHandle);
 
-            auto result = m_vkLogicalDevice.allocateDescriptorSets(&allocInfo, &descriptorSet);
-
-            if(result != vk::Result::eSuccess)
+            if(!pMaterial)
             {
-                LOG_VULKAN->Error("Can't allocate sampler descriptor sets!");
-
                 return false;
             }
 
-            vk::WriteDescriptorSet imageDescriptorSet;
-            imageDescriptorSet.setDstSet(descriptorSet);
-            imageDescriptorSet.setDescriptorType(vk::DescriptorType::eCombinedImageSampler);
-            imageDescriptorSet.setDescriptorCount(1);
-            imageDescriptorSet.setPImageInfo(&vkTexture->GetDescriptorImageInfo());
+            // Entry of expired material is reused, so every texture has a single entry
+            if(materialIndexIt != m_materialIndices.end())
+            {
+                m_materials[materialIndexIt->second].pMaterial = pMaterial;
+            }
+            else
+            {
+                MaterialEntry entry;
+                entry.handle = meshAlbedoHandle;
+                entry.pMaterial = pMaterial;
+
+                m_materialIndices[meshAlbedoHandle] = m_materials.size();
+                m_materials.push_back(entry);
+            }
+        }
 
-            m_vkLogicalDevice.updateDescriptorSets(1, &imageDescriptorSet, 0, nullptr);
+        vkmesh.pMaterial = pMaterial;
+    }
+    else
+    {
+        vkmesh.pMaterial = m_pReplaceMeMaterial;
+    }
 
-            vkmesh.pMaterial = std::shared_ptr<VkMaterial>(new VkMaterial, [](VkMaterial* p)
-                                                   {
-                                                       p->texture->Delete();
-                                                       p->device.freeDescriptorSets(p->pool, p->descriptorSet);
-                                                       delete p;
-                                                   });
+    return true;
+}
 
-            vkmesh.pMaterial->texture = vkTexture;
-            vkmesh.pMaterial->descriptorSet = descriptorSet;
-            vkmesh.pMaterial->handle = meshAlbedoHandle;
-            vkmesh.pMaterial->device = m_vkLogicalDevice;
-            vkmesh.pMaterial->pool = m_descriptorPool;
+std::shared_ptr<VkMaterial> Renderer::CreateVkMaterial(VkTexture* pTexture, uint32_t handle)
+{
+    vk::DescriptorSet descriptorSet;
+    uint32_t textureIndex = 0;
 
-            m_materials.push_back(vkmesh.pMaterial);
+    if(m_isBindless)
+    {
+        if(!m_freeTextureIndices.empty())
+        {
+            textureIndex = m_freeTextureIndices.back();
+            m_freeTextureIndices.pop_back();
+        }
+        else if(m_bindlessTextureCount < m_bindlessCapacity)
+        {
+            textureIndex = m_bindlessTextureCount++;
         }
         else
         {
-            vkmesh.pMaterial = (*meshMaterialIt).lock();;
+            LOG_VULKAN->Error("Bindless texture array is full, capacity - {}", m_bindlessCapacity);
+
+            pTexture->Delete();
+            delete pTexture;
+
+            return nullptr;
         }
+
+        descriptorSet = m_bindlessDescriptorSet;
     }
     else
     {
-        vkmesh.pMaterial = m_pReplaceMeMaterial;
+        if(!m_pDescriptorAllocator->Allocate(m_descriptorSetLayouts[1], descriptorSet))
+        {
+            LOG_VULKAN->Error("Can't allocate sampler descriptor sets!");
+
+            pTexture->Delete();
+            delete pTexture;
+
+            return nullptr;
+        }
     }
 
-    return true;
+    vk::WriteDescriptorSet imageDescriptorSet;
+    imageDescriptorSet.setDstSet(descriptorSet);
+    imageDescriptorSet.setDstArrayElement(textureIndex);
+    imageDescriptorSet.setDescriptorType(vk::DescriptorType::eCombinedImageSampler);
+    imageDescriptorSet.setDescriptorCount(1);
+    imageDescriptorSet.setPImageInfo(&pTexture->GetDescriptorImageInfo());
+
+    m_vkLogicalDevice.updateDescriptorSets(1, &imageDescriptorSet, 0, nullptr);
+
+    // Materials are released only after frames which used them are finished,
+    // so their descriptor set or bindless texture index can be reused right away
+    std::shared_ptr<VkMaterial> pMaterial(new VkMaterial, [this](VkMaterial* p)
+    {
+        p->texture->Delete();
+        delete p->texture;
+
+        if(m_isBindless)
+        {
+            m_freeTextureIndices.push_back(p->textureIndex);
+        }
+        else
+        {
+            m_pDescriptorAllocator->Free(m_descriptorSetLayouts[1], p->descriptorSet);
+        }
+
+        delete p;
+    });
+
+    pMaterial->texture = pTexture;
+    pMaterial->descriptorSet = descriptorSet;
+    pMaterial->handle = handle;
+    pMaterial->textureIndex = textureIndex;
+
+    return pMaterial;
+}
+
+void Renderer::RemoveExpiredMaterials()
+{
+    size_t liveCount = 0;
+
+    for(size_t i = 0; i < m_materials.size(); ++i)
+    {
+        if(m_materials[i].pMaterial.expired())
+        {
+            m_materialIndices.erase(m_materials[i].handle);
+        }
+        else
+        {
+            if(liveCount != i)
+            {
+                m_materials[liveCount] = std::move(m_materials[i]);
+            }
+
+            m_materialIndices[m_materials[liveCount].handle] = liveCount;
+            ++liveCount;
+        }
+    }
+
+    m_materials.resize(liveCount);
 }
 
 bool Renderer::CheckDeviceExtensionSupport(const vk::PhysicalDevice& device)
@@ -1548,46 +3526,120 @@ bool Renderer::CheckDeviceExtensionSupport(const vk::PhysicalDevice& device)
 
 bool Renderer::Frame()
 {
-    uint32_t imageIndex;
-    vk::Result result = m_vkLogicalDevice.acquireNextImageKHR(m_vkSwapChain,
-                                                              std::numeric_limits<uint64_t>::max(),
-                                                              m_imageAvailableSemaphore,
-                                                              nullptr,
-                                                              &imageIndex);
+    FrameData& frame = m_frames[m_currentFrame];
 
-    if(result == vk::Result::eErrorOutOfDateKHR)
+    // Wait until GPU finishes the previous frame which used the same resources
+    vk::Result result = m_vkLogicalDevice.waitForFences(1, &frame.inFlightFence, VK_TRUE, std::numeric_limits<uint64_t>::max());
+    if(result != vk::Result::eSuccess)
+    {
+        LOG_VULKAN->Error("Failed to wait for frame fence!");
+        return false;
+    }
+
+    EmitReadback(frame);
+    ReadCullingCounters(frame);
+    ReadGpuTime(frame);
+    ReleaseFrameResources(frame);
+    CompactGeometry();
+
+    BuildDrawList();
+
+    UpdateUniformBuffer(frame);
+
+    // Buffers are filled before swapchain image is acquired, so their failure
+    // doesn't leave image available semaphore signaled
+    if(!UpdateInstanceBuffer(frame) || !UpdateIndirectBuffer(frame))
+    {
+        return false;
+    }
+
+    // Headless renderer has an offscreen image for every frame in flight
+    uint32_t imageIndex = m_currentFrame;
+
+    if(!m_isHeadless)
     {
-        if(!RecreateSwapChain())
+        result = m_vkLogicalDevice.acquireNextImageKHR(m_vkSwapChain,
+                                                       std::numeric_limits<uint64_t>::max(),
+                                                       frame.imageAvailableSemaphore,
+                                                       nullptr,
+                                                       &imageIndex);
+
+        if(result == vk::Result::eErrorOutOfDateKHR)
         {
-            LOG_VULKAN->Error("Can't recreate swapchain!");
+            if(!RecreateSwapChain())
+            {
+                LOG_VULKAN->Error("Can't recreate swapchain!");
+                return false;
+            }
+            return true;
+        }
+        if(result != vk::Result::eSuccess && result != vk::Result::eSuboptimalKHR)
+        {
+            LOG_VULKAN->Error("Failed to acquire swap chain image!");
             return false;
         }
-        return true;
     }
-    if(result != vk::Result::eSuccess && result != vk::Result::eSuboptimalKHR)
+
+    if(!RecordCommandBuffer(frame, imageIndex))
     {
-        LOG_VULKAN->Error("Failed to acquire swap chain image!");
+        if(!m_isHeadless)
+        {
+            // Acquired image is not rendered, waiting on its semaphore leaves it unsignaled for the next acquire
+            vk::PipelineStageFlags const waitStage = vk::PipelineStageFlagBits::eTopOfPipe;
+
+            vk::SubmitInfo waitInfo;
+            waitInfo.waitSemaphoreCount = 1;
+            waitInfo.pWaitSemaphores = &frame.imageAvailableSemaphore;
+            waitInfo.pWaitDstStageMask = &waitStage;
+
+            m_graphicsQueue.submit(1, &waitInfo, nullptr);
+        }
+
         return false;
     }
 
+    // Uploads recorded since the previous frame are submitted as a single batch. Frame command buffer
+    // holds their acquire barriers, so nothing may fail between the flush and the frame submission
+    vk::Semaphore const uploadSemaphore = m_pUploadService->Flush(frame.uploadToken);
+
     vk::SubmitInfo submitInfo;
 
-    vk::Semaphore waitSemaphores[] = {m_imageAvailableSemaphore};
-    vk::PipelineStageFlags waitStages[] = {vk::PipelineStageFlagBits::eColorAttachmentOutput};
-    submitInfo.waitSemaphoreCount = 1;
+    vk::Semaphore waitSemaphores[2];
+    vk::PipelineStageFlags waitStages[2];
+    uint32_t waitSemaphoreCount = 0;
+    vk::Semaphore signalSemaphores[] = {frame.renderFinishedSemaphore};
+
+    if(!m_isHeadless)
+    {
+        waitSemaphores[waitSemaphoreCount] = frame.imageAvailableSemaphore;
+        // Upscaled scene is written into swapchain image by a blit
+        waitStages[waitSemaphoreCount] = m_isDynamicResolution ?
+            vk::PipelineStageFlagBits::eTransfer : vk::PipelineStageFlagBits::eColorAttachmentOutput;
+        ++waitSemaphoreCount;
+
+        submitInfo.signalSemaphoreCount = 1;
+        submitInfo.pSignalSemaphores = signalSemaphores;
+    }
+
+    if(uploadSemaphore)
+    {
+        waitSemaphores[waitSemaphoreCount] = uploadSemaphore;
+        // Culling waits for uploads as well, so scene timestamps don't cover the wait
+        waitStages[waitSemaphoreCount] = UploadService::GetConsumerStages() | vk::PipelineStageFlagBits::eComputeShader;
+        ++waitSemaphoreCount;
+    }
+
+    submitInfo.waitSemaphoreCount = waitSemaphoreCount;
     submitInfo.pWaitSemaphores = waitSemaphores;
     submitInfo.pWaitDstStageMask = waitStages;
-    submitInfo.commandBufferCount = 1;
-    submitInfo.pCommandBuffers = &m_commandBuffers[imageIndex];
 
-    vk::Semaphore signalSemaphores[] = {m_renderFinishedSemaphore};
-    submitInfo.signalSemaphoreCount = 1;
-    submitInfo.pSignalSemaphores = signalSemaphores;
+    submitInfo.commandBufferCount = 1;
+    submitInfo.pCommandBuffers = &frame.commandBuffer;
 
-    UpdateUniformBuffer();
-    UpdateDynamicUniformBuffer();
+    // Fence is reset only when work is guaranteed to be submitted
+    m_vkLogicalDevice.resetFences(1, &frame.inFlightFence);
 
-    result = m_graphicsQueue.submit(1, &submitInfo, nullptr);
+    result = m_graphicsQueue.submit(1, &submitInfo, frame.inFlightFence);
 
     if(result != vk::Result::eSuccess)
     {
@@ -1595,6 +3647,18 @@ bool Renderer::Frame()
         return false;
     }
 
+    frame.frameIndex = m_frameCounter++;
+    frame.isReadbackPending = m_isHeadless;
+    frame.isCullingPending = true;
+    frame.isTimestampPending = static_cast<bool>(m_timestampQueryPool);
+
+    m_currentFrame = (m_currentFrame + 1) % static_cast<uint32_t>(m_frames.size());
+
+    if(m_isHeadless)
+    {
+        return true;
+    }
+
     vk::PresentInfoKHR presentInfo;
 
     presentInfo.waitSemaphoreCount = 1;
@@ -0,0 +1,566 @@
+/*
+* Copyright (C) 2017 by Godlike
+* This code is licensed under the MIT license (MIT)
+* (http://opensource.org/licenses/MIT)
+*/
+
+#include <unicorn/video/vulkan/ShaderModuleCache.hpp>
+
+#include <unicorn/utility/Hash.hpp>
+#include <unicorn/utility/InternalLoggers.hpp>
+
+#include <mule/asset/SimpleStorage.hpp>
+
+#include <algorithm>
+#include <cstring>
+#include <tuple>
+
+namespace unicorn
+{
+namespace video
+{
+namespace vulkan
+{
+namespace
+{
+// SPIR-V values used by reflection, see SPIR-V specification
+namespace spv
+{
+uint32_t const magic = 0x07230203;
+uint32_t const headerSize = 5;
+
+enum Op : uint32_t
+{
+    OpEntryPoint = 15,
+    OpTypeBool = 20,
+    OpTypeInt = 21,
+    OpTypeFloat = 22,
+    OpTypeVector = 23,
+    OpTypeMatrix = 24,
+    OpTypeImage = 25,
+    OpTypeSampler = 26,
+    OpTypeSampledImage = 27,
+    OpTypeArray = 28,
+    OpTypeRuntimeArray = 29,
+    OpTypeStruct = 30,
+    OpTypePointer = 32,
+    OpConstant = 43,
+    OpVariable = 59,
+    OpDecorate = 71,
+    OpMemberDecorate = 72
+};
+
+enum Decoration : uint32_t
+{
+    BufferBlock = 3,
+    ArrayStride = 6,
+    MatrixStride = 7,
+    Binding = 33,
+    DescriptorSet = 34,
+    Offset = 35
+};
+
+enum StorageClass : uint32_t
+{
+    UniformConstant = 0,
+    Uniform = 2,
+    PushConstant = 9,
+    StorageBuffer = 12
+};
+
+enum Dim : uint32_t
+{
+    DimBuffer = 5,
+    DimSubpassData = 6
+};
+}
+
+//! Declaration of SPIR-V id used by reflection
+struct SpvId
+{
+    uint32_t opcode = 0;
+    //! Operands of declaring instruction following result id
+    std::vector<uint32_t> operands;
+
+    uint32_t set = UINT32_MAX;
+    uint32_t binding = UINT32_MAX;
+    uint32_t arrayStride = 0;
+    bool isBufferBlock = false;
+
+    //! Offsets and matrix strides of struct members
+    std::vector<uint32_t> memberOffsets;
+    std::vector<uint32_t> memberMatrixStrides;
+};
+
+vk::ShaderStageFlagBits GetStage(uint32_t executionModel)
+{
+    switch(executionModel)
+    {
+        case 0: return vk::ShaderStageFlagBits::eVertex;
+        case 1: return vk::ShaderStageFlagBits::eTessellationControl;
+        case 2: return vk::ShaderStageFlagBits::eTessellationEvaluation;
+        case 3: return vk::ShaderStageFlagBits::eGeometry;
+        case 4: return vk::ShaderStageFlagBits::eFragment;
+        default: return vk::ShaderStageFlagBits::eCompute;
+    }
+}
+
+//! Returns size of the type in a block, matrix stride is given by struct member
+uint32_t GetTypeSize(std::vector<SpvId> const& ids, uint32_t typeId, uint32_t matrixStride)
+{
+    if(typeId >= ids.size())
+    {
+        return 0;
+    }
+
+    SpvId const& type = ids[typeId];
+
+    switch(type.opcode)
+    {
+        case spv::OpTypeBool:
+            return 4;
+        case spv::OpTypeInt:
+        case spv::OpTypeFloat:
+            return type.operands.empty() ? 0 : type.operands[0] / 8;
+        case spv::OpTypeVector:
+            return type.operands.size() < 2 ? 0 : type.operands[1] * GetTypeSize(ids, type.operands[0], 0);
+        case spv::OpTypeMatrix:
+            return type.operands.size() < 2 ? 0 : type.operands[1] * (matrixStride ? matrixStride : GetTypeSize(ids, type.operands[0], 0));
+        case spv::OpTypeArray:
+        {
+            if(type.operands.size() < 2 || type.operands[1] >= ids.size())
+            {
+                return 0;
+            }
+
+            uint32_t const length = ids[type.operands[1]].operands.size() > 1 ? ids[type.operands[1]].operands[1] : 0;
+            uint32_t const stride = type.arrayStride ? type.arrayStride : GetTypeSize(ids, type.operands[0], matrixStride);
+            return length * stride;
+        }
+        case spv::OpTypeStruct:
+        {
+            uint32_t size = 0;
+
+            for(uint32_t member = 0; member < type.operands.size(); ++member)
+            {
+                uint32_t const offset = member < type.memberOffsets.size() ? type.memberOffsets[member] : 0;
+                uint32_t const stride = member < type.memberMatrixStrides.size() ? type.memberMatrixStrides[member] : 0;
+                size = std::max(size, offset + GetTypeSize(ids, type.operands[member], stride));
+            }
+
+            return size;
+        }
+        default:
+            // Runtime arrays don't add to the size
+            return 0;
+    }
+}
+
+void SetMemberDecoration(std::vector<uint32_t>& values, uint32_t member, uint32_t value)
+{
+    if(member >= values.size())
+    {
+        values.resize(member + 1, 0);
+    }
+
+    values[member] = value;
+}
+}
+
+ShaderModuleCache::~ShaderModuleCache()
+{
+    if(!m_modules.empty())
+    {
+        LOG_VULKAN->Warning("Shader module cache is destroyed with {} modules in use!", m_modules.size());
+    }
+
+    for(auto& codes : m_codes)
+    {
+        for(Code* pCode : codes.second)
+        {
+            delete pCode;
+        }
+    }
+}
+
+ShaderModuleCache::Module ShaderModuleCache::Acquire(vk::Device device, std::string const& path)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    Module result;
+
+    Code const* pCode = GetCode(path);
+
+    if(!pCode)
+    {
+        return result;
+    }
+
+    result.pReflection = &pCode->reflection;
+
+    ModuleKey const key(static_cast<VkDevice>(device), pCode);
+    auto moduleIt = m_modules.find(key);
+
+    if(moduleIt != m_modules.end())
+    {
+        ++moduleIt->second.refCount;
+        result.module = moduleIt->second.module;
+        return result;
+    }
+
+    vk::ShaderModuleCreateInfo createInfo;
+    createInfo.codeSize = pCode->words.size() * sizeof(uint32_t);
+    createInfo.pCode = pCode->words.data();
+
+    if(device.createShaderModule(&createInfo, {}, &result.module) != vk::Result::eSuccess)
+    {
+        LOG_VULKAN->Error("Failed to create shader module of {}!", path);
+        result.module = nullptr;
+        return result;
+    }
+
+    m_modules.emplace(key, ModuleEntry{ result.module, 1 });
+    m_moduleKeys.emplace(static_cast<VkShaderModule>(result.module), key);
+
+    return result;
+}
+
+void ShaderModuleCache::Release(vk::Device device, vk::ShaderModule module)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    auto keyIt = m_moduleKeys.find(static_cast<VkShaderModule>(module));
+
+    if(keyIt == m_moduleKeys.end() || keyIt->second.first != static_cast<VkDevice>(device))
+    {
+        LOG_VULKAN->Error("Released shader module is not acquired from the cache!");
+        return;
+    }
+
+    auto moduleIt = m_modules.find(keyIt->second);
+
+    if(--moduleIt->second.refCount == 0)
+    {
+        device.destroyShaderModule(moduleIt->second.module);
+
+        m_modules.erase(moduleIt);
+        m_moduleKeys.erase(keyIt);
+    }
+}
+
+size_t ShaderModuleCache::GetCodesCount() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    size_t count = 0;
+
+    for(auto const& codes : m_codes)
+    {
+        count += codes.second.size();
+    }
+
+    return count;
+}
+
+size_t ShaderModuleCache::GetModulesCount() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    return m_modules.size();
+}
+
+ShaderModuleCache::Code const* ShaderModuleCache::GetCode(std::string const& path)
+{
+    auto pathIt = m_paths.find(path);
+
+    if(pathIt != m_paths.end())
+    {
+        return pathIt->second;
+    }
+
+    mule::asset::Handler handler = mule::asset::SimpleStorage::Instance().Get(path);
+
+    if(!handler.IsValid())
+    {
+        LOG_VULKAN->Error("Can't find shader {}!", path);
+        return nullptr;
+    }
+
+    std::vector<uint8_t> const& bytes = handler.GetContent().GetBuffer();
+
+    if(bytes.empty() || bytes.size() % sizeof(uint32_t) != 0)
+    {
+        LOG_VULKAN->Error("Shader code size of {} is not multiple of sizeof(uint32_t), look at VkShaderModuleCreateInfo(3) Manual Page.", path);
+        return nullptr;
+    }
+
+    std::vector<uint32_t> words(bytes.size() / sizeof(uint32_t));
+    std::memcpy(words.data(), bytes.data(), bytes.size());
+
+    uint64_t const hash = utility::HashBytes(words.data(), words.size() * sizeof(uint32_t));
+    std::vector<Code*>& codes = m_codes[hash];
+
+    for(Code* pCode : codes)
+    {
+        if(pCode->words == words)
+        {
+            m_paths.emplace(path, pCode);
+            return pCode;
+        }
+    }
+
+    Code* pCode = new Code;
+    pCode->words = std::move(words);
+    pCode->hash = hash;
+
+    if(!Reflect(pCode->words, pCode->reflection))
+    {
+        LOG_VULKAN->Error("Shader {} is not valid SPIR-V!", path);
+        delete pCode;
+        return nullptr;
+    }
+
+    codes.push_back(pCode);
+    m_paths.emplace(path, pCode);
+
+    LOG_VULKAN->Debug("Loaded shader {}: {} bindings, {} bytes of push constants",
+        path, pCode->reflection.bindings.size(), pCode->reflection.pushConstantSize);
+
+    return pCode;
+}
+
+bool ShaderModuleCache::Reflect(std::vector<uint32_t> const& words, ShaderReflection& reflection)
+{
+    if(words.size() < spv::headerSize || words[0] != spv::magic)
+    {
+        return false;
+    }
+
+    // Word 3 of the header is upper bound of ids
+    uint32_t const bound = words[3];
+    std::vector<SpvId> ids(bound);
+    std::vector<uint32_t> variables;
+
+    reflection = ShaderReflection();
+
+    for(size_t offset = spv::headerSize; offset < words.size();)
+    {
+        uint32_t const opcode = words[offset] & 0xFFFF;
+        uint32_t const wordsCount = words[offset] >> 16;
+
+        if(wordsCount == 0 || offset + wordsCount > words.size())
+        {
+            return false;
+        }
+
+        uint32_t const* pOperands = &words[offset + 1];
+        uint32_t const operandsCount = wordsCount - 1;
+
+        switch(opcode)
+        {
+            case spv::OpEntryPoint:
+            {
+                if(operandsCount > 0)
+                {
+                    reflection.stages |= GetStage(pOperands[0]);
+                }
+                break;
+            }
+            case spv::OpDecorate:
+            {
+                if(operandsCount < 2 || pOperands[0] >= bound)
+                {
+                    break;
+                }
+
+                SpvId& id = ids[pOperands[0]];
+                uint32_t const value = operandsCount > 2 ? pOperands[2] : 0;
+
+                switch(pOperands[1])
+                {
+                    case spv::BufferBlock: id.isBufferBlock = true; break;
+                    case spv::ArrayStride: id.arrayStride = value; break;
+                    case spv::Binding: id.binding = value; break;
+                    case spv::DescriptorSet: id.set = value; break;
+                    default: break;
+                }
+                break;
+            }
+            case spv::OpMemberDecorate:
+            {
+                if(operandsCount < 4 || pOperands[0] >= bound)
+                {
+                    break;
+                }
+
+                SpvId& id = ids[pOperands[0]];
+
+                if(pOperands[2] == spv::Offset)
+                {
+                    SetMemberDecoration(id.memberOffsets, pOperands[1], pOperands[3]);
+                }
+                else if(pOperands[2] == spv::MatrixStride)
+                {
+                    SetMemberDecoration(id.memberMatrixStrides, pOperands[1], pOperands[3]);
+                }
+                break;
+            }
+            case spv::OpTypeBool:
+            case spv::OpTypeInt:
+            case spv::OpTypeFloat:
+            case spv::OpTypeVector:
+            case spv::OpTypeMatrix:
+            case spv::OpTypeImage:
+            case spv::OpTypeSampler:
+            case spv::OpTypeSampledImage:
+            case spv::OpTypeArray:
+            case spv::OpTypeRuntimeArray:
+            case spv::OpTypeStruct:
+            case spv::OpTypePointer:
+            {
+                if(operandsCount > 0 && pOperands[0] < bound)
+                {
+                    ids[pOperands[0]].opcode = opcode;
+                    ids[pOperands[0]].operands.assign(pOperands + 1, pOperands + operandsCount);
+                }
+                break;
+            }
+            case spv::OpConstant:
+            case spv::OpVariable:
+            {
+                // Result type comes before result id, it stays first operand
+                if(operandsCount > 1 && pOperands[1] < bound)
+                {
+                    ids[pOperands[1]].opcode = opcode;
+                    ids[pOperands[1]].operands.assign(1, pOperands[0]);
+                    ids[pOperands[1]].operands.insert(ids[pOperands[1]].operands.end(), pOperands + 2, pOperands + operandsCount);
+
+                    if(opcode == spv::OpVariable)
+                    {
+                        variables.push_back(pOperands[1]);
+                    }
+                }
+                break;
+            }
+            default:
+                break;
+        }
+
+        offset += wordsCount;
+    }
+
+    for(uint32_t variableId : variables)
+    {
+        SpvId const& variable = ids[variableId];
+
+        if(variable.operands.size() < 2 || variable.operands[0] >= bound)
+        {
+            continue;
+        }
+
+        SpvId const& pointer = ids[variable.operands[0]];
+
+        if(pointer.opcode != spv::OpTypePointer || pointer.operands.size() < 2 || pointer.operands[1] >= bound)
+        {
+            continue;
+        }
+
+        uint32_t const storageClass = variable.operands[1];
+        uint32_t typeId = pointer.operands[1];
+
+        if(storageClass == spv::PushConstant)
+        {
+            reflection.pushConstantSize = std::max(reflection.pushConstantSize, GetTypeSize(ids, typeId, 0));
+            continue;
+        }
+
+        if(storageClass != spv::UniformConstant && storageClass != spv::Uniform && storageClass != spv::StorageBuffer)
+        {
+            continue;
+        }
+
+        if(variable.set == UINT32_MAX || variable.binding == UINT32_MAX)
+        {
+            continue;
+        }
+
+        ShaderReflection::Binding binding;
+        binding.set = variable.set;
+        binding.binding = variable.binding;
+        binding.count = 1;
+
+        // Arrays of descriptors
+        if(ids[typeId].opcode == spv::OpTypeArray && ids[typeId].operands.size() > 1 && ids[typeId].operands[1] < bound)
+        {
+            SpvId const& length = ids[ids[typeId].operands[1]];
+            binding.count = length.operands.size() > 1 ? length.operands[1] : 1;
+            typeId = ids[typeId].operands[0];
+        }
+        else if(ids[typeId].opcode == spv::OpTypeRuntimeArray && !ids[typeId].operands.empty())
+        {
+            binding.count = 0;
+            typeId = ids[typeId].operands[0];
+        }
+
+        if(typeId >= bound)
+        {
+            continue;
+        }
+
+        SpvId const& type = ids[typeId];
+
+        switch(type.opcode)
+        {
+            case spv::OpTypeStruct:
+                binding.type = storageClass == spv::StorageBuffer || type.isBufferBlock ?
+                    vk::DescriptorType::eStorageBuffer : vk::DescriptorType::eUniformBuffer;
+                break;
+            case spv::OpTypeSampledImage:
+                binding.type = vk::DescriptorType::eCombinedImageSampler;
+                break;
+            case spv::OpTypeSampler:
+                binding.type = vk::DescriptorType::eSampler;
+                break;
+            case spv::OpTypeImage:
+            {
+                // Operands are sampled type, dim, depth, arrayed, multisampled and sampled
+                if(type.operands.size() < 6)
+                {
+                    continue;
+                }
+
+                uint32_t const dim = type.operands[1];
+                bool const isStorage = type.operands[5] == 2;
+
+                if(dim == spv::DimBuffer)
+                {
+                    binding.type = isStorage ? vk::DescriptorType::eStorageTexelBuffer : vk::DescriptorType::eUniformTexelBuffer;
+                }
+                else if(dim == spv::DimSubpassData)
+                {
+                    binding.type = vk::DescriptorType::eInputAttachment;
+                }
+                else
+                {
+                    binding.type = isStorage ? vk::DescriptorType::eStorageImage : vk::DescriptorType::eSampledImage;
+                }
+                break;
+            }
+            default:
+                continue;
+        }
+
+        reflection.bindings.push_back(binding);
+    }
+
+    std::sort(reflection.bindings.begin(), reflection.bindings.end(),
+        [](ShaderReflection::Binding const& lhs, ShaderReflection::Binding const& rhs)
+        {
+            return std::tie(lhs.set, lhs.binding) < std::tie(rhs.set, rhs.binding);
+        });
+
+    return true;
+}
+}
+}
+}
@@ -5,12 +5,12 @@
 */
 
 #include <unicorn/video/vulkan/ShaderProgram.hpp>
+#include <unicorn/video/vulkan/ShaderModuleCache.hpp>
 #include <unicorn/video/Mesh.hpp>
+#include <unicorn/video/Material.hpp>
 
 #include <unicorn/utility/InternalLoggers.hpp>
 
-#include <mule/asset/SimpleStorage.hpp>
-
 namespace unicorn
 {
     namespace video
@@ -19,25 +19,32 @@ namespace unicorn
         {
             ShaderProgram::ShaderProgram(vk::Device device, const std::string& vertShader, const std::string& fragShader)
                 : m_isCreated(false), m_device(device)
+                , m_pVertReflection(nullptr), m_pFragReflection(nullptr)
             {
-                using namespace mule::asset;
+                ShaderModuleCache& cache = ShaderModuleCache::Instance();
+
+                ShaderModuleCache::Module const vertModule = cache.Acquire(m_device, vertShader);
+                ShaderModuleCache::Module const fragModule = cache.Acquire(m_device, fragShader);
 
-                SimpleStorage& storage = SimpleStorage::Instance();
-                Handler simpleVertShaderHandler = storage.Get(vertShader);
-                Handler simpleFragShaderHandler = storage.Get(fragShader);
+                m_vertShaderModule = vertModule.module;
+                m_fragShaderModule = fragModule.module;
 
-                if (!simpleVertShaderHandler.IsValid() || !simpleFragShaderHandler.IsValid())
+                if (!m_vertShaderModule || !m_fragShaderModule)
                 {
-                    LOG_VULKAN->Error("Can't find shaders!");
+                    LOG_VULKAN->Error("Can't create shader module!");
+                    DestroyShaderModules();
                     return;
                 }
 
-                bool shadersCreatedFailed = !CreateShaderModule(simpleVertShaderHandler.GetContent().GetBuffer(), m_vertShaderModule) ||
-                    !CreateShaderModule(simpleFragShaderHandler.GetContent().GetBuffer(), m_fragShaderModule);
+                m_pVertReflection = vertModule.pReflection;
+                m_pFragReflection = fragModule.pReflection;
 
-                if (shadersCreatedFailed)
+                // Pipelines are created with push constant range of DrawParameters
+                if (m_pVertReflection->pushConstantSize > sizeof(DrawParameters) ||
+                    m_pFragReflection->pushConstantSize > sizeof(DrawParameters))
                 {
-                    LOG_VULKAN->Error("Can't create shader module!");
+                    LOG_VULKAN->Error("Push constants of shaders {} and {} don't fit into DrawParameters!", vertShader, fragShader);
+                    DestroyShaderModules();
                     return;
                 }
 
@@ -51,7 +58,25 @@ namespace unicorn
                 fragShaderStageInfo.module = m_fragShaderModule;
                 fragShaderStageInfo.pName = "main";
 
-                m_shaderStages = { { vertShaderStageInfo, fragShaderStageInfo } };
+                // Both stages read shading from specialization constant 0
+                m_shadingMapEntry.constantID = 0;
+                m_shadingMapEntry.offset = 0;
+                m_shadingMapEntry.size = sizeof(uint32_t);
+
+                for (uint32_t shading = 0; shading < s_shadingsCount; ++shading)
+                {
+                    m_shadingConstants[shading] = shading;
+
+                    m_specializationInfos[shading].mapEntryCount = 1;
+                    m_specializationInfos[shading].pMapEntries = &m_shadingMapEntry;
+                    m_specializationInfos[shading].dataSize = sizeof(uint32_t);
+                    m_specializationInfos[shading].pData = &m_shadingConstants[shading];
+
+                    vertShaderStageInfo.pSpecializationInfo = &m_specializationInfos[shading];
+                    fragShaderStageInfo.pSpecializationInfo = &m_specializationInfos[shading];
+
+                    m_shaderStages[shading] = { { vertShaderStageInfo, fragShaderStageInfo } };
+                }
 
                 CreateBindingDescription();
                 CreateAttributeDescription();
@@ -62,9 +87,9 @@ namespace unicorn
 
             void ShaderProgram::CreateBindingDescription()
             {
-                m_bindingDescription.setBinding(0);
-                m_bindingDescription.setStride(sizeof(Vertex));
-                m_bindingDescription.setInputRate(vk::VertexInputRate::eVertex);
+                m_bindingDescription.at(0).setBinding(0);
+                m_bindingDescription.at(0).setStride(sizeof(Vertex));
+                m_bindingDescription.at(0).setInputRate(vk::VertexInputRate::eVertex);
             }
 
             void ShaderProgram::CreateAttributeDescription()
@@ -77,21 +102,32 @@ namespace unicorn
                 //Texture coordinates
                 m_attributeDescription.at(1).setBinding(0);
                 m_attributeDescription.at(1).setLocation(1);
-                m_attributeDescription.at(1).setFormat(vk::Format::eR32G32B32Sfloat);
+                m_attributeDescription.at(1).setFormat(vk::Format::eR32G32Sfloat);
                 m_attributeDescription.at(1).setOffset(offsetof(Vertex, tc));
             }
 
             void ShaderProgram::CreateVertexInputInfo()
             {
-                m_vertexInputInfo.vertexBindingDescriptionCount = 1;
+                m_vertexInputInfo.vertexBindingDescriptionCount = static_cast<uint32_t>(m_bindingDescription.size());
                 m_vertexInputInfo.vertexAttributeDescriptionCount = static_cast<uint32_t>(m_attributeDescription.size());
-                m_vertexInputInfo.pVertexBindingDescriptions = &m_bindingDescription;
+                m_vertexInputInfo.pVertexBindingDescriptions = m_bindingDescription.data();
                 m_vertexInputInfo.pVertexAttributeDescriptions = m_attributeDescription.data();
             }
 
-            vk::PipelineShaderStageCreateInfo* ShaderProgram::GetShaderStageInfoData()
+            vk::PipelineShaderStageCreateInfo* ShaderProgram::GetShaderStageInfoData(MaterialShading shading)
             {
-                return m_shaderStages.data();
+                return m_shaderStages.at(static_cast<uint32_t>(shading)).data();
+            }
+
+            MaterialShading ShaderProgram::SelectShading(Material const& material)
+            {
+                if (material.IsColored())
+                {
+                    return MaterialShading::Colored;
+                }
+
+                // Sprite covering whole texture doesn't change texture coordinates
+                return material.GetNormalizedSpriteArea() == glm::vec4(0, 0, 1, 1) ? MaterialShading::Textured : MaterialShading::Sprite;
             }
 
             vk::PipelineVertexInputStateCreateInfo ShaderProgram::GetVertexInputInfo()
@@ -104,41 +140,24 @@ namespace unicorn
                 return m_isCreated;
             }
 
-            bool ShaderProgram::CreateShaderModule(const std::vector<uint8_t>& code, vk::ShaderModule& shaderModule)
-            {
-                vk::Result result;
-                vk::ShaderModuleCreateInfo createInfo;
-                if (code.size() % sizeof(uint32_t) != 0)
-                {
-                    LOG_VULKAN->Error("Shader code size is not multiple of sizeof(uint32_t), look at VkShaderModuleCreateInfo(3) Manual Page.");
-                    return false;
-                }
-                createInfo.codeSize = code.size();
-                createInfo.pCode = reinterpret_cast<const uint32_t*>(code.data());
-
-                result = m_device.createShaderModule(&createInfo, {}, &shaderModule);
-
-                if (result != vk::Result::eSuccess)
-                {
-                    LOG_VULKAN->Error("Failed to create shader module!");
-                    return false;
-                }
-
-                return true;
-            }
-
             void ShaderProgram::DestroyShaderModules()
             {
+                ShaderModuleCache& cache = ShaderModuleCache::Instance();
+
                 if (m_vertShaderModule)
                 {
-                    m_device.destroyShaderModule(m_vertShaderModule);
+                    cache.Release(m_device, m_vertShaderModule);
                     m_vertShaderModule = nullptr;
                 }
                 if (m_fragShaderModule)
                 {
-                    m_device.destroyShaderModule(m_fragShaderModule);
+                    cache.Release(m_device, m_fragShaderModule);
                     m_fragShaderModule = nullptr;
                 }
+
+                m_pVertReflection = nullptr;
+                m_pFragReflection = nullptr;
+                m_isCreated = false;
             }
         }
     }
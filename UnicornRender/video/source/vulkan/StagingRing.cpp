@@ -0,0 +1,115 @@
+/*
+* Copyright (C) 2017 by Godlike
+* This code is licensed under the MIT license (MIT)
+* (http://opensource.org/licenses/MIT)
+*/
+
+#include <unicorn/video/vulkan/StagingRing.hpp>
+
+#include <unicorn/utility/InternalLoggers.hpp>
+#include <unicorn/utility/Memory.hpp>
+
+#include <algorithm>
+
+namespace unicorn
+{
+namespace video
+{
+namespace vulkan
+{
+const vk::DeviceSize StagingRing::s_alignment = 16;
+
+StagingRing::StagingRing()
+    : m_size(0)
+    , m_head(0)
+    , m_tail(0)
+{
+}
+
+StagingRing::~StagingRing()
+{
+    Destroy();
+}
+
+bool StagingRing::Create(vk::PhysicalDevice physicalDevice, vk::Device device, vk::DeviceSize size)
+{
+    Destroy();
+
+    // Ring size is a multiple of alignment, so aligned positions are aligned offsets
+    size = utility::AlignUp(std::max(size, s_alignment), s_alignment);
+
+    if(!m_buffer.Create(physicalDevice, device, vk::BufferUsageFlagBits::eTransferSrc, MemoryUsage::Upload, static_cast<size_t>(size)))
+    {
+        LOG_VULKAN->Error("Can't create staging ring of {} bytes!", size);
+        return false;
+    }
+
+    m_buffer.Map();
+
+    if(!m_buffer.GetMappedMemory())
+    {
+        LOG_VULKAN->Error("Staging ring memory is not host visible!");
+        m_buffer.Destroy();
+        return false;
+    }
+
+    m_size = size;
+    m_head = 0;
+    m_tail = 0;
+
+    return true;
+}
+
+void StagingRing::Destroy()
+{
+    m_buffer.Destroy();
+    m_size = 0;
+    m_head = 0;
+    m_tail = 0;
+}
+
+bool StagingRing::Write(void const* pData, vk::DeviceSize size, vk::DeviceSize& offset)
+{
+    if(!IsCreated() || size > m_size)
+    {
+        return false;
+    }
+
+    uint64_t position = utility::AlignUp(m_head, s_alignment);
+    vk::DeviceSize ringOffset = position % m_size;
+
+    if(ringOffset + size > m_size)
+    {
+        // Range can't be split, the rest of the ring is skipped
+        position += m_size - ringOffset;
+        ringOffset = 0;
+    }
+
+    if(position + size - m_tail > m_size)
+    {
+        return false;
+    }
+
+    m_buffer.Write(pData, static_cast<size_t>(size), static_cast<size_t>(ringOffset));
+
+    m_head = position + size;
+    offset = ringOffset;
+
+    return true;
+}
+
+void StagingRing::Flush() const
+{
+    if(IsCreated())
+    {
+        m_buffer.Flush();
+    }
+}
+
+void StagingRing::Release(uint64_t position)
+{
+    m_tail = std::max(m_tail, std::min(position, m_head));
+}
+}
+}
+}
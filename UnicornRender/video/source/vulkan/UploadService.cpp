@@ -0,0 +1,502 @@
+/*
+* Copyright (C) 2017 by Godlike
+* This code is licensed under the MIT license (MIT)
+* (http://opensource.org/licenses/MIT)
+*/
+
+#include <unicorn/video/vulkan/UploadService.hpp>
+#include <unicorn/video/vulkan/Buffer.hpp>
+#include <unicorn/video/vulkan/Image.hpp>
+
+#include <unicorn/utility/InternalLoggers.hpp>
+
+#include <limits>
+
+namespace unicorn
+{
+namespace video
+{
+namespace vulkan
+{
+namespace
+{
+//! Stages of graphics pipeline which read uploaded data
+vk::PipelineStageFlags const s_consumerStages = vk::PipelineStageFlagBits::eVertexInput
+    | vk::PipelineStageFlagBits::eVertexShader
+    | vk::PipelineStageFlagBits::eFragmentShader;
+
+//! Accesses of graphics pipeline which read uploaded buffers
+vk::AccessFlags const s_bufferConsumerAccess = vk::AccessFlagBits::eVertexAttributeRead
+    | vk::AccessFlagBits::eIndexRead
+    | vk::AccessFlagBits::eUniformRead
+    | vk::AccessFlagBits::eShaderRead;
+}
+
+const uint64_t UploadService::s_completeToken;
+
+vk::PipelineStageFlags UploadService::GetConsumerStages()
+{
+    return s_consumerStages;
+}
+
+UploadService::UploadService(vk::PhysicalDevice physicalDevice,
+                             vk::Device device,
+                             uint32_t graphicsFamily,
+                             uint32_t transferFamily,
+                             vk::Queue transferQueue,
+                             vk::DeviceSize stagingBufferSize)
+    : m_physicalDevice(physicalDevice)
+    , m_device(device)
+    , m_graphicsFamily(graphicsFamily)
+    , m_transferFamily(transferFamily)
+    , m_transferQueue(transferQueue)
+    , m_stagingBufferSize(stagingBufferSize)
+    , m_pRecordingBatch(nullptr)
+    , m_nextToken(s_completeToken + 1)
+    , m_flushedToken(s_completeToken)
+{
+}
+
+UploadService::~UploadService()
+{
+    if(m_pRecordingBatch)
+    {
+        for(Buffer* pStagingBuffer : m_pRecordingBatch->stagingBuffers)
+        {
+            delete pStagingBuffer;
+        }
+
+        m_pRecordingBatch->stagingBuffers.clear();
+        m_freeBatches.push_back(m_pRecordingBatch);
+        m_pRecordingBatch = nullptr;
+    }
+
+    while(!m_submittedBatches.empty())
+    {
+        Recycle(m_submittedBatches.front());
+        m_submittedBatches.pop_front();
+    }
+
+    for(Batch* pBatch : m_freeBatches)
+    {
+        m_device.destroyFence(pBatch->fence);
+        m_device.destroySemaphore(pBatch->semaphore);
+        delete pBatch;
+    }
+
+    m_freeBatches.clear();
+
+    m_stagingRing.Destroy();
+
+    if(m_commandPool)
+    {
+        // Command buffers are freed together with their pool
+        m_device.destroyCommandPool(m_commandPool);
+        m_commandPool = nullptr;
+    }
+}
+
+bool UploadService::Init()
+{
+    vk::CommandPoolCreateInfo poolInfo;
+    poolInfo.flags = vk::CommandPoolCreateFlagBits::eResetCommandBuffer;
+    poolInfo.queueFamilyIndex = m_transferFamily;
+
+    if(m_device.createCommandPool(&poolInfo, {}, &m_commandPool) != vk::Result::eSuccess)
+    {
+        LOG_VULKAN->Error("Failed to create upload command pool!");
+        return false;
+    }
+
+    if(!m_stagingRing.Create(m_physicalDevice, m_device, m_stagingBufferSize))
+    {
+        return false;
+    }
+
+    LOG_VULKAN->Info("Uploads use {} transfer queue family {} and staging ring of {} bytes.",
+        IsOwnershipTransferred() ? "dedicated" : "graphics", m_transferFamily, m_stagingRing.GetSize());
+
+    return true;
+}
+
+uint64_t UploadService::UploadBuffer(void const* pData, size_t size, Buffer const& dstBuffer, vk::DeviceSize dstOffset)
+{
+    Batch* pBatch = GetRecordingBatch();
+    vk::Buffer stagingBuffer;
+    vk::DeviceSize stagingOffset = 0;
+
+    if(!pBatch || !Stage(*pBatch, pData, size, stagingBuffer, stagingOffset))
+    {
+        LOG_VULKAN->Error("Can't upload {} bytes to buffer!", size);
+        return s_completeToken;
+    }
+
+    vk::BufferCopy copyRegion;
+    copyRegion.srcOffset = stagingOffset;
+    copyRegion.dstOffset = dstOffset;
+    copyRegion.size = size;
+
+    pBatch->commandBuffer.copyBuffer(stagingBuffer, dstBuffer.GetVkBuffer(), 1, &copyRegion);
+
+    if(IsOwnershipTransferred())
+    {
+        vk::BufferMemoryBarrier barrier;
+        barrier.srcAccessMask = vk::AccessFlagBits::eTransferWrite;
+        barrier.srcQueueFamilyIndex = m_transferFamily;
+        barrier.dstQueueFamilyIndex = m_graphicsFamily;
+        barrier.buffer = dstBuffer.GetVkBuffer();
+        barrier.offset = dstOffset;
+        barrier.size = size;
+
+        pBatch->commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer,
+                                              vk::PipelineStageFlagBits::eBottomOfPipe,
+                                              {}, 0,
+                                              nullptr, 1,
+                                              &barrier, 0,
+                                              nullptr);
+
+        barrier.srcAccessMask = vk::AccessFlags();
+        barrier.dstAccessMask = s_bufferConsumerAccess;
+        m_pendingBufferBarriers.push_back(barrier);
+    }
+
+    return pBatch->token;
+}
+
+uint64_t UploadService::UploadImage(void const* pData, size_t size, Image const& dstImage)
+{
+    Batch* pBatch = GetRecordingBatch();
+    vk::Buffer stagingBuffer;
+    vk::DeviceSize stagingOffset = 0;
+
+    if(!pBatch || !Stage(*pBatch, pData, size, stagingBuffer, stagingOffset))
+    {
+        LOG_VULKAN->Error("Can't upload {} bytes to image!", size);
+        return s_completeToken;
+    }
+
+    vk::ImageMemoryBarrier barrier;
+    barrier.oldLayout = vk::ImageLayout::eUndefined;
+    barrier.newLayout = vk::ImageLayout::eTransferDstOptimal;
+    barrier.dstAccessMask = vk::AccessFlagBits::eTransferWrite;
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.image = dstImage.GetVkImage();
+    barrier.subresourceRange.aspectMask = vk::ImageAspectFlagBits::eColor;
+    barrier.subresourceRange.baseMipLevel = 0;
+    barrier.subresourceRange.levelCount = 1;
+    barrier.subresourceRange.baseArrayLayer = 0;
+    barrier.subresourceRange.layerCount = 1;
+
+    pBatch->commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eTopOfPipe,
+                                          vk::PipelineStageFlagBits::eTransfer,
+                                          {}, 0,
+                                          nullptr, 0,
+                                          nullptr, 1,
+                                          &barrier);
+
+    vk::BufferImageCopy region;
+    region.bufferOffset = stagingOffset;
+    region.bufferRowLength = 0;
+    region.bufferImageHeight = 0;
+    region.imageSubresource.aspectMask = vk::ImageAspectFlagBits::eColor;
+    region.imageSubresource.mipLevel = 0;
+    region.imageSubresource.baseArrayLayer = 0;
+    region.imageSubresource.layerCount = 1;
+    region.imageOffset = vk::Offset3D{0, 0, 0};
+    region.imageExtent = vk::Extent3D{dstImage.GetWidth(), dstImage.GetHeight(), 1};
+
+    pBatch->commandBuffer.copyBufferToImage(stagingBuffer, dstImage.GetVkImage(),
+                                            vk::ImageLayout::eTransferDstOptimal, 1, &region);
+
+    barrier.oldLayout = vk::ImageLayout::eTransferDstOptimal;
+    barrier.newLayout = vk::ImageLayout::eShaderReadOnlyOptimal;
+    barrier.srcAccessMask = vk::AccessFlagBits::eTransferWrite;
+
+    if(IsOwnershipTransferred())
+    {
+        // Layout transition is a part of both release and acquire barriers
+        barrier.dstAccessMask = vk::AccessFlags();
+        barrier.srcQueueFamilyIndex = m_transferFamily;
+        barrier.dstQueueFamilyIndex = m_graphicsFamily;
+
+        pBatch->commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer,
+                                              vk::PipelineStageFlagBits::eBottomOfPipe,
+                                              {}, 0,
+                                              nullptr, 0,
+                                              nullptr, 1,
+                                              &barrier);
+
+        barrier.srcAccessMask = vk::AccessFlags();
+        barrier.dstAccessMask = vk::AccessFlagBits::eShaderRead;
+        m_pendingImageBarriers.push_back(barrier);
+    }
+    else
+    {
+        barrier.dstAccessMask = vk::AccessFlagBits::eShaderRead;
+
+        pBatch->commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer,
+                                              vk::PipelineStageFlagBits::eFragmentShader,
+                                              {}, 0,
+                                              nullptr, 0,
+                                              nullptr, 1,
+                                              &barrier);
+    }
+
+    return pBatch->token;
+}
+
+vk::Semaphore UploadService::Flush(uint64_t& token)
+{
+    token = s_completeToken;
+
+    vk::Semaphore semaphore;
+
+    if(m_pRecordingBatch)
+    {
+        Batch* pBatch = m_pRecordingBatch;
+
+        // Same queue executes uploads and rendering in submission order
+        bool const signalSemaphore = IsOwnershipTransferred();
+
+        if(Submit(signalSemaphore))
+        {
+            token = pBatch->token;
+            semaphore = signalSemaphore ? pBatch->semaphore : nullptr;
+        }
+    }
+
+    // Frame submitted after the flush has recorded all acquire barriers
+    m_acquireBufferBarriers.clear();
+    m_acquireImageBarriers.clear();
+
+    return semaphore;
+}
+
+void UploadService::RecordAcquireBarriers(vk::CommandBuffer commandBuffer) const
+{
+    // Render submission waits on the batch semaphore at consumer stages, which chains the barriers after the batch
+    auto const recordBarriers = [commandBuffer](std::vector<vk::BufferMemoryBarrier> const& bufferBarriers,
+                                                std::vector<vk::ImageMemoryBarrier> const& imageBarriers)
+    {
+        if(bufferBarriers.empty() && imageBarriers.empty())
+        {
+            return;
+        }
+
+        commandBuffer.pipelineBarrier(s_consumerStages,
+                                      s_consumerStages,
+                                      {}, 0,
+                                      nullptr, static_cast<uint32_t>(bufferBarriers.size()),
+                                      bufferBarriers.data(), static_cast<uint32_t>(imageBarriers.size()),
+                                      imageBarriers.data());
+    };
+
+    // Barriers are kept until Flush(), so a frame which fails to be submitted doesn't lose them
+    recordBarriers(m_acquireBufferBarriers, m_acquireImageBarriers);
+    recordBarriers(m_pendingBufferBarriers, m_pendingImageBarriers);
+}
+
+void UploadService::Release(uint64_t token)
+{
+    while(!m_submittedBatches.empty() && m_submittedBatches.front()->token <= token)
+    {
+        Recycle(m_submittedBatches.front());
+        m_submittedBatches.pop_front();
+    }
+}
+
+void UploadService::Finish()
+{
+    if(!m_pRecordingBatch)
+    {
+        return;
+    }
+
+    Batch* pBatch = m_pRecordingBatch;
+
+    if(Submit(false))
+    {
+        // Recycling the batch releases staging ring up to its end, so every
+        // earlier batch has to be finished as well
+        m_transferQueue.waitIdle();
+
+        m_submittedBatches.pop_back();
+        Recycle(pBatch);
+    }
+}
+
+UploadService::Batch* UploadService::GetRecordingBatch()
+{
+    if(m_pRecordingBatch)
+    {
+        return m_pRecordingBatch;
+    }
+
+    Batch* pBatch = nullptr;
+
+    if(!m_freeBatches.empty())
+    {
+        pBatch = m_freeBatches.back();
+        m_freeBatches.pop_back();
+    }
+    else
+    {
+        pBatch = new Batch;
+
+        vk::CommandBufferAllocateInfo allocInfo;
+        allocInfo.commandPool = m_commandPool;
+        allocInfo.level = vk::CommandBufferLevel::ePrimary;
+        allocInfo.commandBufferCount = 1;
+
+        vk::SemaphoreCreateInfo semaphoreInfo;
+        vk::FenceCreateInfo fenceInfo;
+
+        if(m_device.allocateCommandBuffers(&allocInfo, &pBatch->commandBuffer) != vk::Result::eSuccess ||
+            m_device.createFence(&fenceInfo, {}, &pBatch->fence) != vk::Result::eSuccess ||
+            m_device.createSemaphore(&semaphoreInfo, {}, &pBatch->semaphore) != vk::Result::eSuccess)
+        {
+            LOG_VULKAN->Error("Failed to create upload batch!");
+
+            // Partially created batch is destroyed like a free one
+            m_freeBatches.push_back(pBatch);
+
+            return nullptr;
+        }
+    }
+
+    vk::CommandBufferBeginInfo beginInfo;
+    beginInfo.flags = vk::CommandBufferUsageFlagBits::eOneTimeSubmit;
+
+    if(pBatch->commandBuffer.begin(&beginInfo) != vk::Result::eSuccess)
+    {
+        LOG_VULKAN->Error("Failed to begin upload command buffer!");
+        m_freeBatches.push_back(pBatch);
+        return nullptr;
+    }
+
+    pBatch->token = m_nextToken++;
+    m_pRecordingBatch = pBatch;
+
+    return pBatch;
+}
+
+bool UploadService::Stage(Batch& batch, void const* pData, size_t size, vk::Buffer& buffer, vk::DeviceSize& offset)
+{
+    // Large uploads would leave too little space for the following frames
+    if(size <= m_stagingRing.GetSize() / 2 && m_stagingRing.Write(pData, size, offset))
+    {
+        buffer = m_stagingRing.GetVkBuffer();
+        return true;
+    }
+
+    Buffer* pStagingBuffer = new Buffer;
+
+    if(!pStagingBuffer->Create(m_physicalDevice, m_device, vk::BufferUsageFlagBits::eTransferSrc, MemoryUsage::Upload, size))
+    {
+        delete pStagingBuffer;
+        return false;
+    }
+
+    pStagingBuffer->Map();
+    pStagingBuffer->Write(pData);
+    pStagingBuffer->Flush();
+
+    batch.stagingBuffers.push_back(pStagingBuffer);
+
+    buffer = pStagingBuffer->GetVkBuffer();
+    offset = 0;
+
+    return true;
+}
+
+bool UploadService::Submit(bool signalSemaphore)
+{
+    Batch* pBatch = m_pRecordingBatch;
+    m_pRecordingBatch = nullptr;
+
+    if(!IsOwnershipTransferred())
+    {
+        // Single barrier makes all buffer uploads visible to following submissions on the queue
+        vk::MemoryBarrier barrier;
+        barrier.srcAccessMask = vk::AccessFlagBits::eTransferWrite;
+        barrier.dstAccessMask = s_bufferConsumerAccess;
+
+        pBatch->commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer,
+                                              s_consumerStages,
+                                              {}, 1,
+                                              &barrier, 0,
+                                              nullptr, 0,
+                                              nullptr);
+    }
+
+    m_stagingRing.Flush();
+    pBatch->stagingRingEnd = m_stagingRing.GetHead();
+
+    vk::Result result = pBatch->commandBuffer.end();
+
+    if(result == vk::Result::eSuccess)
+    {
+        vk::SubmitInfo submitInfo;
+        submitInfo.commandBufferCount = 1;
+        submitInfo.pCommandBuffers = &pBatch->commandBuffer;
+
+        if(signalSemaphore)
+        {
+            submitInfo.signalSemaphoreCount = 1;
+            submitInfo.pSignalSemaphores = &pBatch->semaphore;
+        }
+
+        result = m_transferQueue.submit(1, &submitInfo, pBatch->fence);
+    }
+
+    if(result != vk::Result::eSuccess)
+    {
+        LOG_VULKAN->Error("Failed to submit uploads!");
+
+        for(Buffer* pStagingBuffer : pBatch->stagingBuffers)
+        {
+            delete pStagingBuffer;
+        }
+
+        pBatch->stagingBuffers.clear();
+        pBatch->commandBuffer.reset(vk::CommandBufferResetFlags());
+        m_freeBatches.push_back(pBatch);
+
+        m_pendingBufferBarriers.clear();
+        m_pendingImageBarriers.clear();
+
+        return false;
+    }
+
+    m_submittedBatches.push_back(pBatch);
+    m_flushedToken = pBatch->token;
+
+    m_acquireBufferBarriers.insert(m_acquireBufferBarriers.end(), m_pendingBufferBarriers.begin(), m_pendingBufferBarriers.end());
+    m_acquireImageBarriers.insert(m_acquireImageBarriers.end(), m_pendingImageBarriers.begin(), m_pendingImageBarriers.end());
+    m_pendingBufferBarriers.clear();
+    m_pendingImageBarriers.clear();
+
+    return true;
+}
+
+void UploadService::Recycle(Batch* pBatch)
+{
+    m_device.waitForFences(1, &pBatch->fence, VK_TRUE, std::numeric_limits<uint64_t>::max());
+    m_device.resetFences(1, &pBatch->fence);
+
+    m_stagingRing.Release(pBatch->stagingRingEnd);
+
+    for(Buffer* pStagingBuffer : pBatch->stagingBuffers)
+    {
+        delete pStagingBuffer;
+    }
+
+    pBatch->stagingBuffers.clear();
+    pBatch->commandBuffer.reset(vk::CommandBufferResetFlags());
+
+    m_freeBatches.push_back(pBatch);
+}
+}
+}
+}
@@ -5,6 +5,7 @@
 */
 
 #include <unicorn/video/vulkan/VkMesh.hpp>
+#include <unicorn/video/vulkan/UploadService.hpp>
 #include <unicorn/video/Material.hpp>
 
 namespace unicorn
@@ -13,87 +14,103 @@ namespace video
 {
 namespace vulkan
 {
-VkMesh::VkMesh(vk::Device device, vk::PhysicalDevice physicalDevice, vk::CommandPool pool, vk::Queue queue, Mesh& mesh)
+VkMesh::VkMesh(UploadService& uploadService, GeometryArena& geometryArena, Mesh& mesh)
     : m_valid(false)
-    , m_device(device)
-    , m_physicalDevice(physicalDevice)
-    , m_pool(pool)
-    , m_queue(queue)
-    , m_mesh(mesh)
+    , m_uploadService(uploadService)
+    , m_geometryArena(geometryArena)
+    , m_uploadToken(UploadService::s_completeToken)
+    , m_instanceSlot(0)
+    , m_pMesh(&mesh)
 {
-    m_mesh.MaterialUpdated.connect(this, &VkMesh::OnMaterialUpdated);
-    m_mesh.VerticesUpdated.connect(this, &VkMesh::AllocateOnGPU);
+    m_pMesh->MaterialUpdated.connect(this, &VkMesh::OnMaterialUpdated);
+    m_pMesh->VerticesUpdated.connect(this, &VkMesh::AllocateOnGPU);
+    m_pMesh->TransformUpdated.connect(this, &VkMesh::OnTransformUpdated);
 }
 
 VkMesh::~VkMesh()
 {
     DeallocateOnGPU();
-    m_mesh.VerticesUpdated.disconnect(this, &VkMesh::AllocateOnGPU);
-    m_mesh.MaterialUpdated.disconnect(this, &VkMesh::OnMaterialUpdated);
+    Detach();
 }
 
 bool VkMesh::operator==(const Mesh& mesh) const
 {
-    return &mesh == &m_mesh;
+    return &mesh == m_pMesh;
 }
 
 const glm::mat4& VkMesh::GetModelMatrix() const
 {
-    return m_mesh.GetModelMatrix();
+    return m_pMesh->GetModelMatrix();
 }
 
 Mesh const& VkMesh::GetMesh() const
 {
-    return m_mesh;
+    return *m_pMesh;
 }
 
-void VkMesh::AllocateOnGPU()
+glm::vec4 VkMesh::GetBoundingSphere() const
 {
-    m_vertexBuffer.Destroy();
-    m_indexBuffer.Destroy();
-    Buffer stagingBuffer;
-    //Vertexes filling
-    auto size = sizeof(m_mesh.GetVertices()[0]) * m_mesh.GetVertices().size();
-    stagingBuffer.Create(m_physicalDevice, m_device, vk::BufferUsageFlagBits::eTransferSrc, vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent, size);
-    m_vertexBuffer.Create(m_physicalDevice, m_device, vk::BufferUsageFlagBits::eVertexBuffer | vk::BufferUsageFlagBits::eTransferDst, vk::MemoryPropertyFlagBits::eDeviceLocal, size);
+    BoundingSphere const& sphere = m_pMesh->GetLocalBoundingSphere();
 
-    stagingBuffer.Map();
-    stagingBuffer.Write(m_mesh.GetVertices().data());
-    stagingBuffer.CopyToBuffer(m_pool, m_queue, m_vertexBuffer, m_vertexBuffer.GetSize());
-    stagingBuffer.Destroy();
-    //Indexes filling
-    size = sizeof(m_mesh.GetIndices()[0]) * m_mesh.GetIndices().size();
+    return glm::vec4(sphere.center, sphere.radius);
+}
 
-    stagingBuffer.Create(m_physicalDevice, m_device, vk::BufferUsageFlagBits::eTransferSrc, vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent, size);
-    stagingBuffer.Map();
-    m_indexBuffer.Create(m_physicalDevice, m_device, vk::BufferUsageFlagBits::eIndexBuffer | vk::BufferUsageFlagBits::eTransferDst, vk::MemoryPropertyFlagBits::eDeviceLocal, size);
-    stagingBuffer.Write(m_mesh.GetIndices().data());
-    stagingBuffer.CopyToBuffer(m_pool, m_queue, m_indexBuffer, m_indexBuffer.GetSize());
-    stagingBuffer.Destroy();
+void VkMesh::AllocateOnGPU()
+{
+    if(m_valid)
+    {
+        // Previous ranges may still be used by frames in flight, renderer frees them once the frames are finished
+        GeometryRetired.emit(m_geometry);
+        m_geometry = GeometryArena::Allocation();
+    }
 
-    m_valid = true;
-    ReallocatedOnGpu.emit(this);
+    DeallocateOnGPU();
+
+    m_valid = m_geometryArena.Allocate(m_pMesh->GetVertices(), m_pMesh->GetIndices(), m_geometry, m_uploadToken);
 }
 
 void VkMesh::DeallocateOnGPU()
 {
-    m_vertexBuffer.Destroy();
-    m_indexBuffer.Destroy();
+    if(!m_uploadService.IsComplete(m_uploadToken))
+    {
+        // Recorded copies must not outlive their destination buffers
+        m_uploadService.Finish();
+    }
+
+    m_geometryArena.Free(m_geometry);
+    m_uploadToken = UploadService::s_completeToken;
+    m_valid = false;
+}
+
+void VkMesh::Detach()
+{
+    if(m_pMesh)
+    {
+        m_pMesh->VerticesUpdated.disconnect(this, &VkMesh::AllocateOnGPU);
+        m_pMesh->MaterialUpdated.disconnect(this, &VkMesh::OnMaterialUpdated);
+        m_pMesh->TransformUpdated.disconnect(this, &VkMesh::OnTransformUpdated);
+        m_pMesh = nullptr;
+    }
 }
 
 vk::Buffer VkMesh::GetVertexBuffer() const
 {
-    return m_vertexBuffer.GetVkBuffer();
+    return m_geometryArena.GetVertexBuffer(m_geometry.pageIndex);
 }
 
 vk::Buffer VkMesh::GetIndexBuffer() const
 {
-    return m_indexBuffer.GetVkBuffer();
+    return m_geometryArena.GetIndexBuffer(m_geometry.pageIndex);
 }
 
 void VkMesh::OnMaterialUpdated()
 {
-    MaterialUpdated.emit(&m_mesh, this);
+    MaterialUpdated.emit(m_pMesh, this);
+}
+
+void VkMesh::OnTransformUpdated()
+{
+    TransformUpdated.emit(this);
 }
 }
 }
@@ -5,6 +5,7 @@
 */
 
 #include <unicorn/video/vulkan/VkTexture.hpp>
+#include <unicorn/video/vulkan/UploadService.hpp>
 #include <unicorn/video/Texture.hpp>
 
 #include <unicorn/utility/InternalLoggers.hpp>
@@ -18,6 +19,8 @@ namespace vulkan
 VkTexture::VkTexture(vk::Device device)
     : m_device(device)
     , m_vkImage(nullptr)
+    , m_pUploadService(nullptr)
+    , m_uploadToken(UploadService::s_completeToken)
     , m_isInitialized(false)
 {
 }
@@ -28,26 +31,10 @@ const vk::DescriptorImageInfo& VkTexture::GetDescriptorImageInfo() const
 }
 
 bool VkTexture::Create(const vk::PhysicalDevice& physicalDevice, const vk::Device& device,
-                       const vk::CommandPool& commandPool, const vk::Queue& queue, Texture const& texture)
+                       UploadService& uploadService, Texture const& texture)
 {
     if(!m_isInitialized)
     {
-        Buffer imageStagingBuffer;
-        bool result = imageStagingBuffer.Create(
-            physicalDevice, device,
-            vk::BufferUsageFlagBits::eTransferSrc,
-            vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent,
-            texture.Size());
-        if(!result)
-        {
-            LOG_VULKAN->Error("Can't allocate staging buffer for texture - {}", texture.Path().c_str());
-            return false;
-        }
-
-        imageStagingBuffer.Map();
-        imageStagingBuffer.Write(texture.Data());
-        imageStagingBuffer.Unmap();
-
         m_vkImage = new Image(
             physicalDevice,
             device,
@@ -63,13 +50,15 @@ bool VkTexture::Create(const vk::PhysicalDevice& physicalDevice, const vk::Devic
             return false;
         }
 
-        m_vkImage->TransitionLayout(vk::Format::eR8G8B8A8Unorm, vk::ImageLayout::eUndefined,
-                                    vk::ImageLayout::eTransferDstOptimal, commandPool, queue);
-        imageStagingBuffer.CopyToImage(*m_vkImage, commandPool, queue);
-        m_vkImage->TransitionLayout(vk::Format::eR8G8B8A8Unorm, vk::ImageLayout::eTransferDstOptimal,
-                                    vk::ImageLayout::eShaderReadOnlyOptimal, commandPool, queue);
-
-        imageStagingBuffer.Destroy();
+        m_pUploadService = &uploadService;
+        m_uploadToken = uploadService.UploadImage(texture.Data(), texture.Size(), *m_vkImage);
+        if(m_uploadToken == UploadService::s_completeToken)
+        {
+            LOG_VULKAN->Error("Can't upload texture data - {}", texture.Path().c_str());
+            delete m_vkImage;
+            m_vkImage = nullptr;
+            return false;
+        }
 
         vk::SamplerCreateInfo samplerInfo;
         samplerInfo.setMagFilter(vk::Filter::eLinear);
@@ -88,11 +77,13 @@ bool VkTexture::Create(const vk::PhysicalDevice& physicalDevice, const vk::Devic
         samplerInfo.setMinLod(0.0f);
         samplerInfo.setMaxLod(0.0f);
 
-        result = device.createSampler(&samplerInfo, nullptr, &m_sampler) == vk::Result::eSuccess;
+        bool const result = device.createSampler(&samplerInfo, nullptr, &m_sampler) == vk::Result::eSuccess;
 
         if(!result)
         {
             LOG_VULKAN->Error("Can't create sampler for texture - {}", texture.Path().c_str());
+            // Recorded copy must not outlive its destination image
+            uploadService.Finish();
             delete m_vkImage;
             m_vkImage = nullptr;
             return false;
@@ -114,6 +105,12 @@ void VkTexture::Delete()
             m_device.destroySampler(m_sampler);
         }
 
+        if(!m_pUploadService->IsComplete(m_uploadToken))
+        {
+            // Recorded copy must not outlive its destination image
+            m_pUploadService->Finish();
+        }
+
         delete m_vkImage;
         m_vkImage = nullptr;
         m_isInitialized = false;
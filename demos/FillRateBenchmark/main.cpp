@@ -0,0 +1,211 @@
+/*
+* Copyright (C) 2017 by Godlike
+* This code is licensed under the MIT license (MIT)
+* (http://opensource.org/licenses/MIT)
+*/
+
+#include <unicorn/UnicornRender.hpp>
+#include <unicorn/video/Graphics.hpp>
+#include <unicorn/utility/Settings.hpp>
+#include <unicorn/video/Renderer.hpp>
+#include <unicorn/video/Primitives.hpp>
+#include <unicorn/video/Material.hpp>
+#include <unicorn/video/Texture.hpp>
+#include <unicorn/video/Camera.hpp>
+
+#include <mule/MuleUtilities.hpp>
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace
+{
+//! Size of rendered images
+uint32_t const s_imageWidth = 1920;
+uint32_t const s_imageHeight = 1080;
+
+//! Frames rendered after shader mode change before measuring
+uint32_t const s_warmupFrames = 30;
+
+//! Full screen layers drawn over each other
+uint32_t layersCount = 64;
+
+//! Frames measured for every shader mode
+uint32_t measuredFrames = 200;
+
+//! Scene of full screen quads sharing one material
+struct Scene
+{
+    std::string name;
+    std::shared_ptr<unicorn::video::Material> material;
+};
+
+/**
+ * @brief Creates full screen quads of the scene
+ *
+ * Camera matrices are identity, so quads of size two cover the whole image
+ */
+std::vector<unicorn::video::Mesh*> CreateLayers(Scene const& scene)
+{
+    std::vector<unicorn::video::Mesh*> meshes;
+    meshes.reserve(layersCount);
+
+    for(uint32_t i = 0; i < layersCount; ++i)
+    {
+        unicorn::video::Mesh* mesh = new unicorn::video::Mesh;
+        unicorn::video::Primitives::Quad(*mesh);
+        mesh->SetMaterial(scene.material);
+        mesh->Scale({ 2.0f, 2.0f, 1.0f });
+        mesh->SetTranslation({ 0.0f, 0.0f, 0.1f + 0.8f * static_cast<float>(i) / static_cast<float>(layersCount) });
+        mesh->UpdateTransformMatrix();
+
+        meshes.push_back(mesh);
+    }
+
+    return meshes;
+}
+
+//! Returns average duration of a frame in milliseconds
+double MeasureFrames(unicorn::video::Renderer& renderer, bool isShaderSpecialization)
+{
+    unicorn::utility::Settings::Instance().SetShaderSpecialization(isShaderSpecialization);
+
+    // Pipelines of the mode are created and frames in flight are filled
+    for(uint32_t i = 0; i < s_warmupFrames; ++i)
+    {
+        renderer.Render();
+    }
+
+    auto const start = std::chrono::steady_clock::now();
+
+    for(uint32_t i = 0; i < measuredFrames; ++i)
+    {
+        renderer.Render();
+    }
+
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / measuredFrames;
+}
+}
+
+/**
+ * @brief Compares fill rate of shaders branching per fragment with specialized shaders
+ *
+ * Every scene covers the image with layers of one material, so frames are
+ * bound by fragment shading. Frame time is measured on CPU, renderer
+ * waits for frames in flight, so it follows GPU time
+ *
+ * Usage: FillRateBenchmark [layers count] [measured frames]
+ */
+int main(int argc, char* argv[])
+{
+    if(argc > 1)
+    {
+        layersCount = static_cast<uint32_t>(std::max(std::atoi(argv[1]), 1));
+    }
+
+    if(argc > 2)
+    {
+        measuredFrames = static_cast<uint32_t>(std::max(std::atoi(argv[2]), 1));
+    }
+
+    mule::MuleUtilities::Initialize();
+
+    unicorn::utility::Settings& settings = unicorn::utility::Settings::Instance();
+    settings.SetApplicationName("FILL RATE BENCHMARK");
+    settings.SetHeadless(true);
+
+    auto* unicornRender = new unicorn::UnicornRender;
+
+    unicorn::video::Camera* pCamera = nullptr;
+
+    if(unicornRender->Init())
+    {
+        unicorn::video::Graphics* pGraphics = unicornRender->GetGraphics();
+
+        pCamera = new unicorn::video::Camera;
+        pCamera->view = glm::mat4(1.0f);
+        pCamera->projection = glm::mat4(1.0f);
+
+        unicorn::video::Renderer* pRenderer = pGraphics->SpawnHeadlessRenderer(s_imageWidth, s_imageHeight, *pCamera);
+        if(pRenderer == nullptr)
+        {
+            return -1;
+        }
+
+        // Every layer is shaded
+        pRenderer->SetDepthTest(false);
+
+        auto texture = std::make_shared<unicorn::video::Texture>();
+        auto atlas = std::make_shared<unicorn::video::Texture>();
+
+        if(!texture->Load("data/textures/texture.jpg") || !atlas->Load("data/textures/sprite.png"))
+        {
+            std::cerr << "Can't load textures" << std::endl;
+            return -1;
+        }
+
+        std::vector<Scene> scenes(3);
+
+        scenes[0].name = "colored";
+        scenes[0].material = std::make_shared<unicorn::video::Material>();
+        scenes[0].material->SetColor({ 0.2f, 0.4f, 0.8f });
+
+        scenes[1].name = "textured";
+        scenes[1].material = std::make_shared<unicorn::video::Material>();
+        scenes[1].material->SetAlbedo(texture);
+
+        scenes[2].name = "sprite";
+        scenes[2].material = std::make_shared<unicorn::video::Material>();
+        scenes[2].material->SetAlbedo(atlas);
+        scenes[2].material->SetSpriteArea(0, 0, atlas->Width() / 2, atlas->Height() / 2);
+
+        std::cout << s_imageWidth << "x" << s_imageHeight << ", " << layersCount << " layers, "
+                  << measuredFrames << " frames" << std::endl;
+        std::cout << std::setw(10) << "scene"
+                  << std::setw(16) << "branching, ms"
+                  << std::setw(18) << "specialized, ms"
+                  << std::setw(10) << "speedup"
+                  << std::endl;
+
+        for(Scene const& scene : scenes)
+        {
+            std::vector<unicorn::video::Mesh*> meshes = CreateLayers(scene);
+            pRenderer->AddMeshes(meshes);
+
+            double const branchingMs = MeasureFrames(*pRenderer, false);
+            double const specializedMs = MeasureFrames(*pRenderer, true);
+
+            std::cout << std::setw(10) << scene.name
+                      << std::setw(16) << std::fixed << std::setprecision(3) << branchingMs
+                      << std::setw(18) << specializedMs
+                      << std::setw(10) << std::setprecision(2) << branchingMs / specializedMs
+                      << std::endl;
+
+            pRenderer->DeleteMeshes(meshes);
+
+            for(auto* mesh : meshes)
+            {
+                delete mesh;
+            }
+        }
+
+        std::cout << pRenderer->GetFrameStats().pipelineCount << " pipelines created" << std::endl;
+    }
+
+    delete pCamera;
+
+    unicornRender->Deinit();
+    delete unicornRender;
+
+    unicorn::utility::Settings::Destroy();
+
+    return 0;
+}
@@ -0,0 +1,249 @@
+/*
+* Copyright (C) 2017 by Godlike
+* This code is licensed under the MIT license (MIT)
+* (http://opensource.org/licenses/MIT)
+*/
+
+#include <unicorn/UnicornRender.hpp>
+#include <unicorn/video/Graphics.hpp>
+#include <unicorn/system/Window.hpp>
+#include <unicorn/utility/Settings.hpp>
+#include <unicorn/video/Renderer.hpp>
+#include <unicorn/video/Primitives.hpp>
+#include <unicorn/video/Material.hpp>
+#include <unicorn/video/Camera.hpp>
+#include <unicorn/video/CameraFpsController.hpp>
+#include <unicorn/video/PerspectiveCamera.hpp>
+
+#include <mule/MuleUtilities.hpp>
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <list>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+//! Frames rendered after worker count change before measuring
+uint32_t const s_warmupFrames = 30;
+
+unicorn::system::Window* pWindow = nullptr;
+unicorn::video::Renderer* pRenderer = nullptr;
+
+//! Worker counts which are measured
+std::vector<uint32_t> workerCounts;
+
+//! Index of currently measured worker count
+size_t currentRun = 0;
+
+//! Frames rendered for current worker count
+uint32_t currentFrame = 0;
+
+//! Frames measured for every worker count
+uint32_t measuredFrames = 300;
+
+//! Accumulated recording time of current run
+std::chrono::nanoseconds recordingTime = std::chrono::nanoseconds::zero();
+
+//! Measured frames of current run which recorded draws
+uint32_t recordedFrames = 0;
+
+//! Recording time of the first run, used as a baseline
+double baselineMs = 0.0;
+
+void StartRun(size_t run)
+{
+    currentRun = run;
+    currentFrame = 0;
+    recordingTime = std::chrono::nanoseconds::zero();
+    recordedFrames = 0;
+
+    unicorn::utility::Settings::Instance().SetRecordingWorkers(workerCounts[run]);
+}
+
+void onLogicFrame(unicorn::UnicornRender* /*render*/)
+{
+    if(!pRenderer || currentRun >= workerCounts.size())
+    {
+        return;
+    }
+
+    ++currentFrame;
+
+    if(currentFrame <= s_warmupFrames)
+    {
+        return;
+    }
+
+    // Frames which reused recorded draws don't show recording cost
+    if(pRenderer->GetFrameStats().areDrawsRecorded)
+    {
+        recordingTime += pRenderer->GetFrameStats().recordingTime;
+        ++recordedFrames;
+    }
+
+    if(currentFrame < s_warmupFrames + measuredFrames)
+    {
+        return;
+    }
+
+    double const averageMs = recordedFrames > 0 ?
+        std::chrono::duration<double, std::milli>(recordingTime).count() / recordedFrames : 0.0;
+
+    if(currentRun == 0)
+    {
+        baselineMs = averageMs;
+    }
+
+    std::cout << std::setw(8) << workerCounts[currentRun]
+              << std::setw(10) << pRenderer->GetFrameStats().recordingWorkers
+              << std::setw(10) << pRenderer->GetFrameStats().drawCount
+              << std::setw(10) << recordedFrames
+              << std::setw(14) << std::fixed << std::setprecision(3) << averageMs
+              << std::setw(10) << std::setprecision(2) << (averageMs > 0.0 ? baselineMs / averageMs : 0.0)
+              << std::endl;
+
+    if(currentRun + 1 < workerCounts.size())
+    {
+        StartRun(currentRun + 1);
+    }
+    else
+    {
+        ++currentRun;
+        pWindow->SetShouldClose(true);
+    }
+}
+
+void onRendererDestroyed(unicorn::video::Renderer* pDestroyed)
+{
+    if(pRenderer == pDestroyed)
+    {
+        pRenderer = nullptr;
+    }
+}
+}
+
+/**
+ * @brief Measures how command recording time scales with amount of recording workers
+ *
+ * Usage: RecordingBenchmark [meshes count] [measured frames]
+ */
+int main(int argc, char* argv[])
+{
+    uint32_t meshesCount = 10000;
+
+    if(argc > 1)
+    {
+        meshesCount = static_cast<uint32_t>(std::max(std::atoi(argv[1]), 1));
+    }
+
+    if(argc > 2)
+    {
+        measuredFrames = static_cast<uint32_t>(std::max(std::atoi(argv[2]), 1));
+    }
+
+    uint32_t const hardwareThreads = std::max(std::thread::hardware_concurrency(), 1u);
+
+    for(uint32_t workers = 1; workers < hardwareThreads; workers *= 2)
+    {
+        workerCounts.push_back(workers);
+    }
+    workerCounts.push_back(hardwareThreads);
+
+    mule::MuleUtilities::Initialize();
+
+    unicorn::utility::Settings& settings = unicorn::utility::Settings::Instance();
+    settings.SetApplicationName("RECORDING BENCHMARK");
+    // Scene is static, so draws would be recorded only once otherwise
+    settings.SetRecordedDrawsReuse(false);
+
+    auto* unicornRender = new unicorn::UnicornRender;
+
+    unicorn::video::Camera* pCamera = nullptr;
+    unicorn::video::PerspectiveCamera* pProjection = nullptr;
+    unicorn::video::CameraFpsController* pCameraController = nullptr;
+    std::list<unicorn::video::Mesh*> meshes;
+
+    if(unicornRender->Init())
+    {
+        unicorn::video::Graphics* pGraphics = unicornRender->GetGraphics();
+
+        pWindow = pGraphics->SpawnWindow(settings.GetApplicationWidth(),
+                                         settings.GetApplicationHeight(),
+                                         settings.GetApplicationName(),
+                                         nullptr,
+                                         nullptr);
+
+        pCamera = new unicorn::video::Camera;
+
+        pRenderer = pGraphics->SpawnRenderer(pWindow, *pCamera);
+        if(pRenderer == nullptr)
+        {
+            return -1;
+        }
+        pRenderer->Destroyed.connect(&onRendererDestroyed);
+
+        pProjection = new unicorn::video::PerspectiveCamera(*pWindow, pCamera->projection);
+        pCameraController = new unicorn::video::CameraFpsController(pCamera->view);
+        pCameraController->TranslateWorld({ 0, 0, 60 });
+        pCameraController->Update();
+
+        std::vector<std::shared_ptr<unicorn::video::Material>> materials;
+        for(uint32_t i = 0; i < 8; ++i)
+        {
+            auto material = std::make_shared<unicorn::video::Material>();
+            material->SetColor({ static_cast<float>(std::rand() % 255) / 255, static_cast<float>(std::rand() % 255) / 255, static_cast<float>(std::rand() % 255) / 255 });
+            materials.push_back(material);
+        }
+
+        for(uint32_t i = 0; i < meshesCount; ++i)
+        {
+            unicorn::video::Mesh* mesh = new unicorn::video::Mesh;
+            unicorn::video::Primitives::Box(*mesh);
+            mesh->SetMaterial(materials[i % materials.size()]);
+            mesh->TranslateWorld({ std::rand() % 80 - 40, std::rand() % 80 - 40, std::rand() % 80 - 40 });
+            mesh->UpdateTransformMatrix();
+
+            pRenderer->AddMesh(mesh);
+            meshes.push_back(mesh);
+        }
+
+        std::cout << "Recording " << meshesCount << " meshes, " << measuredFrames << " frames per run" << std::endl;
+        std::cout << std::setw(8) << "workers"
+                  << std::setw(10) << "chunks"
+                  << std::setw(10) << "draws"
+                  << std::setw(10) << "recorded"
+                  << std::setw(14) << "record, ms"
+                  << std::setw(10) << "speedup"
+                  << std::endl;
+
+        StartRun(0);
+
+        unicornRender->LogicFrame.connect(&onLogicFrame);
+        unicornRender->Run();
+    }
+
+    delete pCameraController;
+    delete pProjection;
+    delete pCamera;
+
+    unicornRender->Deinit();
+    delete unicornRender;
+
+    for(auto* mesh : meshes)
+    {
+        delete mesh;
+    }
+
+    unicorn::utility::Settings::Destroy();
+
+    return 0;
+}
@@ -0,0 +1,228 @@
+/*
+* Copyright (C) 2017 by Godlike
+* This code is licensed under the MIT license (MIT)
+* (http://opensource.org/licenses/MIT)
+*/
+
+#include <unicorn/UnicornRender.hpp>
+#include <unicorn/video/Graphics.hpp>
+#include <unicorn/utility/Settings.hpp>
+#include <unicorn/video/Renderer.hpp>
+#include <unicorn/video/Primitives.hpp>
+#include <unicorn/video/Material.hpp>
+#include <unicorn/video/Camera.hpp>
+#include <unicorn/video/CameraFpsController.hpp>
+
+#include <mule/MuleUtilities.hpp>
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <vector>
+
+namespace
+{
+//! Size of rendered images
+uint32_t const s_imageSize = 256;
+
+//! Mesh counts which are measured
+std::vector<uint32_t> const s_meshCounts = { 100, 1000, 10000 };
+
+//! Repetitions of every measurement, the fastest one is reported
+uint32_t repetitions = 3;
+
+/**
+ * @brief Creates meshes with a few hundred distinct geometries
+ *
+ * Most meshes share geometry with others as in model libraries
+ */
+std::vector<unicorn::video::Mesh*> CreateMeshes(uint32_t count, std::vector<std::shared_ptr<unicorn::video::Material>> const& materials)
+{
+    std::vector<unicorn::video::Mesh*> meshes;
+    meshes.reserve(count);
+
+    for(uint32_t i = 0; i < count; ++i)
+    {
+        unicorn::video::Mesh* mesh = new unicorn::video::Mesh;
+        unicorn::video::Primitives::Sphere(*mesh, 1.0f, 4 + i % 16, 4 + (i / 16) % 16);
+        mesh->SetMaterial(materials[i % materials.size()]);
+        mesh->TranslateWorld({ std::rand() % 80 - 40, std::rand() % 80 - 40, std::rand() % 80 - 40 });
+        mesh->UpdateTransformMatrix();
+
+        meshes.push_back(mesh);
+    }
+
+    return meshes;
+}
+
+//! Returns duration of @p action together with the frame which follows it, in milliseconds
+double Measure(unicorn::video::Renderer& renderer, std::function<void()> const& action)
+{
+    auto const start = std::chrono::steady_clock::now();
+
+    action();
+    renderer.Render();
+
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+struct Timings
+{
+    double add = 0.0;
+    double remove = 0.0;
+};
+
+//! Adds and deletes meshes one by one
+Timings MeasureSingle(unicorn::video::Renderer& renderer, std::vector<unicorn::video::Mesh*> const& meshes)
+{
+    Timings timings;
+
+    timings.add = Measure(renderer, [&]()
+    {
+        for(auto* mesh : meshes)
+        {
+            renderer.AddMesh(mesh);
+        }
+    });
+
+    timings.remove = Measure(renderer, [&]()
+    {
+        for(auto* mesh : meshes)
+        {
+            renderer.DeleteMesh(mesh);
+        }
+    });
+
+    return timings;
+}
+
+//! Adds and deletes meshes with bulk calls
+Timings MeasureBulk(unicorn::video::Renderer& renderer, std::vector<unicorn::video::Mesh*> const& meshes)
+{
+    Timings timings;
+
+    timings.add = Measure(renderer, [&]() { renderer.AddMeshes(meshes); });
+    timings.remove = Measure(renderer, [&]() { renderer.DeleteMeshes(meshes); });
+
+    return timings;
+}
+
+Timings Fastest(Timings const& first, Timings const& second)
+{
+    Timings timings;
+    timings.add = std::min(first.add, second.add);
+    timings.remove = std::min(first.remove, second.remove);
+
+    return timings;
+}
+}
+
+/**
+ * @brief Compares registration of meshes one by one with bulk registration
+ *
+ * Every measurement includes the frame rendered right after registration,
+ * so deferred work like instance buffer resizing is accounted for
+ *
+ * Usage: RegistrationBenchmark [repetitions]
+ */
+int main(int argc, char* argv[])
+{
+    if(argc > 1)
+    {
+        repetitions = static_cast<uint32_t>(std::max(std::atoi(argv[1]), 1));
+    }
+
+    mule::MuleUtilities::Initialize();
+
+    unicorn::utility::Settings& settings = unicorn::utility::Settings::Instance();
+    settings.SetApplicationName("REGISTRATION BENCHMARK");
+    settings.SetHeadless(true);
+
+    auto* unicornRender = new unicorn::UnicornRender;
+
+    unicorn::video::Camera* pCamera = nullptr;
+    unicorn::video::CameraFpsController* pCameraController = nullptr;
+
+    if(unicornRender->Init())
+    {
+        unicorn::video::Graphics* pGraphics = unicornRender->GetGraphics();
+
+        pCamera = new unicorn::video::Camera;
+        pCameraController = new unicorn::video::CameraFpsController(pCamera->view);
+        pCameraController->TranslateWorld({ 0, 0, 60 });
+        pCameraController->Update();
+
+        unicorn::video::Renderer* pRenderer = pGraphics->SpawnHeadlessRenderer(s_imageSize, s_imageSize, *pCamera);
+        if(pRenderer == nullptr)
+        {
+            return -1;
+        }
+
+        std::vector<std::shared_ptr<unicorn::video::Material>> materials;
+        for(uint32_t i = 0; i < 8; ++i)
+        {
+            auto material = std::make_shared<unicorn::video::Material>();
+            material->SetColor({ static_cast<float>(std::rand() % 255) / 255, static_cast<float>(std::rand() % 255) / 255, static_cast<float>(std::rand() % 255) / 255 });
+            materials.push_back(material);
+        }
+
+        // Frames in flight are started before measuring
+        pRenderer->Render();
+
+        std::cout << "Best of " << repetitions << " runs, each time includes the following frame" << std::endl;
+        std::cout << std::setw(8) << "meshes"
+                  << std::setw(14) << "add, ms"
+                  << std::setw(14) << "bulk add, ms"
+                  << std::setw(10) << "speedup"
+                  << std::setw(14) << "delete, ms"
+                  << std::setw(16) << "bulk delete, ms"
+                  << std::setw(10) << "speedup"
+                  << std::endl;
+
+        for(uint32_t count : s_meshCounts)
+        {
+            std::vector<unicorn::video::Mesh*> meshes = CreateMeshes(count, materials);
+
+            Timings single;
+            Timings bulk;
+            single.add = single.remove = bulk.add = bulk.remove = std::numeric_limits<double>::max();
+
+            for(uint32_t i = 0; i < repetitions; ++i)
+            {
+                single = Fastest(single, MeasureSingle(*pRenderer, meshes));
+                bulk = Fastest(bulk, MeasureBulk(*pRenderer, meshes));
+            }
+
+            std::cout << std::setw(8) << count
+                      << std::setw(14) << std::fixed << std::setprecision(3) << single.add
+                      << std::setw(14) << bulk.add
+                      << std::setw(10) << std::setprecision(2) << single.add / bulk.add
+                      << std::setw(14) << std::setprecision(3) << single.remove
+                      << std::setw(16) << bulk.remove
+                      << std::setw(10) << std::setprecision(2) << single.remove / bulk.remove
+                      << std::endl;
+
+            for(auto* mesh : meshes)
+            {
+                delete mesh;
+            }
+        }
+    }
+
+    delete pCameraController;
+    delete pCamera;
+
+    unicornRender->Deinit();
+    delete unicornRender;
+
+    unicorn::utility::Settings::Destroy();
+
+    return 0;
+}
@@ -40,6 +40,7 @@
 #include <iostream>
 #include <list>
 #include <memory>
+#include <vector>
 
 static unicorn::video::Graphics* pGraphics = nullptr;
 static unicorn::system::Timer* timer = nullptr;
@@ -582,6 +583,7 @@ int main(int argc, char* argv[])
 
             spriteMaterial = std::make_shared<unicorn::video::Material>();
             spriteMaterial->SetAlbedo(spriteTexture);
+            spriteMaterial->SetIsTransparent(true);
 
             auto grassMaterial = std::make_shared<unicorn::video::Material>();
             grassMaterial->SetAlbedo(grassTexture);
@@ -615,10 +617,7 @@ int main(int argc, char* argv[])
                 meshes.push_back(grassQuad);
             }
 
-            for(auto mesh : meshes)
-            {
-                vkRenderer->AddMesh(mesh);
-            }
+            vkRenderer->AddMeshes(std::vector<unicorn::video::Mesh*>(meshes.begin(), meshes.end()));
 
             spriteMaterial->SetSpriteArea(32, 32, 32, 32);
 